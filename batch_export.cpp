@@ -0,0 +1,229 @@
+#include "batch_export.h"
+#include "code_document.h"
+#include "file_utils.h"
+#include "find_in_files.h"
+#include "work_pool.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct BatchExportItem {
+    std::string path;
+    std::string outputPath;
+    std::unique_ptr<CodeDocument> doc;
+    int width = 0;
+    int height = 0;
+};
+
+struct BatchExportContext {
+    const BatchExportOptions* options;
+    const BatchLayoutFn* layout;
+    const BatchRasterFn* rasterize;
+    WorkStealingPool* pool;
+
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    size_t inFlight = 0;
+
+    std::atomic<size_t> filesExported{ 0 };
+    std::atomic<size_t> filesSkipped{ 0 };
+    std::atomic<size_t> bytesRead{ 0 };
+    std::atomic<size_t> bytesWritten{ 0 };
+    std::atomic<int64_t> stageNanos[BatchStage_Count];
+    std::vector<std::string> failures;
+};
+
+static int64_t now_nanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* batch_stage_name(int stage) {
+    static const char* const names[BatchStage_Count] = { "load", "lex", "layout", "rasterize", "encode" };
+    return stage >= 0 && stage < BatchStage_Count ? names[stage] : "?";
+}
+
+static void finish_item(BatchExportContext& ctx, const BatchExportItem& item, const std::string& error) {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    if (!error.empty()) {
+        ctx.failures.push_back(item.path + ": " + error);
+    }
+    ctx.inFlight--;
+    ctx.slotFree.notify_one();
+}
+
+// Each stage runs as its own task. Continuations are submitted from the worker
+// that finished the previous stage, so they land on that worker's queue and a
+// file tends to flow through the pipeline on one thread while idle workers
+// steal whole files from the front of the other queues.
+static void encode_stage(BatchExportContext& ctx, std::shared_ptr<BatchExportItem> item) {
+    PROFILE_SCOPE("export");
+    const BatchExportOptions& options = *ctx.options;
+    int tile_height = std::min(item->height, options.maxTileHeight);
+    int64_t raster_nanos = 0;
+    CaptureTileRenderFn render_tile = [&](const CaptureTile& tile, std::vector<unsigned char>& rgba_out) {
+        int64_t t0 = now_nanos();
+        bool ok = (*ctx.rasterize)(*item->doc, tile, item->width, tile_height, rgba_out);
+        raster_nanos += now_nanos() - t0;
+        return ok;
+    };
+
+    std::string error;
+    int64_t t0 = now_nanos();
+    bool written = write_tiled_png(item->outputPath.c_str(), item->width, item->height, tile_height, render_tile, error, 1);
+    int64_t total = now_nanos() - t0;
+    ctx.stageNanos[BatchStage_Rasterize] += raster_nanos;
+    ctx.stageNanos[BatchStage_Encode] += total - raster_nanos;
+
+    if (written) {
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(item->outputPath, ec);
+        if (!ec) ctx.bytesWritten += (size_t)size;
+        ctx.filesExported++;
+    }
+    item->doc.reset();
+    finish_item(ctx, *item, written ? std::string() : error);
+}
+
+static void layout_stage(BatchExportContext& ctx, std::shared_ptr<BatchExportItem> item) {
+    int64_t t0 = now_nanos();
+    bool ok = (*ctx.layout)(*item->doc, item->width, item->height);
+    ctx.stageNanos[BatchStage_Layout] += now_nanos() - t0;
+    if (!ok || item->width <= 0 || item->height <= 0) {
+        finish_item(ctx, *item, "Calculated image size is invalid.");
+        return;
+    }
+    BatchExportContext* context = &ctx;
+    ctx.pool->submit([context, item](int) { encode_stage(*context, item); });
+}
+
+static void lex_stage(BatchExportContext& ctx, std::shared_ptr<BatchExportItem> item) {
+    int64_t t0 = now_nanos();
+    process_code(*item->doc);
+    lex_document(*item->doc);
+    ctx.stageNanos[BatchStage_Lex] += now_nanos() - t0;
+    BatchExportContext* context = &ctx;
+    ctx.pool->submit([context, item](int) { layout_stage(*context, item); });
+}
+
+static void load_stage(BatchExportContext& ctx, std::shared_ptr<BatchExportItem> item) {
+    int64_t t0 = now_nanos();
+    TextBufferPtr buffer;
+    std::string error;
+    bool loaded = load_file_buffer(item->path.c_str(), buffer, error);
+    ctx.stageNanos[BatchStage_Load] += now_nanos() - t0;
+    if (!loaded) {
+        finish_item(ctx, *item, error);
+        return;
+    }
+    if (is_probably_binary(buffer->data(), buffer->size())) {
+        ctx.filesSkipped++;
+        finish_item(ctx, *item, std::string());
+        return;
+    }
+    ctx.bytesRead += buffer->size();
+
+    std::string name = std::filesystem::path(item->path).filename().string();
+    item->doc.reset(new CodeDocument(item->path, name, std::move(buffer)));
+    item->doc->language = detect_lang(name);
+    item->doc->showComments = ctx.options->showComments;
+
+    BatchExportContext* context = &ctx;
+    ctx.pool->submit([context, item](int) { lex_stage(*context, item); });
+}
+
+bool run_batch_export(const BatchExportOptions& options, const BatchLayoutFn& layout, const BatchRasterFn& rasterize,
+    BatchExportStats& stats_out, std::string& error_out)
+{
+    namespace fs = std::filesystem;
+    stats_out = BatchExportStats();
+
+    std::error_code ec;
+    if (!fs::is_directory(options.inputDir, ec)) {
+        error_out = "Input directory not found: " + options.inputDir;
+        return false;
+    }
+    fs::create_directories(options.outputDir, ec);
+    if (!fs::is_directory(options.outputDir, ec)) {
+        error_out = "Cannot create output directory: " + options.outputDir;
+        return false;
+    }
+
+    int jobs = options.jobs > 0 ? options.jobs : (int)std::max(1u, std::thread::hardware_concurrency());
+    WorkStealingPool pool(jobs);
+
+    BatchExportContext ctx;
+    ctx.options = &options;
+    ctx.layout = &layout;
+    ctx.rasterize = &rasterize;
+    ctx.pool = &pool;
+    for (int s = 0; s < BatchStage_Count; ++s) ctx.stageNanos[s] = 0;
+
+    // Admission is bounded so that at most two files per worker hold their
+    // text, token runs and tile buffers at once, however large the tree is.
+    const size_t max_in_flight = (size_t)jobs * 2;
+    fs::path output_root = fs::absolute(options.outputDir, ec).lexically_normal();
+    int64_t start = now_nanos();
+
+    fs::recursive_directory_iterator it(options.inputDir, fs::directory_options::skip_permission_denied, ec);
+    for (fs::recursive_directory_iterator end; !ec && it != end; it.increment(ec)) {
+        const fs::directory_entry& entry = *it;
+        std::string name = entry.path().filename().string();
+        std::error_code type_ec;
+        if (entry.is_directory(type_ec)) {
+            bool inside_output = fs::absolute(entry.path(), type_ec).lexically_normal() == output_root;
+            if ((!name.empty() && name[0] == '.') || inside_output) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!entry.is_regular_file(type_ec) || detect_lang(name) < 0) continue;
+
+        stats_out.filesFound++;
+        std::error_code size_ec;
+        uintmax_t size = entry.file_size(size_ec);
+        if (size_ec || size == 0 || size > options.maxFileSize) {
+            ctx.filesSkipped++;
+            continue;
+        }
+
+        std::shared_ptr<BatchExportItem> item = std::make_shared<BatchExportItem>();
+        item->path = entry.path().string();
+        fs::path output_path = fs::path(options.outputDir) / entry.path().lexically_relative(options.inputDir);
+        output_path += ".png";
+        std::error_code dir_ec;
+        fs::create_directories(output_path.parent_path(), dir_ec);
+        item->outputPath = output_path.string();
+
+        {
+            std::unique_lock<std::mutex> lock(ctx.mutex);
+            ctx.slotFree.wait(lock, [&] { return ctx.inFlight < max_in_flight; });
+            ctx.inFlight++;
+        }
+        BatchExportContext* context = &ctx;
+        pool.submit([context, item](int) { load_stage(*context, item); });
+    }
+    pool.wait_idle();
+
+    stats_out.seconds = (double)(now_nanos() - start) * 1e-9;
+    stats_out.filesExported = ctx.filesExported;
+    stats_out.filesSkipped = ctx.filesSkipped;
+    stats_out.filesFailed = ctx.failures.size();
+    stats_out.bytesRead = ctx.bytesRead;
+    stats_out.bytesWritten = ctx.bytesWritten;
+    for (int s = 0; s < BatchStage_Count; ++s) {
+        stats_out.stageSeconds[s] = (double)ctx.stageNanos[s].load() * 1e-9;
+    }
+    stats_out.failures = std::move(ctx.failures);
+    if (ec) {
+        error_out = "Failed to walk " + options.inputDir + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "capture_tiles.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+struct CodeDocument;
+
+enum BatchStage {
+    BatchStage_Load = 0,
+    BatchStage_Lex,
+    BatchStage_Layout,
+    BatchStage_Rasterize,
+    BatchStage_Encode,
+    BatchStage_Count
+};
+
+struct BatchExportOptions {
+    std::string inputDir;
+    std::string outputDir;
+    bool showComments = true;
+    int jobs = 0;
+    size_t maxFileSize = 64 * 1024 * 1024;
+    int maxTileHeight = 1024;
+};
+
+struct BatchExportStats {
+    size_t filesFound = 0;
+    size_t filesExported = 0;
+    size_t filesSkipped = 0;
+    size_t filesFailed = 0;
+    size_t bytesRead = 0;
+    size_t bytesWritten = 0;
+    double seconds = 0.0;
+    double stageSeconds[BatchStage_Count] = {};
+    std::vector<std::string> failures;
+};
+
+typedef std::function<bool(const CodeDocument& doc, int& width_out, int& height_out)> BatchLayoutFn;
+typedef std::function<bool(const CodeDocument& doc, const CaptureTile& tile, int width, int tile_height,
+    std::vector<unsigned char>& rgba_out)> BatchRasterFn;
+
+const char* batch_stage_name(int stage);
+
+bool run_batch_export(const BatchExportOptions& options, const BatchLayoutFn& layout, const BatchRasterFn& rasterize,
+    BatchExportStats& stats_out, std::string& error_out);
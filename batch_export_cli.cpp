@@ -0,0 +1,144 @@
+#include "batch_export_cli.h"
+#include "batch_export.h"
+#include "code_layout.h"
+#include "code_render.h"
+#include "file_utils.h"
+#include "glyph_advance.h"
+#include "language_registry.h"
+#include "ui_style.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+static void print_export_usage() {
+    fprintf(stderr, "usage: CodeViewer --export <dir> --out <dir> [--jobs N] [--strip-comments]\n");
+}
+
+static int line_number_width(const CodeDocument& doc, const GlyphAdvanceTable& advances) {
+    char max_line_no_str[16];
+    snprintf(max_line_no_str, sizeof(max_line_no_str), "%d | ", max_line_number(doc));
+    return (int)advances.measure(max_line_no_str, max_line_no_str + strlen(max_line_no_str));
+}
+
+bool IsBatchExportCommand(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--export") == 0) return true;
+    }
+    return false;
+}
+
+int RunBatchExportCli(int argc, char** argv) {
+#ifdef _WIN32
+    // The app links as a GUI program; reuse the launching console for output.
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* stream = nullptr;
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+        freopen_s(&stream, "CONOUT$", "w", stderr);
+    }
+#endif
+
+    BatchExportOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            options.inputDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            options.outputDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            options.jobs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--strip-comments") == 0) {
+            options.showComments = false;
+        }
+        else {
+            print_export_usage();
+            return 2;
+        }
+    }
+    if (options.inputDir.empty() || options.outputDir.empty()) {
+        print_export_usage();
+        return 2;
+    }
+
+    // Headless context: the font atlas is built on the CPU and never uploaded,
+    // and a single frame is opened so draw lists get valid shared data.
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    ImFont* font = LoadCodeViewerFonts();
+    if (!font) {
+        fprintf(stderr, "warning: failed to load Fira Code font, using the default ImGui font\n");
+        font = io.Fonts->Fonts[0];
+    }
+    io.FontDefault = font;
+    ApplyCodeViewerStyle();
+    for (const std::string& error : languages().errors()) {
+        fprintf(stderr, "warning: %s\n", error.c_str());
+    }
+
+    unsigned char* atlas_pixels = nullptr;
+    int atlas_width = 0;
+    int atlas_height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&atlas_pixels, &atlas_width, &atlas_height);
+    io.Fonts->SetTexID((ImTextureID)(intptr_t)1);
+    io.DisplaySize = ImVec2((float)CAPTURE_MAX_WIDTH, (float)options.maxTileHeight);
+    io.DeltaTime = 1.0f / 60.0f;
+    ImGui::NewFrame();
+
+    static const SyntaxColors colors;
+    const float line_height = font->FontSize + ImGui::GetStyle().ItemSpacing.y;
+    const GlyphAdvanceTable& advances = font_advances(font, font->FontSize);
+
+    BatchLayoutFn layout = [&](const CodeDocument& doc, int& width_out, int& height_out) {
+        calculate_image_size(doc, advances, line_height, width_out, height_out, line_number_width(doc, advances));
+        width_out = std::min(width_out + CAPTURE_PADDING * 2, CAPTURE_MAX_WIDTH);
+        height_out += CAPTURE_PADDING * 2;
+        return true;
+    };
+    BatchRasterFn rasterize = [&](const CodeDocument& doc, const CaptureTile& tile, int width, int tile_height,
+        std::vector<unsigned char>& rgba_out)
+    {
+        return rasterize_code_tile(doc, colors, font, line_height, line_number_width(doc, advances),
+            (float)CAPTURE_PADDING, tile, width, tile_height, rgba_out, 1);
+    };
+
+    BatchExportStats stats;
+    std::string error;
+    bool ok = run_batch_export(options, layout, rasterize, stats, error);
+
+    ImGui::EndFrame();
+    ImGui::DestroyContext();
+
+    for (const std::string& failure : stats.failures) {
+        fprintf(stderr, "error: %s\n", failure.c_str());
+    }
+    if (!ok) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+    }
+
+    double mb_read = (double)stats.bytesRead / (1024.0 * 1024.0);
+    double mb_written = (double)stats.bytesWritten / (1024.0 * 1024.0);
+    printf("Exported %zu of %zu files (%zu skipped, %zu failed) in %.2f s\n",
+        stats.filesExported, stats.filesFound, stats.filesSkipped, stats.filesFailed, stats.seconds);
+    printf("%.1f files/s, %.2f MB/s source, %.1f MB of PNG written\n",
+        stats.seconds > 0.0 ? stats.filesExported / stats.seconds : 0.0,
+        stats.seconds > 0.0 ? mb_read / stats.seconds : 0.0, mb_written);
+    printf("stage time:");
+    for (int s = 0; s < BatchStage_Count; ++s) {
+        printf(" %s %.2f s", batch_stage_name(s), stats.stageSeconds[s]);
+    }
+    printf("\n");
+    return stats.filesFailed == 0 ? 0 : 1;
+}
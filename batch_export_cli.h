@@ -0,0 +1,4 @@
+#pragma once
+
+bool IsBatchExportCommand(int argc, char** argv);
+int RunBatchExportCli(int argc, char** argv);
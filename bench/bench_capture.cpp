@@ -0,0 +1,102 @@
+#include "bench_common.h"
+#include "capture_tiles.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+#ifdef CODEVIEWER_BENCH_HAS_STB
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+#endif
+
+static void render_software_tile(const CaptureTile& tile, int width, int tile_height, float line_height, std::vector<unsigned char>& rgba_out) {
+    rgba_out.resize((size_t)width * tile_height * 4);
+    for (int row = 0; row < tile.height; ++row) {
+        int y = tile.y + row;
+        int line = (int)(y / line_height);
+        bool glyph_row = (y - line * line_height) < line_height * 0.7f;
+        int line_length = 40 + (line * 37) % 700;
+        unsigned char* dst = rgba_out.data() + (size_t)row * width * 4;
+        for (int x = 0; x < width; ++x) {
+            bool ink = glyph_row && x >= 10 && x < 10 + line_length && ((x / 3 + line) % 4 != 0);
+            dst[x * 4 + 0] = ink ? (unsigned char)(120 + line % 100) : 28;
+            dst[x * 4 + 1] = ink ? (unsigned char)(200 - (x / 50) % 60) : 31;
+            dst[x * 4 + 2] = ink ? 220 : 33;
+            dst[x * 4 + 3] = 255;
+        }
+    }
+}
+
+static void report_capture(const char* name, double seconds, size_t raw_bytes, size_t png_bytes, const std::string& detail) {
+    char extra[192];
+    snprintf(extra, sizeof(extra), "png_bytes=%zu peak_rss=%zuMB %s", png_bytes, bench_peak_rss_bytes() / (1024 * 1024), detail.c_str());
+    bench_report(name, seconds, raw_bytes, extra);
+}
+
+int run_capture_bench(size_t corpus_bytes) {
+    const int width = 4096;
+    const float line_height = 17.0f;
+    const int tile_height = 8192;
+    int height = (int)std::min(std::max(corpus_bytes / (1024 * 1024) * 300, (size_t)3000), (size_t)30000);
+    size_t raw_bytes = (size_t)width * height * 4;
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "codeviewer_bench_capture.png";
+    std::error_code ec;
+    int failures = 0;
+    printf("capture: %dx%d RGBA, %d-row tiles\n", width, height, tile_height);
+
+    int max_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    const int thread_counts[] = { 1, max_threads };
+    for (int t = 0; t < 2; ++t) {
+        if (t == 1 && max_threads == 1) break;
+        CaptureTileRenderFn render_tile = [&](const CaptureTile& tile, std::vector<unsigned char>& rgba_out) {
+            render_software_tile(tile, width, tile_height, line_height, rgba_out);
+            return true;
+        };
+
+        std::string error;
+        double t0 = bench_now_seconds();
+        bool ok = write_tiled_png(path.string().c_str(), width, height, tile_height, render_tile, error, thread_counts[t]);
+        double t1 = bench_now_seconds();
+        if (!ok) {
+            printf("  capture failed: %s\n", error.c_str());
+            failures++;
+            continue;
+        }
+
+        char name[64];
+        char detail[64];
+        snprintf(name, sizeof(name), "capture/streaming/t%d", thread_counts[t]);
+        snprintf(detail, sizeof(detail), "tile_bytes=%zu", (size_t)width * tile_height * 4);
+        report_capture(name, t1 - t0, raw_bytes, (size_t)std::filesystem::file_size(path, ec), detail);
+    }
+
+#ifdef CODEVIEWER_BENCH_HAS_STB
+    {
+        double t0 = bench_now_seconds();
+        std::vector<unsigned char> pixels(raw_bytes);
+        std::vector<unsigned char> tile_pixels;
+        for (const CaptureTile& tile : plan_capture_tiles(height, tile_height)) {
+            render_software_tile(tile, width, tile_height, line_height, tile_pixels);
+            memcpy(pixels.data() + (size_t)tile.y * width * 4, tile_pixels.data(), (size_t)tile.height * width * 4);
+        }
+        std::vector<unsigned char>().swap(tile_pixels);
+        int ok = stbi_write_png(path.string().c_str(), width, height, 4, pixels.data(), width * 4);
+        double t1 = bench_now_seconds();
+        if (!ok) {
+            printf("  stbi_write_png failed\n");
+            failures++;
+        }
+        else {
+            report_capture("capture/stbi_write_png", t1 - t0, raw_bytes, (size_t)std::filesystem::file_size(path, ec), "full_buffer");
+        }
+    }
+#else
+    printf("  stbi_write_png comparison skipped: configure with STB_DIR pointing at stb\n");
+#endif
+
+    std::filesystem::remove(path, ec);
+    return failures == 0 ? 0 : 1;
+}
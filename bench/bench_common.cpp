@@ -0,0 +1,270 @@
+#include "bench_common.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <random>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static const char* const s_corpus_lines[] = {
+    "#include <vector>\n",
+    "int main(int argc, char** argv) {\n",
+    "    for (int i = 0; i < count; ++i) {\n",
+    "        total += values[i] * 0.5f; // accumulate\n",
+    "    }\n",
+    "    /* TODO(perf): avoid the extra copy here */\n",
+    "    return Result::Ok;\n",
+    "}\n",
+    "static const char* kName = \"CodeViewer\";\n",
+    "    if (doc.searchState.active && !doc.searchState.matchPositions.empty()) {\n",
+    "        std::string line = text.substr(offset, length);\n",
+    "\n",
+};
+
+static const char* const s_python_lines[] = {
+    "import os\n",
+    "def load(path, mode='r'):\n",
+    "    \"\"\"Read the whole file and return its lines.\"\"\"\n",
+    "    with open(path, mode) as handle:\n",
+    "        return [line.rstrip() for line in handle]  # strip newlines\n",
+    "class Result(object):\n",
+    "    total = sum(value * 0.5 for value in values)\n",
+    "    if self.active and not self.matches:\n",
+    "        raise ValueError(\"no matches for %s\" % query)\n",
+    "# TODO(perf): avoid the extra copy here\n",
+    "\n",
+};
+
+static const char* const s_js_lines[] = {
+    "import { render } from './view.js';\n",
+    "function main(argc, argv) {\n",
+    "    for (let i = 0; i < count; ++i) {\n",
+    "        total += values[i] * 0.5; // accumulate\n",
+    "    }\n",
+    "    /* TODO(perf): avoid the extra copy here */\n",
+    "    const name = `CodeViewer ${version}`;\n",
+    "    if (state.active && state.matches.length > 0) {\n",
+    "        return items.filter((item) => item.visible).map(String);\n",
+    "}\n",
+    "\n",
+};
+
+static const char* const s_css_lines[] = {
+    "/* Layout for the editor panes */\n",
+    ".code-view, .code-view pre {\n",
+    "    font-family: \"Consolas\", monospace;\n",
+    "    margin: 0 auto;\n",
+    "    padding: 4px 8px 4px 8px;\n",
+    "    color: #d4d4d4;\n",
+    "    background: rgba(30, 30, 30, 0.95);\n",
+    "}\n",
+    "@media (max-width: 800px) {\n",
+    "#toolbar > .button:hover { border-bottom: 1px solid #569cd6; }\n",
+    "\n",
+};
+
+// Statements joined without newlines, like bundler output.
+static const char* const s_minified_js_tokens[] = {
+    "function a(b,c){return b+c}",
+    "var d=document.getElementById(\"e\");",
+    "for(var f=0;f<g.length;f++){h+=g[f]*.5}",
+    "if(i&&!j.k){l.push(m)}else{n=null}",
+    "/*!license*/",
+    "o.p=function(q){return q.filter(function(r){return r.s})};",
+    "t=\"u\\\"v\";",
+    "w=/x+y/g.test(z);",
+};
+
+static const char* const s_long_comment_lines[] = {
+    " * Long documentation comments dominate this file, so comment stripping\n",
+    " * and the lexer's multi-line comment state do most of the work here.\n",
+    " *\n",
+    "// A single line comment that goes on for a while to mimic license headers and\n",
+    "int value = compute(argc, argv); // trailing remark\n",
+};
+
+struct CorpusLines {
+    const char* const* lines;
+    size_t count;
+};
+
+static CorpusLines corpus_lines(int kind) {
+    switch (kind) {
+    case Corpus_Python: return { s_python_lines, sizeof(s_python_lines) / sizeof(s_python_lines[0]) };
+    case Corpus_Js: return { s_js_lines, sizeof(s_js_lines) / sizeof(s_js_lines[0]) };
+    case Corpus_Css: return { s_css_lines, sizeof(s_css_lines) / sizeof(s_css_lines[0]) };
+    case Corpus_MinifiedJs: return { s_minified_js_tokens, sizeof(s_minified_js_tokens) / sizeof(s_minified_js_tokens[0]) };
+    case Corpus_LongComment: return { s_long_comment_lines, sizeof(s_long_comment_lines) / sizeof(s_long_comment_lines[0]) };
+    default: return { s_corpus_lines, sizeof(s_corpus_lines) / sizeof(s_corpus_lines[0]) };
+    }
+}
+
+std::string make_code_corpus(size_t bytes, uint32_t seed) {
+    return make_corpus(Corpus_Cpp, bytes, seed);
+}
+
+// Corpora are a seeded mix of representative lines, so a given kind, size
+// and seed always produce the same text on every platform.
+std::string make_corpus(int kind, size_t bytes, uint32_t seed) {
+    std::mt19937 rng(seed);
+    CorpusLines table = corpus_lines(kind);
+    std::string out;
+    out.reserve(bytes + 256);
+    while (out.size() < bytes) {
+        if (kind == Corpus_LongComment) {
+            // Block comments of a few hundred lines separated by a little code.
+            out += "/*\n";
+            uint32_t comment_lines = 100 + rng() % 400;
+            for (uint32_t i = 0; i < comment_lines && out.size() < bytes; ++i) {
+                out += table.lines[rng() % 4];
+            }
+            out += " */\n";
+            out += table.lines[4];
+            continue;
+        }
+        out += table.lines[rng() % table.count];
+    }
+    out.resize(bytes);
+    return out;
+}
+
+const char* corpus_kind_name(int kind) {
+    switch (kind) {
+    case Corpus_Cpp: return "cpp";
+    case Corpus_Python: return "python";
+    case Corpus_Js: return "js";
+    case Corpus_Css: return "css";
+    case Corpus_MinifiedJs: return "minified_js";
+    case Corpus_LongComment: return "long_comment";
+    default: return "unknown";
+    }
+}
+
+const char* corpus_file_name(int kind) {
+    switch (kind) {
+    case Corpus_Python: return "corpus.py";
+    case Corpus_Js: return "corpus.js";
+    case Corpus_Css: return "corpus.css";
+    case Corpus_MinifiedJs: return "corpus.min.js";
+    default: return "corpus.cpp";
+    }
+}
+
+bool write_corpus_tree(const std::filesystem::path& root, size_t total_bytes, int file_count) {
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    size_t per_file = std::max((size_t)1, total_bytes / file_count);
+    for (int i = 0; i < file_count; ++i) {
+        std::filesystem::path dir = root / ("dir" + std::to_string(i % 16));
+        std::filesystem::create_directories(dir, ec);
+        std::ofstream out(dir / ("file" + std::to_string(i) + ".cpp"), std::ios::binary);
+        std::string text = make_code_corpus(per_file, 1000 + i);
+        out.write(text.data(), (std::streamsize)text.size());
+        if (!out) return false;
+    }
+    return true;
+}
+
+static FILE* s_json_output = nullptr;
+
+bool bench_open_json_output(const char* path) {
+    s_json_output = fopen(path, "w");
+    return s_json_output != nullptr;
+}
+
+static void write_json_string(FILE* file, const std::string& text) {
+    fputc('"', file);
+    for (char c : text) {
+        if (c == '"' || c == '\\') fputc('\\', file);
+        if ((unsigned char)c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned char)c);
+            continue;
+        }
+        fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+void bench_report(const char* name, double seconds, size_t bytes, const std::string& extra, double allocations) {
+    double mb = (double)bytes / (1024.0 * 1024.0);
+    double mb_per_second = seconds > 0.0 ? mb / seconds : 0.0;
+    std::string allocs;
+    if (allocations >= 0.0) {
+        char text[64];
+        snprintf(text, sizeof(text), "allocs/MB=%.1f ", mb > 0.0 ? allocations / mb : allocations);
+        allocs = text;
+    }
+    printf("%-40s %10.2f ms %10.1f MB/s  %s%s\n", name, seconds * 1000.0, mb_per_second, allocs.c_str(), extra.c_str());
+
+    if (!s_json_output) return;
+    fputs("{\"name\":", s_json_output);
+    write_json_string(s_json_output, name);
+    fprintf(s_json_output, ",\"seconds\":%.9f,\"bytes\":%zu,\"mb_per_s\":%.3f", seconds, bytes, mb_per_second);
+    if (allocations >= 0.0) {
+        fprintf(s_json_output, ",\"allocations\":%.1f,\"allocs_per_mb\":%.3f", allocations, mb > 0.0 ? allocations / mb : 0.0);
+    }
+    fprintf(s_json_output, ",\"peak_rss_bytes\":%zu,\"extra\":", bench_peak_rss_bytes());
+    write_json_string(s_json_output, extra);
+    fputs("}\n", s_json_output);
+    fflush(s_json_output);
+}
+
+size_t bench_peak_rss_bytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return (size_t)counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// Counting replacement for the global allocator, so suites can report heap
+// allocations per MB of input alongside throughput.
+static std::atomic<size_t> s_allocation_count{ 0 };
+
+size_t bench_allocation_count() {
+    return s_allocation_count.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+    s_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
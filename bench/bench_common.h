@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+inline double bench_now_seconds() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+enum BenchCorpusKind {
+    Corpus_Cpp,
+    Corpus_Python,
+    Corpus_Js,
+    Corpus_Css,
+    Corpus_MinifiedJs,
+    Corpus_LongComment,
+    Corpus_Count
+};
+
+std::string make_code_corpus(size_t bytes, uint32_t seed);
+std::string make_corpus(int kind, size_t bytes, uint32_t seed);
+const char* corpus_kind_name(int kind);
+const char* corpus_file_name(int kind);
+bool write_corpus_tree(const std::filesystem::path& root, size_t total_bytes, int file_count);
+
+size_t bench_peak_rss_bytes();
+// Number of global operator new calls so far; bench code takes deltas.
+size_t bench_allocation_count();
+
+// Also writes each report as one JSON object per line to `path`, so runs of
+// different commits can be diffed; the console output is unchanged.
+bool bench_open_json_output(const char* path);
+void bench_report(const char* name, double seconds, size_t bytes, const std::string& extra = "", double allocations = -1.0);
+
+int run_search_bench(size_t corpus_bytes);
+int run_regex_bench(size_t corpus_bytes);
+int run_find_in_files_bench(size_t corpus_bytes);
+int run_measure_bench(size_t corpus_bytes);
+int run_capture_bench(size_t corpus_bytes);
+int run_raster_bench(size_t corpus_bytes);
+int run_export_bench(size_t corpus_bytes);
+int run_svg_bench(size_t corpus_bytes);
+int run_strip_bench(size_t corpus_bytes);
+int run_edit_bench(size_t corpus_bytes);
+int run_reload_bench(size_t corpus_bytes);
+int run_profiler_bench(size_t corpus_bytes);
+int run_hotpath_bench(size_t corpus_bytes);
+int run_scheduler_bench(size_t corpus_bytes);
+int run_keyword_bench(size_t corpus_bytes);
+int run_language_bench(size_t corpus_bytes);
@@ -0,0 +1,101 @@
+#include "bench_common.h"
+#include "code_document.h"
+#include "code_lexer.h"
+#include "document_edit.h"
+#include "file_utils.h"
+#include "piece_table.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+int run_edit_bench(size_t corpus_bytes) {
+    std::string corpus = make_code_corpus(corpus_bytes, 13);
+    CodeDocument doc("bench.cpp", "bench.cpp", make_text_buffer(corpus));
+    doc.language = detect_lang(doc.fileName);
+    process_code(doc);
+    int lines = document_line_count(doc);
+    printf("edit: %zu bytes, %d lines\n", corpus.size(), lines);
+
+    const int visible_lines = 60;
+    int cursor_line = lines / 2;
+    size_t cursor = line_start_offset(doc, cursor_line);
+    ensure_lexed(doc, cursor_line + visible_lines);
+
+    double t0 = bench_now_seconds();
+    insert_text(doc, cursor, "/");
+    double t1 = bench_now_seconds();
+    bench_report("edit/first_edit", t1 - t0, corpus.size(), "builds the piece table");
+    cursor++;
+
+    // Typing: each keystroke inserts a character, re-lexes the visible window
+    // and fetches its lines the way a frame would.
+    const char* typed = "    value = compute(value, 42); // typed\n";
+    const int keystrokes = 20000;
+    std::string scratch;
+    double worst = 0.0;
+    double start = bench_now_seconds();
+    for (int i = 0; i < keystrokes; ++i) {
+        double k0 = bench_now_seconds();
+        char c = typed[i % strlen(typed)];
+        insert_text(doc, cursor++, std::string_view(&c, 1));
+        int line = line_from_offset(doc, cursor);
+        ensure_lexed(doc, line + visible_lines);
+        for (int l = std::max(0, line - visible_lines / 2); l < line + visible_lines / 2; ++l) {
+            line_text(doc, l, scratch);
+        }
+        worst = std::max(worst, bench_now_seconds() - k0);
+    }
+    double typing = bench_now_seconds() - start;
+    char extra[128];
+    snprintf(extra, sizeof(extra), "%d keystrokes avg=%.2fus max=%.2fus pieces=%zu", keystrokes,
+        typing / keystrokes * 1e6, worst * 1e6, doc.pieces->piece_count());
+    bench_report("edit/typing", typing, 0, extra);
+
+    std::mt19937 rng(17);
+    const int random_edits = 20000;
+    start = bench_now_seconds();
+    for (int i = 0; i < random_edits; ++i) {
+        size_t offset = rng() % doc.pieces->size();
+        if (i % 2) erase_text(doc, offset, 1 + rng() % 16);
+        else insert_text(doc, offset, "edit\n");
+    }
+    double random_time = bench_now_seconds() - start;
+    snprintf(extra, sizeof(extra), "%d edits avg=%.2fus pieces=%zu", random_edits, random_time / random_edits * 1e6, doc.pieces->piece_count());
+    bench_report("edit/random_edits", random_time, 0, extra);
+
+    const int lookups = 200000;
+    int line_total = document_line_count(doc);
+    size_t checksum = 0;
+    start = bench_now_seconds();
+    for (int i = 0; i < lookups; ++i) {
+        checksum += line_start_offset(doc, (int)(rng() % line_total));
+    }
+    double lookup_time = bench_now_seconds() - start;
+    snprintf(extra, sizeof(extra), "%d lookups avg=%.3fus (checksum %zu)", lookups, lookup_time / lookups * 1e6, checksum % 10);
+    bench_report("edit/line_start", lookup_time, 0, extra);
+
+    // The flat model pays a full copy and line re-index per keystroke.
+    const int flat_keystrokes = 10;
+    std::string flat = corpus;
+    std::vector<size_t> offsets;
+    size_t flat_cursor = flat.size() / 2;
+    start = bench_now_seconds();
+    for (int i = 0; i < flat_keystrokes; ++i) {
+        std::string next;
+        next.reserve(flat.size() + 1);
+        next.append(flat, 0, flat_cursor).append(1, 'x').append(flat, flat_cursor, std::string::npos);
+        flat.swap(next);
+        offsets.assign(1, 0);
+        for (size_t p = flat.find('\n'); p != std::string::npos; p = flat.find('\n', p + 1)) offsets.push_back(p + 1);
+        flat_cursor++;
+    }
+    double flat_time = bench_now_seconds() - start;
+    snprintf(extra, sizeof(extra), "%d keystrokes avg=%.2fus", flat_keystrokes, flat_time / flat_keystrokes * 1e6);
+    bench_report("edit/flat_copy_baseline", flat_time, 0, extra);
+
+    start = bench_now_seconds();
+    process_code(doc);
+    bench_report("edit/flatten", bench_now_seconds() - start, doc.content.size());
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "bench_common.h"
+#include "batch_export.h"
+#include "code_document.h"
+#include "code_layout.h"
+#include "file_utils.h"
+#include "glyph_advance.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+// Stand-in for the ImGui layout and rasterize stages: a fixed-pitch advance
+// table for sizing and a flat fill of each line's extent for pixels, so the
+// bench measures the pipeline, lexer and PNG encoder without a font atlas.
+int run_export_bench(size_t corpus_bytes) {
+    const float line_height = 17.0f;
+    const int padding = 10;
+    const int line_num_width = 56;
+    size_t source_bytes = std::min(corpus_bytes, (size_t)1024 * 1024);
+
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "codeviewer_bench_export";
+    std::filesystem::path input = root / "src";
+    std::filesystem::path output = root / "out";
+    if (!write_corpus_tree(input, source_bytes, 128)) {
+        printf("failed to write corpus tree under %s\n", input.string().c_str());
+        return 1;
+    }
+
+    GlyphAdvanceTable advances;
+    advances.build([](unsigned int c) { return c == '\t' ? 28.0f : 7.0f; });
+
+    BatchLayoutFn layout = [&](const CodeDocument& doc, int& width_out, int& height_out) {
+        calculate_image_size(doc, advances, line_height, width_out, height_out, line_num_width);
+        width_out = std::min(width_out + padding * 2, 8192);
+        height_out += padding * 2;
+        return true;
+    };
+    BatchRasterFn rasterize = [&](const CodeDocument& doc, const CaptureTile& tile, int width, int tile_height,
+        std::vector<unsigned char>& rgba_out)
+    {
+        rgba_out.resize((size_t)width * tile_height * 4);
+        int line_count = document_line_count(doc);
+        std::string scratch;
+        for (int row = 0; row < tile.height; ++row) {
+            int line = (int)((tile.y + row - padding) / line_height);
+            int extent = 0;
+            if (line >= 0 && line < line_count) {
+                std::string_view text = line_text(doc, line, scratch);
+                extent = padding + line_num_width + (int)advances.measure(text.data(), text.data() + text.size());
+            }
+            unsigned char* dst = rgba_out.data() + (size_t)row * width * 4;
+            for (int x = 0; x < width; ++x) {
+                bool ink = x >= padding && x < extent && (x / 3 + line) % 4 != 0;
+                dst[x * 4 + 0] = ink ? 212 : 28;
+                dst[x * 4 + 1] = ink ? 212 : 31;
+                dst[x * 4 + 2] = ink ? 170 : 33;
+                dst[x * 4 + 3] = 255;
+            }
+        }
+        return true;
+    };
+
+    int max_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    printf("export: %zu source bytes in 128 files, up to %d jobs\n", source_bytes, max_threads);
+
+    int failures = 0;
+    std::vector<int> job_counts = { 1 };
+    if (max_threads > 1) job_counts.push_back(max_threads);
+    for (int jobs : job_counts) {
+        std::error_code ec;
+        std::filesystem::remove_all(output, ec);
+
+        BatchExportOptions options;
+        options.inputDir = input.string();
+        options.outputDir = output.string();
+        options.jobs = jobs;
+
+        BatchExportStats stats;
+        std::string error;
+        if (!run_batch_export(options, layout, rasterize, stats, error) || stats.filesFailed != 0 || stats.filesExported != 128) {
+            printf("  export failed: %s (%zu exported, %zu failed)\n", error.c_str(), stats.filesExported, stats.filesFailed);
+            failures++;
+            continue;
+        }
+
+        char name[64];
+        char extra[256];
+        snprintf(name, sizeof(name), "export/jobs=%d", jobs);
+        int len = snprintf(extra, sizeof(extra), "%.1f files/s png_bytes=%zu",
+            stats.seconds > 0.0 ? stats.filesExported / stats.seconds : 0.0, stats.bytesWritten);
+        for (int s = 0; s < BatchStage_Count && len < (int)sizeof(extra); ++s) {
+            len += snprintf(extra + len, sizeof(extra) - len, " %s=%.0fms", batch_stage_name(s), stats.stageSeconds[s] * 1000.0);
+        }
+        bench_report(name, stats.seconds, stats.bytesRead, extra);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    return failures == 0 ? 0 : 1;
+}
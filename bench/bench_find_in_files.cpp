@@ -0,0 +1,86 @@
+#include "bench_common.h"
+#include "find_in_files.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+static bool run_once(const std::string& root, const char* query, bool use_regex, int threads,
+    double& seconds_out, size_t& bytes_out, size_t& matches_out)
+{
+    FindInFilesOptions options;
+    options.query = query;
+    options.useRegex = use_regex;
+    options.directory = root;
+    options.threadCount = threads;
+
+    std::string error;
+    double t0 = bench_now_seconds();
+    std::shared_ptr<FindInFilesJob> job = start_find_in_files(options, error);
+    if (!job) {
+        printf("  find in files failed: %s\n", error.c_str());
+        return false;
+    }
+    job->coordinator.join();
+    seconds_out = bench_now_seconds() - t0;
+    bytes_out = job->bytesSearched;
+    matches_out = job->matchesFound;
+    return true;
+}
+
+int run_find_in_files_bench(size_t corpus_bytes) {
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "codeviewer_bench_find_in_files";
+    if (!write_corpus_tree(root, corpus_bytes, 512)) {
+        printf("failed to write corpus tree under %s\n", root.string().c_str());
+        return 1;
+    }
+
+    int max_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    printf("find in files: %zu bytes in 512 files, up to %d threads\n", corpus_bytes, max_threads);
+
+    struct Query { const char* text; bool regex; };
+    const Query queries[] = {
+        { "matchPositions", false },
+        { "TODO\\(\\w+\\)", true },
+    };
+
+    int failures = 0;
+    for (const Query& q : queries) {
+        double warm_seconds;
+        size_t bytes, expected_matches;
+        if (!run_once(root.string(), q.text, q.regex, 1, warm_seconds, bytes, expected_matches)) {
+            failures++;
+            continue;
+        }
+
+        double single_seconds = 0.0;
+        std::vector<int> thread_counts;
+        for (int threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+        thread_counts.push_back(max_threads);
+
+        for (int threads : thread_counts) {
+            double seconds;
+            size_t matches;
+            if (!run_once(root.string(), q.text, q.regex, threads, seconds, bytes, matches)) {
+                failures++;
+                break;
+            }
+            if (threads == 1) single_seconds = seconds;
+
+            char name[128];
+            char extra[64];
+            snprintf(name, sizeof(name), "find_in_files/%s/t%d", q.text, threads);
+            snprintf(extra, sizeof(extra), "matches=%zu speedup=%.2fx", matches, single_seconds / seconds);
+            bench_report(name, seconds, bytes, extra);
+            if (matches != expected_matches) {
+                printf("  MISMATCH: %zu matches with %d threads, %zu with 1\n", matches, threads, expected_matches);
+                failures++;
+            }
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    return failures == 0 ? 0 : 1;
+}
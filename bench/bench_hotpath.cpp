@@ -0,0 +1,109 @@
+#include "bench_common.h"
+#include "code_document.h"
+#include "code_layout.h"
+#include "code_lexer.h"
+#include "code_search.h"
+#include "file_utils.h"
+#include "glyph_advance.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// The per-document text paths every open, toggle and capture goes through,
+// run over each synthetic corpus at sizes from 1 KB up to the requested size.
+// Small inputs are repeated so each row times at least a few MB of work.
+
+static const char* const s_corpus_queries[Corpus_Count] = {
+    "values", "return", "values", "border", "return", "comment",
+};
+
+static std::string format_size(size_t bytes) {
+    char text[32];
+    if (bytes % (1 << 30) == 0) snprintf(text, sizeof(text), "%zuG", bytes >> 30);
+    else if (bytes % (1 << 20) == 0) snprintf(text, sizeof(text), "%zuM", bytes >> 20);
+    else if (bytes % (1 << 10) == 0) snprintf(text, sizeof(text), "%zuK", bytes >> 10);
+    else snprintf(text, sizeof(text), "%zu", bytes);
+    return text;
+}
+
+static std::vector<size_t> size_ladder(size_t max_bytes) {
+    std::vector<size_t> sizes;
+    for (size_t size = 1 << 10; size < max_bytes; size *= 32) sizes.push_back(size);
+    sizes.push_back(max_bytes);
+    return sizes;
+}
+
+template <typename Fn>
+static void report_op(const std::string& prefix, const char* op, size_t bytes, int reps, Fn&& fn) {
+    size_t allocs0 = bench_allocation_count();
+    double t0 = bench_now_seconds();
+    for (int i = 0; i < reps; ++i) fn();
+    double t1 = bench_now_seconds();
+    size_t allocs1 = bench_allocation_count();
+    std::string name = prefix + op;
+    bench_report(name.c_str(), (t1 - t0) / reps, bytes, "", (double)(allocs1 - allocs0) / reps);
+}
+
+static void run_detect_lang() {
+    const char* names[] = {
+        "main.cpp", "code_editor.H", "setup.py", "index.html", "site.min.css",
+        "bundle.js", "README", "archive.tar.gz", "module.hxx", "tool.pyw",
+    };
+    const int calls = 1000000;
+    std::vector<std::string> paths(names, names + sizeof(names) / sizeof(names[0]));
+    int checksum = 0;
+    size_t allocs0 = bench_allocation_count();
+    double t0 = bench_now_seconds();
+    for (int i = 0; i < calls; ++i) checksum += detect_lang(paths[i % paths.size()]);
+    double t1 = bench_now_seconds();
+    size_t allocs1 = bench_allocation_count();
+    char extra[96];
+    snprintf(extra, sizeof(extra), "%.1f ns/call allocs/call=%.2f checksum=%d", (t1 - t0) * 1e9 / calls,
+        (double)(allocs1 - allocs0) / calls, checksum);
+    bench_report("hotpaths/detect_lang", t1 - t0, 0, extra);
+}
+
+int run_hotpath_bench(size_t corpus_bytes) {
+    GlyphAdvanceTable advances;
+    advances.build([](unsigned int c) { return c == '\t' ? 28.0f : 7.0f; });
+
+    run_detect_lang();
+    for (int kind = 0; kind < Corpus_Count; ++kind) {
+        for (size_t size : size_ladder(corpus_bytes)) {
+            std::string text = make_corpus(kind, size, 4000 + kind);
+            std::string file_name = corpus_file_name(kind);
+            int lang = detect_lang(file_name);
+            int reps = (int)std::max((size_t)1, std::min((size_t)2000, ((size_t)4 << 20) / size));
+            std::string prefix = std::string("hotpaths/") + corpus_kind_name(kind) + "/" + format_size(size) + "/";
+
+            std::string stripped;
+            report_op(prefix, "strip_comments", size, reps, [&]() { strip_comments(text, lang, stripped); });
+
+            CodeDocument doc(file_name, file_name, make_text_buffer(std::move(text)));
+            doc.language = lang;
+            process_code(doc);
+
+            report_op(prefix, "lex", size, reps, [&]() {
+                reset_lexer(doc);
+                lex_document(doc);
+            });
+
+            int width = 0;
+            int height = 0;
+            report_op(prefix, "layout", size, reps, [&]() {
+                calculate_image_size(doc, advances, 16.0f, width, height, 48);
+            });
+
+            strcpy(doc.searchState.query, s_corpus_queries[kind]);
+            report_op(prefix, "search", size, reps, [&]() {
+                PerformSearch(doc);
+                while (UpdateSearch(doc)) std::this_thread::yield();
+            });
+            printf("  %s: %d lines, %zu token runs, %zu matches for \"%s\", %dx%d px\n", prefix.c_str(), document_line_count(doc),
+                doc.tokenRuns.size(), doc.searchState.matchPositions.size(), doc.searchState.query, width, height);
+        }
+    }
+    return 0;
+}
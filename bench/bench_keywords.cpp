@@ -0,0 +1,105 @@
+#include "bench_common.h"
+#include "code_lexer.h"
+#include "language_registry.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// The keyword sets as the lexer held them before the compiled language
+// tables, kept as the reference for lookup parity and throughput. The C++
+// set's "#include"-style entries are gone: '#' starts a preprocessor token
+// before any word lookup, so they never matched.
+static const std::unordered_set<std::string> s_reference_cpp = {
+    "int", "float", "double", "char", "bool", "void", "class", "struct", "enum", "union",
+    "if", "else", "switch", "case", "default", "for", "while", "do", "break", "continue",
+    "return", "goto", "const", "static", "public", "private", "protected", "namespace",
+    "using", "template", "typename", "try", "catch", "throw", "new", "delete", "nullptr",
+    "auto", "constexpr", "virtual", "override", "final"
+};
+static const std::unordered_set<std::string> s_reference_python = {
+    "False", "None", "True", "and", "as", "assert", "async", "await", "break", "class", "continue", "def", "del", "elif", "else", "except", "finally", "for", "from", "global", "if", "import", "in", "is", "lambda", "nonlocal", "not", "or", "pass", "raise", "return", "try", "while", "with", "yield"
+};
+static const std::unordered_set<std::string> s_reference_js = {
+    "abstract", "arguments", "await", "boolean", "break", "byte", "case", "catch", "char", "class", "const", "continue", "debugger", "default", "delete", "do", "double", "else", "enum", "eval", "export", "extends", "false", "final", "finally", "float", "for", "function", "goto", "if", "implements", "import", "in", "instanceof", "int", "interface", "let", "long", "native", "new", "null", "package", "private", "protected", "public", "return", "short", "static", "super", "switch", "synchronized", "this", "throw", "throws", "transient", "true", "try", "typeof", "var", "void", "volatile", "while", "with", "yield"
+};
+
+// Identifiers in lexer order, with a few near misses (prefixes, case and
+// length variants of keywords) so the mismatch paths are exercised too.
+static std::vector<std::string_view> collect_identifiers(const std::string& text) {
+    std::vector<std::string_view> words;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        unsigned char c = (unsigned char)text[pos];
+        if (!isalpha(c) && c != '_') {
+            pos++;
+            continue;
+        }
+        size_t end = pos + 1;
+        while (end < text.size() && (isalnum((unsigned char)text[end]) || text[end] == '_')) end++;
+        words.push_back(std::string_view(text.data() + pos, end - pos));
+        pos = end;
+    }
+    static const char* const near_misses[] = { "retur", "Return", "returns", "i", "whilex", "NONE", "f", "constexp" };
+    for (const char* word : near_misses) words.push_back(word);
+    return words;
+}
+
+static int run_language(const char* name, int corpus_kind, const std::unordered_set<std::string>& reference, const char* language_id,
+    size_t corpus_bytes)
+{
+    const LexerTables& table = languages().tables(languages().find_by_id(language_id));
+    std::string corpus = make_corpus(corpus_kind, corpus_bytes, 77);
+    std::vector<std::string_view> words = collect_identifiers(corpus);
+    int failures = 0;
+    for (const std::string& keyword : reference) {
+        if (table.word_class(keyword) != Token_Keyword) failures++;
+    }
+
+    size_t expected = 0;
+    std::string ident;
+    size_t allocs0 = bench_allocation_count();
+    double t0 = bench_now_seconds();
+    for (std::string_view word : words) {
+        ident.assign(word.data(), word.size());
+        expected += reference.count(ident);
+    }
+    double t1 = bench_now_seconds();
+    size_t allocs1 = bench_allocation_count();
+    size_t actual = 0;
+    for (std::string_view word : words) {
+        actual += table.word_class(word) == Token_Keyword ? 1 : 0;
+    }
+    double t2 = bench_now_seconds();
+    size_t allocs2 = bench_allocation_count();
+
+    size_t mismatches = 0;
+    for (std::string_view word : words) {
+        if ((reference.count(std::string(word)) != 0) != (table.word_class(word) == Token_Keyword)) mismatches++;
+    }
+    if (mismatches) failures++;
+
+    char label[64];
+    char extra[128];
+    snprintf(label, sizeof(label), "keywords/unordered_set/%s", name);
+    snprintf(extra, sizeof(extra), "%.1f M lookups/s hits=%zu allocs=%zu", words.size() / (t1 - t0) / 1e6, expected, allocs1 - allocs0);
+    bench_report(label, t1 - t0, corpus.size(), extra);
+    snprintf(label, sizeof(label), "keywords/perfect_hash/%s", name);
+    snprintf(extra, sizeof(extra), "%.1f M lookups/s hits=%zu allocs=%zu %s", words.size() / (t2 - t1) / 1e6, actual,
+        allocs2 - allocs1, failures == 0 && actual == expected ? "parity=ok" : "parity=MISMATCH");
+    bench_report(label, t2 - t1, corpus.size(), extra);
+    return failures == 0 && actual == expected ? 0 : 1;
+}
+
+int run_keyword_bench(size_t corpus_bytes) {
+    corpus_bytes = std::min(corpus_bytes, (size_t)64 << 20);
+    int failures = 0;
+    failures += run_language("cpp", Corpus_Cpp, s_reference_cpp, "cpp", corpus_bytes);
+    failures += run_language("python", Corpus_Python, s_reference_python, "python", corpus_bytes);
+    failures += run_language("js", Corpus_Js, s_reference_js, "javascript", corpus_bytes);
+    failures += run_language("minified_js", Corpus_MinifiedJs, s_reference_js, "javascript", corpus_bytes);
+    return failures == 0 ? 0 : 1;
+}
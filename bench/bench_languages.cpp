@@ -0,0 +1,283 @@
+#include "bench_common.h"
+#include "code_lexer.h"
+#include "language_registry.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// The hard-coded lexer the compiled tables replaced, kept as the reference
+// for token parity and throughput. Keyword lookups go through the tables so
+// only the scanning differs. Languages keep their old numbers: 0 C++, 1
+// Python, 3 CSS, 4 JavaScript. The one intended difference is that template
+// literals may now span lines, so corpora are cut at a line end.
+static size_t reference_block_end(const char* line, size_t len, size_t from) {
+    for (size_t i = from; i + 1 < len; ++i) {
+        if (line[i] == '*' && line[i + 1] == '/') return i + 2;
+    }
+    return std::string::npos;
+}
+
+static void reference_push_run(std::vector<TokenRun>& runs, size_t first_run, size_t start, size_t end, unsigned char cls) {
+    if (end <= start) return;
+    if (runs.size() > first_run && runs.back().cls == cls && runs.back().offset + runs.back().length == start) {
+        runs.back().length += (uint32_t)(end - start);
+        return;
+    }
+    runs.push_back({ (uint32_t)start, (uint32_t)(end - start), cls });
+}
+
+template <int Lang>
+static unsigned char reference_lex_line(const LexerTables& keywords, const char* line, size_t len, unsigned char state,
+    std::vector<TokenRun>& runs_out)
+{
+    constexpr bool c_comments = (Lang == 0 || Lang == 4);
+    constexpr bool block_comments = (c_comments || Lang == 3);
+    size_t first_run = runs_out.size();
+    size_t pos = 0;
+
+    while (pos < len) {
+        if (state == 1) {
+            size_t end = reference_block_end(line, len, pos);
+            if (end == std::string::npos) end = len;
+            else state = 0;
+            reference_push_run(runs_out, first_run, pos, end, Token_Comment);
+            pos = end;
+            continue;
+        }
+
+        unsigned char c = (unsigned char)line[pos];
+        unsigned char next = (pos + 1 < len) ? (unsigned char)line[pos + 1] : 0;
+        size_t end = pos + 1;
+        unsigned char cls = Token_Default;
+
+        if (isspace(c)) {
+            while (end < len && isspace((unsigned char)line[end])) end++;
+        }
+        else if ((c_comments && c == '/' && next == '/') || (Lang == 1 && c == '#')) {
+            end = len;
+            cls = Token_Comment;
+        }
+        else if (block_comments && c == '/' && next == '*') {
+            end = reference_block_end(line, len, pos + 2);
+            if (end == std::string::npos) {
+                end = len;
+                state = 1;
+            }
+            cls = Token_Comment;
+        }
+        else if (Lang == 0 && c == '#') {
+            end = len;
+            cls = Token_Preprocessor;
+        }
+        else if (c == '"' || c == '\'' || (Lang == 4 && c == '`')) {
+            while (end < len) {
+                if (line[end] == '\\' && end + 1 < len) { end += 2; continue; }
+                if ((unsigned char)line[end] == c) { end++; break; }
+                end++;
+            }
+            cls = Token_String;
+        }
+        else if (isalpha(c) || c == '_') {
+            while (end < len && (isalnum((unsigned char)line[end]) || line[end] == '_')) end++;
+            if (keywords.word_class(std::string_view(line + pos, end - pos)) == Token_Keyword) cls = Token_Keyword;
+        }
+        else if (isdigit(c) || (c == '.' && isdigit(next))) {
+            while (end < len && (isdigit((unsigned char)line[end]) || line[end] == '.' || tolower((unsigned char)line[end]) == 'f')) end++;
+            cls = Token_Number;
+        }
+
+        reference_push_run(runs_out, first_run, pos, end, cls);
+        pos = end;
+    }
+    return state;
+}
+
+template <typename LexFn>
+static void lex_text(const std::string& text, std::vector<TokenRun>& runs, LexFn&& lex) {
+    runs.clear();
+    unsigned char state = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t nl = text.find('\n', pos);
+        if (nl == std::string::npos) nl = text.size();
+        runs.push_back({ (uint32_t)pos, 0, 0xFF });
+        state = lex(text.data() + pos, nl - pos, state, runs);
+        pos = nl + 1;
+    }
+}
+
+static bool same_runs(const std::vector<TokenRun>& a, const std::vector<TokenRun>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].offset != b[i].offset || a[i].length != b[i].length || a[i].cls != b[i].cls) return false;
+    }
+    return true;
+}
+
+template <int Lang>
+static int run_parity(const char* name, int corpus_kind, const char* language_id, size_t corpus_bytes) {
+    const LexerTables& tables = languages().tables(languages().find_by_id(language_id));
+    std::string corpus = make_corpus(corpus_kind, corpus_bytes, 91);
+    size_t last_line = corpus.rfind('\n');
+    if (last_line != std::string::npos) corpus.resize(last_line + 1);
+    else corpus += '\n';
+    corpus += "/* unterminated\n  trailing block";
+    std::vector<TokenRun> expected;
+    std::vector<TokenRun> actual;
+    expected.reserve(corpus.size() / 2);
+    actual.reserve(corpus.size() / 2);
+
+    double t0 = bench_now_seconds();
+    lex_text(corpus, expected, [&](const char* line, size_t len, unsigned char state, std::vector<TokenRun>& runs) {
+        return reference_lex_line<Lang>(tables, line, len, state, runs);
+    });
+    double t1 = bench_now_seconds();
+    lex_text(corpus, actual, [&](const char* line, size_t len, unsigned char state, std::vector<TokenRun>& runs) {
+        return tables.lex_line(line, len, state, runs);
+    });
+    double t2 = bench_now_seconds();
+    bool ok = same_runs(expected, actual);
+    char label[64];
+    char extra[96];
+    snprintf(label, sizeof(label), "languages/lex_reference/%s", name);
+    bench_report(label, t1 - t0, corpus.size(), "runs=" + std::to_string(expected.size()));
+    snprintf(label, sizeof(label), "languages/lex_tables/%s", name);
+    snprintf(extra, sizeof(extra), "states=%zu rules=%zu %s", tables.state_count(), tables.rule_count(), ok ? "parity=ok" : "parity=MISMATCH");
+    bench_report(label, t2 - t1, corpus.size(), extra);
+    return ok ? 0 : 1;
+}
+
+// Spot checks of the embedded languages: tags and attributes, a script body
+// lexed as JavaScript, a style body lexed as CSS, and back to HTML after each.
+static int check_html() {
+    const LexerTables& tables = languages().tables(languages().find_by_id("html"));
+    struct Probe { int line; const char* text; unsigned char cls; };
+    const char* lines[] = {
+        "<!-- <p>not a tag</p> -->",
+        "<div class=\"main\">It's text</div>",
+        "<script type=\"module\">",
+        "let s = \"</p>\"; // note",
+        "</script >",
+        "<style>",
+        ".card { color: red; }",
+        "</style>",
+        "<p id='x'>done</p>",
+    };
+    const Probe probes[] = {
+        { 0, "<p>", Token_Comment }, { 1, "<div", Token_Tag }, { 1, "class", Token_Attribute }, { 1, "\"main\"", Token_String },
+        { 1, "It's", Token_Default }, { 1, "</div", Token_Tag }, { 2, "<script", Token_Tag }, { 2, "type", Token_Attribute },
+        { 3, "let", Token_Keyword }, { 3, "\"</p>\"", Token_String }, { 3, "// note", Token_Comment }, { 4, "</script", Token_Tag },
+        { 6, ".card", Token_Selector }, { 6, "color", Token_Property }, { 7, "</style", Token_Tag }, { 8, "id", Token_Attribute },
+        { 8, "done", Token_Default },
+    };
+    std::vector<std::vector<TokenRun>> runs(sizeof(lines) / sizeof(lines[0]));
+    unsigned char state = 0;
+    for (size_t i = 0; i < runs.size(); ++i) state = tables.lex_line(lines[i], strlen(lines[i]), state, runs[i]);
+
+    int failures = state == 0 ? 0 : 1;
+    for (const Probe& probe : probes) {
+        const char* line = lines[probe.line];
+        size_t at = std::string_view(line).find(probe.text);
+        size_t len = strlen(probe.text);
+        bool ok = at != std::string_view::npos;
+        for (const TokenRun& run : runs[probe.line]) {
+            if (ok && run.offset < at + len && run.offset + run.length > at) ok = run.cls == probe.cls;
+        }
+        if (!ok) {
+            printf("  html: \"%s\" on line %d is not class %d\n", probe.text, probe.line, probe.cls);
+            failures++;
+        }
+    }
+    bench_report("languages/html_embeds", 0, 0, failures == 0 ? "checks=ok" : "checks=FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+static bool write_file(const fs::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(text.data(), (std::streamsize)text.size());
+    return (bool)out;
+}
+
+// Synthetic definitions in chains of four, each embedding the next, so a
+// change to the last one of a chain must recompile all four and nothing else.
+static std::string synthetic_definition(int index, int revision) {
+    std::string text = "name: Synthetic " + std::to_string(index) + "\nextensions: s" + std::to_string(index) + "\n";
+    text += "line_comment: //\nblock_comment: /* */\nstring: \" \" escape=\\\nstring: ` ` multiline\nline_token: # preprocessor\n";
+    for (int line = 0; line < 8; ++line) {
+        text += "keywords: keyword";
+        for (int word = 0; word < 12; ++word) text += " kw" + std::to_string(index) + "_" + std::to_string(line * 12 + word);
+        text += "\n";
+    }
+    if (index % 4 != 3) text += "embed: <<" + std::to_string(index) + " > >> synthetic" + std::to_string(index + 1) + "\n";
+    if (revision) text += "# revision " + std::to_string(revision) + "\n";
+    return text;
+}
+
+static int run_cache_bench() {
+    const int definitions = 24;
+    fs::path root = fs::temp_directory_path() / "codeviewer_bench_languages";
+    fs::path lang_dir = root / "languages";
+    fs::path cache_dir = root / "cache";
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    fs::create_directories(lang_dir, ec);
+    char file_name[32];
+    for (int i = 0; i < definitions; ++i) {
+        snprintf(file_name, sizeof(file_name), "synthetic%d.lang", i);
+        if (!write_file(lang_dir / file_name, synthetic_definition(i, 0))) {
+            printf("languages: cannot write %s\n", (lang_dir / file_name).string().c_str());
+            return 1;
+        }
+    }
+
+    LanguageSet cold;
+    double t0 = bench_now_seconds();
+    cold.load(lang_dir, cache_dir);
+    double t1 = bench_now_seconds();
+    LanguageSet warm;
+    warm.load(lang_dir, cache_dir);
+    double t2 = bench_now_seconds();
+    write_file(lang_dir / "synthetic3.lang", synthetic_definition(3, 1));
+    LanguageSet edited;
+    edited.load(lang_dir, cache_dir);
+    double t3 = bench_now_seconds();
+
+    for (const std::string& error : cold.errors()) printf("  languages: %s\n", error.c_str());
+    bool ok = cold.count() == definitions && cold.compiled_count() == definitions && cold.errors().empty() &&
+        warm.cache_hits() == definitions && warm.compiled_count() == 0 &&
+        edited.compiled_count() == 4 && edited.cache_hits() == definitions - 4;
+    int states = 0;
+    for (int i = 0; i < warm.count(); ++i) states += (int)warm.tables(i).state_count();
+
+    char extra[128];
+    snprintf(extra, sizeof(extra), "%d definitions, %d states, compiled=%d", definitions, states, cold.compiled_count());
+    bench_report("languages/load_cold", t1 - t0, 0, extra);
+    snprintf(extra, sizeof(extra), "cache_hits=%d compiled=%d", warm.cache_hits(), warm.compiled_count());
+    bench_report("languages/load_warm", t2 - t1, 0, extra);
+    snprintf(extra, sizeof(extra), "cache_hits=%d compiled=%d %s", edited.cache_hits(), edited.compiled_count(), ok ? "cache=ok" : "cache=MISMATCH");
+    bench_report("languages/load_one_edited", t3 - t2, 0, extra);
+    fs::remove_all(root, ec);
+    return ok ? 0 : 1;
+}
+
+int run_language_bench(size_t corpus_bytes) {
+    corpus_bytes = std::min(corpus_bytes, (size_t)64 << 20);
+    int failures = 0;
+    for (const std::string& error : languages().errors()) {
+        printf("languages: %s\n", error.c_str());
+        failures++;
+    }
+    failures += run_cache_bench();
+    failures += check_html();
+    failures += run_parity<0>("cpp", Corpus_Cpp, "cpp", corpus_bytes);
+    failures += run_parity<4>("js", Corpus_Js, "javascript", corpus_bytes);
+    failures += run_parity<4>("minified_js", Corpus_MinifiedJs, "javascript", corpus_bytes);
+    failures += run_parity<4>("long_comment", Corpus_LongComment, "javascript", corpus_bytes);
+    return failures == 0 ? 0 : 1;
+}
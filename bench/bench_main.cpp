@@ -0,0 +1,130 @@
+#include "bench_common.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static void print_usage() {
+    printf("usage: codeviewer_bench [--suite search|regex|files|measure|capture|raster|export|svg|strip|edit|reload|profiler|hotpaths|scheduler|keywords|languages|all]\n"
+        "                        [--size-mb N | --size N[K|M|G]] [--json PATH]\n");
+}
+
+// Accepts a byte count with an optional K, M or G suffix, e.g. "1K" or "1G".
+static bool parse_size(const char* text, size_t& bytes_out) {
+    char* end = nullptr;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text) return false;
+    switch (*end) {
+    case '\0': break;
+    case 'k': case 'K': value <<= 10; ++end; break;
+    case 'm': case 'M': value <<= 20; ++end; break;
+    case 'g': case 'G': value <<= 30; ++end; break;
+    default: return false;
+    }
+    if (*end != '\0' || value == 0) return false;
+    bytes_out = (size_t)value;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string suite = "all";
+    size_t size_bytes = 100 << 20;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--suite") == 0 && i + 1 < argc) {
+            suite = argv[++i];
+        }
+        else if (strcmp(argv[i], "--size-mb") == 0 && i + 1 < argc) {
+            size_bytes = (size_t)strtoull(argv[++i], nullptr, 10) << 20;
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (!parse_size(argv[++i], size_bytes)) {
+                print_usage();
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            if (!bench_open_json_output(argv[++i])) {
+                printf("cannot open %s for writing\n", argv[i]);
+                return 2;
+            }
+        }
+        else {
+            print_usage();
+            return 2;
+        }
+    }
+
+    int result = 0;
+    bool ran = false;
+    if (suite == "all" || suite == "search") {
+        result |= run_search_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "regex") {
+        result |= run_regex_bench(std::min(size_bytes, (size_t)50 << 20));
+        ran = true;
+    }
+    if (suite == "all" || suite == "files") {
+        result |= run_find_in_files_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "measure") {
+        result |= run_measure_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "capture") {
+        result |= run_capture_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "raster") {
+        result |= run_raster_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "export") {
+        result |= run_export_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "svg") {
+        result |= run_svg_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "strip") {
+        result |= run_strip_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "edit") {
+        result |= run_edit_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "reload") {
+        result |= run_reload_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "profiler") {
+        result |= run_profiler_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "hotpaths") {
+        result |= run_hotpath_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "scheduler") {
+        result |= run_scheduler_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "keywords") {
+        result |= run_keyword_bench(size_bytes);
+        ran = true;
+    }
+    if (suite == "all" || suite == "languages") {
+        result |= run_language_bench(size_bytes);
+        ran = true;
+    }
+    if (!ran) {
+        print_usage();
+        return 2;
+    }
+    return result;
+}
@@ -0,0 +1,95 @@
+#include "bench_common.h"
+#include "glyph_advance.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+struct ReferenceFont {
+    std::vector<float> indexAdvanceX;
+    float fallbackAdvanceX = 7.0f;
+
+    float calc_text_width(const char* begin, const char* end) const {
+        float width = 0.0f;
+        const char* p = begin;
+        while (p < end) {
+            unsigned int c;
+            p = utf8_decode(p, end, c);
+            if (c == '\r') continue;
+            width += c < indexAdvanceX.size() ? indexAdvanceX[c] : fallbackAdvanceX;
+        }
+        return width;
+    }
+};
+
+static ReferenceFont make_reference_font(bool fixed_pitch) {
+    ReferenceFont font;
+    font.indexAdvanceX.resize(0x3000, font.fallbackAdvanceX);
+    for (unsigned int c = 33; c < 127; ++c) {
+        font.indexAdvanceX[c] = fixed_pitch ? 7.0f : 5.0f + (float)(c % 5);
+    }
+    font.indexAdvanceX[' '] = 7.0f;
+    font.indexAdvanceX['\t'] = 28.0f;
+    return font;
+}
+
+int run_measure_bench(size_t corpus_bytes) {
+    std::string corpus = make_code_corpus(corpus_bytes, 99);
+    std::vector<std::pair<size_t, size_t>> lines;
+    for (size_t begin = 0; begin < corpus.size();) {
+        size_t end = corpus.find('\n', begin);
+        if (end == std::string::npos) end = corpus.size();
+        lines.push_back(std::make_pair(begin, end));
+        begin = end + 1;
+    }
+
+    printf("measure: %zu lines, %zu bytes\n", lines.size(), corpus.size());
+    int failures = 0;
+    for (int fixed = 1; fixed >= 0; --fixed) {
+        ReferenceFont font = make_reference_font(fixed != 0);
+        GlyphAdvanceTable table;
+        table.build([&font](unsigned int c) {
+            char utf8[4];
+            int len = utf8_encode(c, utf8);
+            return font.calc_text_width(utf8, utf8 + len);
+        });
+        const char* mode = table.is_fixed_pitch() ? "fixed" : "proportional";
+
+        double expected_total = 0.0;
+        double actual_total = 0.0;
+        double t0 = bench_now_seconds();
+        for (const auto& line : lines) {
+            expected_total += font.calc_text_width(corpus.data() + line.first, corpus.data() + line.second);
+        }
+        double t1 = bench_now_seconds();
+        for (const auto& line : lines) {
+            actual_total += table.measure(corpus.data() + line.first, corpus.data() + line.second);
+        }
+        double t2 = bench_now_seconds();
+
+        size_t hit_checksum = 0;
+        double t3 = bench_now_seconds();
+        for (const auto& line : lines) {
+            const char* begin = corpus.data() + line.first;
+            hit_checksum += table.hit_test(begin, corpus.data() + line.second, 140.0f) - begin;
+        }
+        double t4 = bench_now_seconds();
+
+        char name[128];
+        char extra[64];
+        snprintf(extra, sizeof(extra), "width=%.0f", expected_total);
+        snprintf(name, sizeof(name), "measure/reference/%s", mode);
+        bench_report(name, t1 - t0, corpus.size(), extra);
+        snprintf(extra, sizeof(extra), "width=%.0f", actual_total);
+        snprintf(name, sizeof(name), "measure/table/%s", mode);
+        bench_report(name, t2 - t1, corpus.size(), extra);
+        snprintf(extra, sizeof(extra), "checksum=%zu", hit_checksum);
+        snprintf(name, sizeof(name), "measure/hit_test/%s", mode);
+        bench_report(name, t4 - t3, corpus.size(), extra);
+
+        if (std::fabs(expected_total - actual_total) > 1e-6 * expected_total) {
+            printf("  MISMATCH: table width %.2f, reference %.2f\n", actual_total, expected_total);
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
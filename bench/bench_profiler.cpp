@@ -0,0 +1,66 @@
+#include "bench_common.h"
+#include "profiler.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Cost of one recorded scope, single-threaded and with writers contending
+// for the ring while a reader drains it like the overlay does.
+int run_profiler_bench(size_t corpus_bytes) {
+    (void)corpus_bytes;
+    if (!profiler_enabled()) {
+        printf("profiler: not compiled in (CODEVIEWER_ENABLE_PROFILER is OFF)\n");
+        return 0;
+    }
+
+    const int scopes = 2000000;
+    double t0 = bench_now_seconds();
+    for (int i = 0; i < scopes; ++i) {
+        ProfileScope scope("bench");
+    }
+    double t1 = bench_now_seconds();
+    char extra[96];
+    snprintf(extra, sizeof(extra), "%.1f ns/scope", (t1 - t0) * 1e9 / scopes);
+    bench_report("profiler/scope_1thread", t1 - t0, 0, extra);
+
+    const int writers = 4;
+    std::vector<std::thread> threads;
+    std::vector<ProfileEvent> events;
+    uint64_t cursor = 0;
+    std::atomic<int> running{ writers };
+    t0 = bench_now_seconds();
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < scopes / writers; ++i) {
+                ProfileScope scope("bench_mt");
+            }
+            running--;
+        });
+    }
+    size_t drained = 0;
+    int torn = 0;
+    while (running.load() > 0) {
+        events.clear();
+        profiler_read(events, cursor);
+        drained += events.size();
+        for (const ProfileEvent& event : events) {
+            if (!event.name || event.threadId == 0) torn++;
+        }
+    }
+    for (std::thread& thread : threads) thread.join();
+    t1 = bench_now_seconds();
+    snprintf(extra, sizeof(extra), "%.1f ns/scope drained=%zu torn=%d", (t1 - t0) * 1e9 / scopes, drained, torn);
+    bench_report("profiler/scope_4threads", t1 - t0, 0, extra);
+
+    std::string error;
+    std::filesystem::path trace = std::filesystem::temp_directory_path() / "codeviewer_bench_trace.json";
+    t0 = bench_now_seconds();
+    bool written = profiler_write_chrome_trace(trace.string().c_str(), error);
+    t1 = bench_now_seconds();
+    std::error_code ec;
+    size_t trace_bytes = (size_t)std::filesystem::file_size(trace, ec);
+    bench_report("profiler/chrome_trace", t1 - t0, trace_bytes, written ? "" : error);
+    std::filesystem::remove(trace, ec);
+    return written && torn == 0 ? 0 : 1;
+}
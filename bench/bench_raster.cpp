@@ -0,0 +1,160 @@
+#include "bench_common.h"
+#include "soft_raster.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+struct RasterScene {
+    std::vector<unsigned char> atlas;
+    SoftTexture texture;
+    std::vector<SoftVertex> vertices;
+    std::vector<uint16_t> indices;
+    SoftDrawList list;
+};
+
+static void add_quad(RasterScene& scene, float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, uint32_t col) {
+    uint16_t base = (uint16_t)scene.vertices.size();
+    scene.vertices.push_back({ x0, y0, u0, v0, col });
+    scene.vertices.push_back({ x1, y0, u1, v0, col });
+    scene.vertices.push_back({ x1, y1, u1, v1, col });
+    scene.vertices.push_back({ x0, y1, u0, v1, col });
+    const uint16_t quad[6] = { 0, 1, 2, 0, 2, 3 };
+    for (uint16_t i : quad) scene.indices.push_back((uint16_t)(base + i));
+}
+
+static void flush_command(RasterScene& scene, std::vector<std::pair<size_t, size_t>>& spans, size_t& vtx_begin, size_t& idx_begin) {
+    if (scene.indices.size() > idx_begin) {
+        spans.push_back(std::make_pair(vtx_begin, idx_begin));
+    }
+    vtx_begin = scene.vertices.size();
+    idx_begin = scene.indices.size();
+}
+
+// Text-like scene: a line-number gutter, a selection bar per few lines and one
+// glyph quad per character cell sampling a random coverage atlas.
+static void build_scene(RasterScene& scene, int width, int height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    const int atlas_w = 512, atlas_h = 128;
+    scene.atlas.resize((size_t)atlas_w * atlas_h * 4);
+    for (size_t i = 0; i < scene.atlas.size(); i += 4) {
+        scene.atlas[i + 0] = scene.atlas[i + 1] = scene.atlas[i + 2] = 255;
+        scene.atlas[i + 3] = (unsigned char)(rng() & 0xFF);
+    }
+    // White texel used by solid rectangles, as in the ImGui font atlas.
+    std::memset(scene.atlas.data(), 255, 4);
+    scene.texture.rgba = scene.atlas.data();
+    scene.texture.width = atlas_w;
+    scene.texture.height = atlas_h;
+
+    const float cell_w = 7.0f, cell_h = 13.0f, line_h = 17.0f;
+    const float white_u = 0.5f / atlas_w, white_v = 0.5f / atlas_h;
+    const uint32_t palette[] = { 0xFFD69C56, 0xFF9CDCFE, 0xFFCE9178, 0xFF6A9955, 0xFFDCDCAA, 0xFFD4D4D4 };
+
+    std::vector<std::pair<size_t, size_t>> spans;
+    size_t vtx_begin = 0, idx_begin = 0;
+    for (int line = 0; (line + 1) * line_h <= height; ++line) {
+        float y = 10.0f + line * line_h;
+        if (line % 7 == 3) {
+            add_quad(scene, 0.0f, y, (float)width, y + line_h, white_u, white_v, white_u, white_v, 0x40FFA030);
+        }
+        int columns = 20 + (int)(rng() % (unsigned)((width - 60) / cell_w - 20));
+        for (int c = 0; c < columns; ++c) {
+            if (rng() % 6 == 0) continue;
+            float x = 10.0f + c * cell_w + 0.25f * (line % 3);
+            int glyph = (int)(rng() % 95);
+            float u0 = (float)((glyph % 64) * 8) / atlas_w;
+            float v0 = (float)((glyph / 64) * 16 + 16) / atlas_h;
+            add_quad(scene, x, y + 2.0f, x + cell_w, y + 2.0f + cell_h, u0, v0, u0 + cell_w / atlas_w, v0 + cell_h / atlas_h,
+                palette[rng() % (sizeof(palette) / sizeof(palette[0]))]);
+            if (scene.vertices.size() - vtx_begin > 60000) {
+                flush_command(scene, spans, vtx_begin, idx_begin);
+            }
+        }
+    }
+    flush_command(scene, spans, vtx_begin, idx_begin);
+
+    scene.list.vertices = scene.vertices.data();
+    scene.list.vertexCount = scene.vertices.size();
+    scene.list.indices = scene.indices.data();
+    scene.list.indexCount = scene.indices.size();
+    scene.list.indexSize = (int)sizeof(uint16_t);
+    for (size_t i = 0; i < spans.size(); ++i) {
+        size_t idx_end = i + 1 < spans.size() ? spans[i + 1].second : scene.indices.size();
+        SoftDrawCmd cmd;
+        cmd.clipMinX = 0.0f;
+        cmd.clipMinY = 0.0f;
+        cmd.clipMaxX = (float)width;
+        cmd.clipMaxY = (float)height;
+        cmd.texture = &scene.texture;
+        cmd.vtxOffset = (uint32_t)spans[i].first;
+        cmd.idxOffset = (uint32_t)spans[i].second;
+        cmd.elemCount = (uint32_t)(idx_end - spans[i].second);
+        scene.list.commands.push_back(cmd);
+    }
+}
+
+// 16-bit indices are relative to each command's vtxOffset.
+static void rebase_indices(RasterScene& scene) {
+    for (const SoftDrawCmd& cmd : scene.list.commands) {
+        for (uint32_t i = 0; i < cmd.elemCount; ++i) {
+            scene.indices[cmd.idxOffset + i] = (uint16_t)(scene.indices[cmd.idxOffset + i] - cmd.vtxOffset);
+        }
+    }
+}
+
+int run_raster_bench(size_t corpus_bytes) {
+    const int width = 2048;
+    const int height = 2048;
+    const float clear_color[4] = { 0.11f, 0.12f, 0.13f, 1.00f };
+    size_t frame_bytes = (size_t)width * height * 4;
+    int frames = (int)std::max<size_t>(1, corpus_bytes / (8 * 1024 * 1024));
+
+    RasterScene scene;
+    build_scene(scene, width, height, 1234);
+    rebase_indices(scene);
+
+    printf("raster: %dx%d target, %zu quads, %d frames, kernel=%s\n",
+        width, height, scene.indices.size() / 6, frames, soft_raster_kernel_name());
+
+    int hw_threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    int thread_counts[2] = { 1, hw_threads };
+    std::vector<unsigned char> reference;
+    std::vector<unsigned char> pixels(frame_bytes);
+    int failures = 0;
+    for (int t = 0; t < (hw_threads > 1 ? 2 : 1); ++t) {
+        SoftTarget target;
+        target.rgba = pixels.data();
+        target.width = width;
+        target.height = height;
+        target.stride = (size_t)width * 4;
+
+        double t0 = bench_now_seconds();
+        for (int frame = 0; frame < frames; ++frame) {
+            soft_clear(target, clear_color);
+            soft_rasterize(scene.list, target, 0.0f, 0.0f, thread_counts[t]);
+        }
+        double seconds = bench_now_seconds() - t0;
+
+        uint64_t checksum = 1469598103934665603ull;
+        for (unsigned char b : pixels) checksum = (checksum ^ b) * 1099511628211ull;
+
+        char name[64];
+        char extra[128];
+        snprintf(name, sizeof(name), "raster/threads=%d", thread_counts[t]);
+        snprintf(extra, sizeof(extra), "%.1f Mpix/s checksum=%016llx",
+            seconds > 0.0 ? (double)width * height * frames / seconds / 1e6 : 0.0, (unsigned long long)checksum);
+        bench_report(name, seconds, frame_bytes * frames, extra);
+
+        if (reference.empty()) {
+            reference = pixels;
+        }
+        else if (reference != pixels) {
+            printf("  MISMATCH: %d-thread output differs from single-thread output\n", thread_counts[t]);
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include "bench_common.h"
+#include "regex_dfa.h"
+#include <algorithm>
+#include <cstdio>
+#include <regex>
+#include <vector>
+
+static void reference_regex(const std::string& content, size_t limit, const std::regex& re,
+    std::vector<size_t>& positions, std::vector<uint32_t>& lengths)
+{
+    size_t line_begin = 0;
+    while (line_begin < limit) {
+        size_t line_end = content.find('\n', line_begin);
+        if (line_end == std::string::npos) line_end = content.size();
+        const char* first = content.data() + line_begin;
+        const char* last = content.data() + line_end;
+        for (std::cregex_iterator it(first, last, re), end; it != end; ++it) {
+            if (it->length(0) == 0) continue;
+            positions.push_back(line_begin + it->position(0));
+            lengths.push_back((uint32_t)it->length(0));
+        }
+        line_begin = line_end + 1;
+    }
+}
+
+int run_regex_bench(size_t corpus_bytes) {
+    std::string corpus = make_code_corpus(corpus_bytes, 4321);
+    size_t reference_bytes = corpus.find('\n', std::min(corpus.size(), (size_t)8 * 1024 * 1024));
+    reference_bytes = reference_bytes == std::string::npos ? corpus.size() : reference_bytes + 1;
+
+    const char* patterns[] = {
+        "TODO\\(\\w+\\)",
+        "0x[0-9a-f]{8}",
+        "match[A-Z]\\w*",
+        "return [a-z_]+;",
+        "not-present-(anywhere|at-all)",
+    };
+
+    printf("regex corpus %zu bytes, std::regex reference on first %zu bytes\n", corpus.size(), reference_bytes);
+    int failures = 0;
+    for (const char* pattern : patterns) {
+        RegexMatcher matcher;
+        std::string error;
+        if (!matcher.compile(pattern, true, error)) {
+            printf("  %s: compile failed: %s\n", pattern, error.c_str());
+            failures++;
+            continue;
+        }
+
+        std::vector<size_t> expected, actual;
+        std::vector<uint32_t> expected_len, actual_len;
+
+        std::regex re(pattern, std::regex::ECMAScript);
+        double t0 = bench_now_seconds();
+        reference_regex(corpus, reference_bytes, re, expected, expected_len);
+        double t1 = bench_now_seconds();
+        matcher.find_all(corpus.data(), corpus.size(), 0, corpus.size(), actual, actual_len);
+        double t2 = bench_now_seconds();
+
+        char name[128];
+        char extra[64];
+        snprintf(extra, sizeof(extra), "matches=%zu", expected.size());
+        snprintf(name, sizeof(name), "regex/std/%s", pattern);
+        bench_report(name, t1 - t0, reference_bytes, extra);
+        snprintf(extra, sizeof(extra), "matches=%zu", actual.size());
+        snprintf(name, sizeof(name), "regex/dfa/%s", pattern);
+        bench_report(name, t2 - t1, corpus.size(), extra);
+
+        size_t compared = std::lower_bound(actual.begin(), actual.end(), reference_bytes) - actual.begin();
+        actual.resize(compared);
+        actual_len.resize(compared);
+        if (actual != expected || actual_len != expected_len) {
+            printf("  MISMATCH: dfa found %zu matches, std::regex %zu\n", actual.size(), expected.size());
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
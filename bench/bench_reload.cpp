@@ -0,0 +1,98 @@
+#include "bench_common.h"
+#include "code_document.h"
+#include "document_loader.h"
+#include "file_utils.h"
+#include "file_watcher.h"
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+static bool write_file(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(text.data(), (std::streamsize)text.size());
+    return (bool)out;
+}
+
+static bool wait_for_change(FileWatcher& watcher, double timeout_seconds) {
+    double deadline = bench_now_seconds() + timeout_seconds;
+    while (!watcher.has_changes()) {
+        if (bench_now_seconds() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    watcher.take_changes();
+    return true;
+}
+
+static bool reload_and_wait(CodeDocument& doc, std::string& error) {
+    BeginReloadDocument(doc);
+    bool applied = false;
+    while (doc.reloadJob) {
+        applied = UpdateReload(doc, error);
+        if (doc.reloadJob) std::this_thread::yield();
+    }
+    return applied;
+}
+
+int run_reload_bench(size_t corpus_bytes) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "codeviewer_bench_reload.cpp";
+    std::string text = make_code_corpus(corpus_bytes, 23);
+    if (!write_file(path, text)) {
+        printf("reload: cannot write %s\n", path.string().c_str());
+        return 1;
+    }
+
+    CodeDocument doc(path.string(), "codeviewer_bench_reload.cpp");
+    doc.language = detect_lang(doc.fileName);
+    std::string error;
+    double t0 = bench_now_seconds();
+    if (!load_file_buffer(path.string().c_str(), doc.source, error)) {
+        printf("reload: %s\n", error.c_str());
+        return 1;
+    }
+    doc.content = doc.source->view();
+    doc.diskSnapshot = make_file_snapshot(doc.filePath, doc.content);
+    process_code(doc);
+    lex_document(doc);
+    double t1 = bench_now_seconds();
+    bench_report("reload/full_load", t1 - t0, text.size(), "load+snapshot+index+lex");
+
+    FileWatcher watcher;
+    watcher.watch(path.string());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    struct Change {
+        const char* name;
+        size_t offset;
+        size_t erase;
+        const char* insert;
+    };
+    const Change changes[] = {
+        { "reload/append_line", text.size(), 0, "int appended = 1;\n" },
+        { "reload/edit_middle", text.size() / 2, 4, "/* regenerated */" },
+        { "reload/edit_head", 10, 0, "#define GENERATED 1\n" },
+        { "reload/touch_only", 0, 0, "" },
+        { "reload/truncate", 0, text.size() / 2, "" },
+    };
+    int failures = 0;
+    for (const Change& change : changes) {
+        text.replace(std::min(change.offset, text.size()), change.erase, change.insert);
+        double w0 = bench_now_seconds();
+        write_file(path, text);
+        bool notified = wait_for_change(watcher, 5.0);
+        double w1 = bench_now_seconds();
+        bool applied = reload_and_wait(doc, error);
+        double w2 = bench_now_seconds();
+
+        bool ok = notified && watcher.is_watched(path.string()) && doc.content == text;
+        if (!ok) failures++;
+        char extra[160];
+        snprintf(extra, sizeof(extra), "notify=%.1fms applied=%d lexed_lines=%zu %s", (w1 - w0) * 1000.0, applied ? 1 : 0,
+            doc.lineFirstRun.size() - 1, ok ? "reloaded" : (notified ? "content=MISMATCH" : "no notification"));
+        bench_report(change.name, w2 - w1, text.size(), extra);
+    }
+
+    watcher.unwatch(path.string());
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#include "bench_common.h"
+#include "frame_scheduler.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+int run_scheduler_bench(size_t corpus_bytes) {
+    (void)corpus_bytes;
+
+    // A request from a worker thread must wake a UI thread blocked on an
+    // indefinite wait, the way WM_NULL wakes MsgWaitForMultipleObjectsEx.
+    std::mutex mutex;
+    std::condition_variable woken;
+    bool wake_pending = false;
+    FrameScheduler scheduler(std::unique_ptr<FramePolicy>(new EventFramePolicy()), [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        wake_pending = true;
+        woken.notify_one();
+    });
+    set_frame_scheduler(&scheduler);
+    const int wakes = 1000;
+    double total_latency = 0.0;
+    int missed = 0;
+    for (int i = 0; i < wakes; ++i) {
+        while (scheduler.next_frame_delay() == 0.0) scheduler.frame_started();
+        double sent = 0.0;
+        std::thread worker([&]() {
+            sent = bench_now_seconds();
+            request_frame(FrameReason_Job);
+        });
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            woken.wait(lock, [&]() { return wake_pending; });
+            wake_pending = false;
+        }
+        double received = bench_now_seconds();
+        worker.join();
+        total_latency += received - sent;
+        if (scheduler.next_frame_delay() != 0.0) missed++;
+    }
+    set_frame_scheduler(nullptr);
+    char extra[96];
+    snprintf(extra, sizeof(extra), "%.1f us/wake missed=%d %s", total_latency * 1e6 / wakes, missed, missed == 0 ? "ok" : "MISMATCH");
+    bench_report("scheduler/worker_wake", total_latency, 0, extra);
+    return missed == 0 ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#include "bench_common.h"
+#include "search_kernel.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static void reference_search(const std::string& content, std::string query, bool case_sensitive, std::vector<size_t>& out) {
+    std::string content_to_search = content;
+    if (!case_sensitive) {
+        std::transform(content_to_search.begin(), content_to_search.end(), content_to_search.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+        std::transform(query.begin(), query.end(), query.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+    }
+    size_t start_pos = 0;
+    while ((start_pos = content_to_search.find(query, start_pos)) != std::string::npos) {
+        out.push_back(start_pos);
+        start_pos += query.length();
+    }
+}
+
+int run_search_bench(size_t corpus_bytes) {
+    std::string corpus = make_code_corpus(corpus_bytes, 1234);
+
+    struct Query { const char* text; bool caseSensitive; };
+    const Query queries[] = {
+        { "return", true },
+        { "Return", false },
+        { "matchPositions", false },
+        { "TODO(perf)", true },
+        { "not-present-anywhere", false },
+        { "x", false },
+    };
+
+    printf("search kernel: %s, corpus %zu bytes\n", search_kernel_name(), corpus.size());
+    int failures = 0;
+    for (const Query& q : queries) {
+        std::vector<size_t> expected;
+        std::vector<size_t> actual;
+        expected.reserve(1 << 20);
+        actual.reserve(1 << 20);
+
+        double t0 = bench_now_seconds();
+        reference_search(corpus, q.text, q.caseSensitive, expected);
+        double t1 = bench_now_seconds();
+        search_literal(corpus.data(), corpus.size(), 0, corpus.size(), q.text, strlen(q.text), q.caseSensitive, actual);
+        double t2 = bench_now_seconds();
+
+        char name[128];
+        char extra[64];
+        snprintf(extra, sizeof(extra), "matches=%zu", actual.size());
+        snprintf(name, sizeof(name), "search/reference/%s%s", q.text, q.caseSensitive ? "" : "/i");
+        bench_report(name, t1 - t0, corpus.size(), extra);
+        snprintf(name, sizeof(name), "search/kernel/%s%s", q.text, q.caseSensitive ? "" : "/i");
+        bench_report(name, t2 - t1, corpus.size(), extra);
+
+        if (actual != expected) {
+            printf("  MISMATCH: kernel found %zu matches, reference %zu\n", actual.size(), expected.size());
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
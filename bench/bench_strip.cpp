@@ -0,0 +1,166 @@
+#include "bench_common.h"
+#include "code_document.h"
+#include "code_search.h"
+#include "file_utils.h"
+#include "language_registry.h"
+#include "stripped_view.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// The line-at-a-time stripper process_code used before the single-pass
+// version, kept as the reference for output parity and throughput. It still
+// takes the numbers languages had before they were loaded from definitions:
+// 0 C++, 1 Python, 3 CSS, 4 JavaScript.
+static std::string reference_strip_comments(std::string_view code, int lang) {
+    std::string result = "";
+    std::string line;
+    bool in_multi_comment = false;
+
+    size_t line_start = 0;
+    while (line_start < code.size()) {
+        size_t line_end = code.find('\n', line_start);
+        if (line_end == std::string_view::npos) line_end = code.size();
+        line.assign(code.data() + line_start, line_end - line_start);
+        line_start = line_end + 1;
+
+        std::string processed_line = "";
+        bool line_had_content = false;
+
+        if (lang == 0 || lang == 4 || lang == 3) { 
+            size_t current_pos = 0;
+            while (current_pos < line.length()) {
+                if (in_multi_comment) {
+                    size_t end_comment = line.find("*/", current_pos);
+                    if (end_comment != std::string::npos) {
+                        current_pos = end_comment + 2;
+                        in_multi_comment = false;
+                    }
+                    else {
+                        break;
+                    }
+                }
+                else {
+                    size_t single_comment = (lang == 0 || lang == 4) ? line.find("//", current_pos) : std::string::npos;
+                    size_t multi_comment_start = line.find("/*", current_pos);
+                    size_t next_comment_start = std::min(single_comment, multi_comment_start);
+
+                    if (next_comment_start == std::string::npos) {
+                        processed_line += line.substr(current_pos);
+                        if (line.substr(current_pos).find_first_not_of(" \t\r\n") != std::string::npos) line_had_content = true;
+                        break;
+                    }
+
+                    processed_line += line.substr(current_pos, next_comment_start - current_pos);
+                    if (line.substr(current_pos, next_comment_start - current_pos).find_first_not_of(" \t\r\n") != std::string::npos) line_had_content = true;
+
+                    if (next_comment_start == single_comment) {
+                        break;
+                    }
+                    else {
+                        size_t end_comment = line.find("*/", next_comment_start + 2);
+                        if (end_comment != std::string::npos) {
+                            current_pos = end_comment + 2;
+                        }
+                        else {
+                            in_multi_comment = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        else if (lang == 1) { 
+            size_t comment_pos = line.find("#");
+            processed_line += line.substr(0, comment_pos);
+            if (processed_line.find_first_not_of(" \t\r\n") != std::string::npos) line_had_content = true;
+        }
+        else {
+            processed_line += line;
+            if (processed_line.find_first_not_of(" \t\r\n") != std::string::npos) line_had_content = true;
+        }
+
+        size_t endpos = processed_line.find_last_not_of(" \t\r\n");
+        if (std::string::npos != endpos) {
+            processed_line = processed_line.substr(0, endpos + 1);
+        }
+        else {
+            processed_line.clear();
+        }
+
+        if (!processed_line.empty() || line_had_content) {
+            result += processed_line + "\n";
+        }
+    }
+    return result;
+}
+
+int run_strip_bench(size_t corpus_bytes) {
+    std::string corpus = make_code_corpus(corpus_bytes, 11);
+    corpus += "/* unterminated\n  trailing block";
+    int failures = 0;
+    printf("strip: %zu bytes of source\n", corpus.size());
+
+    struct { int reference; const char* id; } cases[] = { { 0, "cpp" }, { 1, "python" }, { 3, "css" }, { 4, "javascript" }, { -1, "text" } };
+    for (const auto& test : cases) {
+        double t0 = bench_now_seconds();
+        std::string expected = reference_strip_comments(corpus, test.reference);
+        double t1 = bench_now_seconds();
+        StrippedView view(corpus, languages().find_by_id(test.id));
+        double t2 = bench_now_seconds();
+        std::string actual;
+        view.copy(actual);
+
+        char name[64];
+        char extra[96];
+        snprintf(name, sizeof(name), "strip/reference/%s", test.id);
+        bench_report(name, t1 - t0, corpus.size(), "copy_bytes=" + std::to_string(expected.size()));
+        snprintf(name, sizeof(name), "strip/spans/%s", test.id);
+        snprintf(extra, sizeof(extra), "view_bytes=%zu %s", view.memory_bytes(), actual == expected ? "parity=ok" : "parity=MISMATCH");
+        bench_report(name, t2 - t1, corpus.size(), extra);
+        if (actual != expected) failures++;
+    }
+
+    CodeDocument doc("bench.cpp", "bench.cpp", make_text_buffer(std::move(corpus)));
+    doc.language = languages().find_by_id("cpp");
+    process_code(doc);
+    doc.showComments = false;
+    double t0 = bench_now_seconds();
+    process_code(doc);
+    double t1 = bench_now_seconds();
+    const int toggles = 100;
+    for (int i = 0; i < toggles; ++i) {
+        doc.showComments = !doc.showComments;
+        process_code(doc);
+    }
+    double t2 = bench_now_seconds();
+    bench_report("strip/process_code/first_strip", t1 - t0, doc.content.size());
+    char extra[96];
+    snprintf(extra, sizeof(extra), "%d toggles", toggles);
+    bench_report("strip/process_code/toggle", (t2 - t1) / toggles, 0, extra);
+
+    // Search over the stripped ranges must find exactly what a search of the
+    // materialized stripped text finds.
+    doc.showComments = false;
+    process_code(doc);
+    std::string materialized;
+    doc.stripped->copy(materialized);
+    const char* query = "values[i]";
+    strcpy(doc.searchState.query, query);
+    double s0 = bench_now_seconds();
+    PerformSearch(doc);
+    while (UpdateSearch(doc)) std::this_thread::yield();
+    double s1 = bench_now_seconds();
+    std::vector<size_t> expected_matches;
+    for (size_t pos = materialized.find(query); pos != std::string::npos; pos = materialized.find(query, pos + 1)) {
+        expected_matches.push_back(pos);
+    }
+    bool search_ok = expected_matches == doc.searchState.matchPositions;
+    snprintf(extra, sizeof(extra), "matches=%zu %s", expected_matches.size(), search_ok ? "parity=ok" : "parity=MISMATCH");
+    bench_report("strip/search_stripped", s1 - s0, doc.stripped->size(), extra);
+    if (!search_ok) failures++;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+#include "bench_common.h"
+#include "code_document.h"
+#include "file_utils.h"
+#include "glyph_advance.h"
+#include "language_registry.h"
+#include "svg_export.h"
+#include <algorithm>
+#include <cstdio>
+
+int run_svg_bench(size_t corpus_bytes) {
+    const int target_lines = 5000;
+    std::string corpus = make_code_corpus(std::min(corpus_bytes, (size_t)target_lines * 40), 7);
+    size_t cut = 0;
+    for (int line = 0; line < target_lines && cut < corpus.size(); ++line) {
+        size_t nl = corpus.find('\n', cut);
+        cut = nl == std::string::npos ? corpus.size() : nl + 1;
+    }
+    corpus.resize(cut);
+
+    CodeDocument doc("bench.cpp", "bench.cpp", make_text_buffer(std::move(corpus)));
+    doc.language = languages().find_by_id("cpp");
+    process_code(doc);
+    lex_document(doc);
+
+    GlyphAdvanceTable advances;
+    advances.build([](unsigned int c) { return c == '\t' ? 28.0f : 7.0f; });
+    SvgExportStyle style;
+    const uint32_t palette[Token_Count] = { 0xFFEBE8E6, 0xFFE69933, 0xFF59A659, 0xFF4D80CC, 0xFF66B3B3, 0xFFCC6699,
+        0xFF4D4DE6, 0xFF4DCC99, 0xFFCC4DCC, 0xFFF2804D };
+    std::copy(palette, palette + Token_Count, style.classColors);
+
+    std::string path = (std::filesystem::temp_directory_path() / "codeviewer_bench.svg").string();
+    std::string error;
+    if (!write_code_svg(path.c_str(), doc, style, advances, error)) {
+        printf("svg export failed: %s\n", error.c_str());
+        return 1;
+    }
+
+    const int iterations = 20;
+    double t0 = bench_now_seconds();
+    for (int i = 0; i < iterations; ++i) {
+        write_code_svg(path.c_str(), doc, style, advances, error);
+    }
+    double seconds = (bench_now_seconds() - t0) / iterations;
+
+    std::error_code ec;
+    uintmax_t svg_bytes = std::filesystem::file_size(path, ec);
+    std::filesystem::remove(path, ec);
+
+    printf("svg: %zu lines, %zu bytes of source\n", doc.lineOffsets.size(), doc.content.size());
+    char extra[128];
+    snprintf(extra, sizeof(extra), "svg_bytes=%llu (%.1f per line)", (unsigned long long)svg_bytes,
+        (double)svg_bytes / std::max<size_t>(1, doc.lineOffsets.size()));
+    bench_report("svg/write", seconds, doc.content.size(), extra);
+    return 0;
+}
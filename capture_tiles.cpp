@@ -0,0 +1,53 @@
+#include "capture_tiles.h"
+#include "png_writer.h"
+#include <algorithm>
+#include <cmath>
+
+std::vector<CaptureTile> plan_capture_tiles(int image_height, int max_tile_height) {
+    std::vector<CaptureTile> tiles;
+    if (image_height <= 0 || max_tile_height <= 0) return tiles;
+    for (int y = 0; y < image_height; y += max_tile_height) {
+        CaptureTile tile;
+        tile.y = y;
+        tile.height = std::min(max_tile_height, image_height - y);
+        tiles.push_back(tile);
+    }
+    return tiles;
+}
+
+void capture_tile_lines(const CaptureTile& tile, int line_count, float line_height, float top_padding, int& first_line_out, int& line_end_out) {
+    if (line_height <= 0.0f) {
+        first_line_out = 0;
+        line_end_out = line_count;
+        return;
+    }
+    first_line_out = std::max(0, (int)std::floor(((float)tile.y - top_padding) / line_height) - 1);
+    line_end_out = std::min(line_count, (int)std::ceil(((float)(tile.y + tile.height) - top_padding) / line_height) + 1);
+    line_end_out = std::max(first_line_out, line_end_out);
+}
+
+bool write_tiled_png(const char* path, int width, int height, int max_tile_height,
+    const CaptureTileRenderFn& render_tile, std::string& error_out, int thread_count)
+{
+    PngStreamWriter png;
+    if (!png.open(path, width, height, error_out, thread_count)) {
+        return false;
+    }
+
+    std::vector<unsigned char> tile_pixels;
+    size_t stride = (size_t)width * 4;
+    for (const CaptureTile& tile : plan_capture_tiles(height, max_tile_height)) {
+        if (!render_tile(tile, tile_pixels)) {
+            error_out = "Failed to render image tile.";
+            return false;
+        }
+        if (tile_pixels.size() < stride * tile.height) {
+            error_out = "Rendered image tile is too small.";
+            return false;
+        }
+        if (!png.write_rows(tile_pixels.data(), tile.height, stride, error_out)) {
+            return false;
+        }
+    }
+    return png.finish(error_out);
+}
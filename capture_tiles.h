@@ -0,0 +1,18 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+struct CaptureTile {
+    int y = 0;
+    int height = 0;
+};
+
+typedef std::function<bool(const CaptureTile& tile, std::vector<unsigned char>& rgba_out)> CaptureTileRenderFn;
+
+std::vector<CaptureTile> plan_capture_tiles(int image_height, int max_tile_height);
+void capture_tile_lines(const CaptureTile& tile, int line_count, float line_height, float top_padding, int& first_line_out, int& line_end_out);
+
+bool write_tiled_png(const char* path, int width, int height, int max_tile_height,
+    const CaptureTileRenderFn& render_tile, std::string& error_out, int thread_count = 0);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <memory>
+#include "code_lexer.h"
+#include "text_buffer.h"
+#include "stripped_view.h"
+
+struct SearchJob;
+struct LoadJob;
+struct ReloadJob;
+struct FileSnapshot;
+class PieceTable;
+
+struct SearchState {
+    char query[256] = "";
+    bool caseSensitive = false;
+    bool useRegex = false;
+    bool active = false;
+    int currentMatch = -1;
+    int pendingMatch = -1;
+    std::vector<size_t> matchPositions;
+    std::vector<uint32_t> matchLengths;
+    std::vector<int> matchLines;
+    std::string regexError;
+    std::shared_ptr<SearchJob> job;
+
+    bool scrollToMatch = false;
+    int lineToScrollTo = -1;
+};
+
+struct CodeDocument {
+    std::string filePath;
+    std::string fileName;
+    TextBufferPtr source;
+    std::string_view content;
+    std::shared_ptr<PieceTable> pieces;
+    std::vector<size_t> lineOffsets;
+    StrippedViewPtr stripped;
+    std::vector<TokenRun> tokenRuns;
+    std::vector<uint32_t> lineFirstRun;
+    std::vector<unsigned char> lineLexState;
+    bool showComments = true;
+    bool strippedView = false;
+    int language = -1;
+    bool open = true;
+    bool selectTab = false;
+    SearchState searchState;
+    std::shared_ptr<LoadJob> loadJob;
+    std::shared_ptr<ReloadJob> reloadJob;
+    std::shared_ptr<const FileSnapshot> diskSnapshot;
+
+    CodeDocument(std::string path = "", std::string name = "", TextBufferPtr data = nullptr)
+        : filePath(std::move(path)),
+        fileName(std::move(name)),
+        source(data ? std::move(data) : make_text_buffer("")),
+        content(source->view()),
+        open(true)
+    {}
+};
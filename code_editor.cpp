@@ -1,38 +1,86 @@
 ﻿#include "code_editor.h"
 #include "file_utils.h"
 #include "ui_addons.h"
+#include "code_search.h"
+#include "document_loader.h"
+#include "file_watcher.h"
+#include "profiler.h"
+#include "frame_scheduler.h"
 #include "imgui.h"
 #include "code_capture.h"
 #include "tinyfiledialogs.h"
 #include <vector>
 #include <string>
-#include <unordered_set>
 #include <algorithm>
 #include <cctype>
 #include <cmath>
-#include <sstream>
-
-const std::unordered_set<std::string> cppKeywords = {
-    "int", "float", "double", "char", "bool", "void", "class", "struct", "enum", "union",
-    "if", "else", "switch", "case", "default", "for", "while", "do", "break", "continue",
-    "return", "goto", "const", "static", "public", "private", "protected", "namespace",
-    "using", "template", "typename", "try", "catch", "throw", "new", "delete", "nullptr",
-    "auto", "constexpr", "virtual", "override", "final", "#include", "#define", "#ifdef",
-    "#ifndef", "#endif", "#pragma"
-};
-const std::unordered_set<std::string> pythonKeywords = {
-    "False", "None", "True", "and", "as", "assert", "async", "await", "break", "class", "continue", "def", "del", "elif", "else", "except", "finally", "for", "from", "global", "if", "import", "in", "is", "lambda", "nonlocal", "not", "or", "pass", "raise", "return", "try", "while", "with", "yield"
-};
-const std::unordered_set<std::string> jsKeywords = {
-    "abstract", "arguments", "await", "boolean", "break", "byte", "case", "catch", "char", "class", "const", "continue", "debugger", "default", "delete", "do", "double", "else", "enum", "eval", "export", "extends", "false", "final", "finally", "float", "for", "function", "goto", "if", "implements", "import", "in", "instanceof", "int", "interface", "let", "long", "native", "new", "null", "package", "private", "protected", "public", "return", "short", "static", "super", "switch", "synchronized", "this", "throw", "throws", "transient", "true", "try", "typeof", "var", "void", "volatile", "while", "with", "yield"
-};
-const std::unordered_set<std::string> cssKeywords = {
-    "color", "background-color", "font-size", "font-family", "font-weight", "text-align", "margin", "padding", "border", "width", "height", "display", "position", "top", "left", "right", "bottom", "float", "clear", "overflow", "z-index", "opacity", "border-radius", "box-shadow", "text-decoration", "line-height", "letter-spacing", "content", "cursor", "transition", "transform"
-};
-const std::unordered_set<std::string> htmlKeywords = {
-    "html", "head", "title", "body", "div", "span", "p", "a", "img", "ul", "ol", "li", "table", "tr", "td", "th", "form", "input", "button", "select", "option", "textarea", "h1", "h2", "h3", "h4", "h5", "h6", "strong", "em", "br", "hr", "link", "meta", "style", "script", "header", "footer", "nav", "section", "article", "aside"
+#include <cfloat>
+#include <memory>
+#include <set>
+
+const ImVec4& token_color(const SyntaxColors& colors, unsigned char cls) {
+    switch (cls) {
+    case Token_Keyword: return colors.keyword;
+    case Token_Comment: return colors.comment;
+    case Token_String: return colors.string_literal;
+    case Token_Number: return colors.number_literal;
+    case Token_Preprocessor: return colors.preprocessor;
+    case Token_Tag: return colors.html_tag;
+    case Token_Attribute: return colors.html_attribute;
+    case Token_Selector: return colors.css_selector;
+    case Token_Property: return colors.css_property;
+    default: return colors.default_text;
+    }
+}
+
+struct FontAdvanceEntry {
+    ImFont* font;
+    float fontSize;
+    std::unique_ptr<GlyphAdvanceTable> table;
 };
 
+const GlyphAdvanceTable& font_advances(ImFont* font, float font_size) {
+    static std::vector<FontAdvanceEntry> cache;
+    for (const FontAdvanceEntry& entry : cache) {
+        if (entry.font == font && entry.fontSize == font_size) return *entry.table;
+    }
+
+    std::unique_ptr<GlyphAdvanceTable> table(new GlyphAdvanceTable());
+    table->build([font, font_size](unsigned int codepoint) {
+        char utf8[4];
+        int len = utf8_encode(codepoint, utf8);
+        return font->CalcTextSizeA(font_size, FLT_MAX, 0.0f, utf8, utf8 + len).x;
+    });
+    cache.push_back(FontAdvanceEntry{ font, font_size, std::move(table) });
+    return *cache.back().table;
+}
+
+// Keeps the watcher's file set in step with the open tabs and starts a
+// background reload for every tab whose file changed on disk.
+static void watch_open_documents(FileWatcher& watcher, std::vector<CodeDocument>& docs) {
+    static std::set<std::string> watched;
+    std::set<std::string> wanted;
+    for (const CodeDocument& doc : docs) {
+        if (doc.open && !doc.loadJob && !doc.filePath.empty()) wanted.insert(doc.filePath);
+    }
+    for (const std::string& path : watched) {
+        if (!wanted.count(path)) watcher.unwatch(path);
+    }
+    for (const std::string& path : wanted) {
+        if (!watched.count(path)) watcher.watch(path);
+    }
+    watched.swap(wanted);
+
+    if (!watcher.has_changes()) return;
+    std::vector<std::string> changes = watcher.take_changes();
+    std::set<std::string> changed(changes.begin(), changes.end());
+    for (CodeDocument& doc : docs) {
+        if (doc.open && changed.count(FileWatcher::normalize_path(doc.filePath))) {
+            BeginReloadDocument(doc);
+        }
+    }
+}
+
 void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& docs, int& active_doc_idx)
 {
     if (p_open && !*p_open) {
@@ -40,6 +88,8 @@ void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& docs, int& active
     }
 
     static const SyntaxColors syntaxColors;
+    static bool show_find_in_files = false;
+    static bool show_profiler = false;
     ImGuiWindowFlags win_flags = ImGuiWindowFlags_MenuBar;
 
     ImGuiViewport* viewport = ImGui::GetMainViewport();
@@ -53,21 +103,30 @@ void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& docs, int& active
         return;
     }
 
+    ImGuiIO& io = ImGui::GetIO();
+    if (io.KeyCtrl && io.KeyShift && ImGui::IsKeyPressed(ImGuiKey_F, false)) {
+        show_find_in_files = true;
+    }
+    if (io.WantTextInput) {
+        request_frame(FrameReason_Animation, CARET_BLINK_FRAME_INTERVAL);
+    }
+
     if (ImGui::BeginMenuBar()) {
         if (ImGui::BeginMenu("File")) {
             if (ImGui::MenuItem("Open File...")) {
                 const char* filters[8] = { "*.cpp", "*.h", "*.hpp", "*.c", "*.py", "*.html", "*.css", "*.js" };
-                const char* file_path = tinyfd_openFileDialog("Open Code File", "", 8, filters, NULL, 0);
-                if (file_path != NULL) {
-                    std::string content_str;
-                    if (load_file_str(file_path, content_str)) {
-                        std::string path_str = file_path;
-                        std::string name_str = path_str.substr(path_str.find_last_of("/\\") + 1);
-                        docs.emplace_back(path_str, name_str, content_str);
-                        docs.back().language = detect_lang(name_str);
-                        process_code(docs.back());
-                        active_doc_idx = docs.size() - 1;
+                const char* file_paths = tinyfd_openFileDialog("Open Code File", "", 8, filters, NULL, 1);
+                if (file_paths != NULL) {
+                    std::vector<std::string> paths;
+                    std::string list = file_paths;
+                    size_t begin = 0;
+                    while (begin <= list.size()) {
+                        size_t end = list.find('|', begin);
+                        if (end == std::string::npos) end = list.size();
+                        if (end > begin) paths.push_back(list.substr(begin, end - begin));
+                        begin = end + 1;
                     }
+                    OpenDocuments(docs, paths, active_doc_idx);
                 }
             }
             if (ImGui::MenuItem("Close Current", NULL, false, active_doc_idx >= 0 && !docs.empty())) {
@@ -86,45 +145,76 @@ void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& docs, int& active
                     docs[active_doc_idx].searchState.active = true;
                 }
             }
+            if (ImGui::MenuItem("Find in Files", "Ctrl+Shift+F")) {
+                show_find_in_files = true;
+            }
+            ImGui::MenuItem("Profiler", NULL, &show_profiler);
             ImGui::EndMenu();
         }
         ImGui::EndMenuBar();
     }
 
-    if (ImGui::BeginTabBar("CodeTabs", ImGuiTabBarFlags_Reorderable | ImGuiTabBarFlags_AutoSelectNewTabs | ImGuiTabBarFlags_FittingPolicyScroll)) {
-        int doc_to_close_idx = -1;
-        static std::vector<bool> in_multiline_comment_states;
-        if (in_multiline_comment_states.size() < docs.size()) {
-            in_multiline_comment_states.resize(docs.size(), false);
-        }
+    static FileWatcher file_watcher([]() { request_frame(FrameReason_FileChange); });
+    watch_open_documents(file_watcher, docs);
 
+    if (ImGui::BeginTabBar("CodeTabs", ImGuiTabBarFlags_Reorderable | ImGuiTabBarFlags_AutoSelectNewTabs | ImGuiTabBarFlags_FittingPolicyScroll)) {
         for (int n = 0; n < docs.size(); ++n) {
             if (n >= docs.size()) continue;
             CodeDocument& current_doc = docs[n];
             if (!current_doc.open) continue;
-
-            bool tab_visible = ImGui::BeginTabItem(current_doc.fileName.c_str(), &current_doc.open, ImGuiTabItemFlags_None);
-            if (!current_doc.open) {
-                doc_to_close_idx = n;
+            std::string load_error;
+            if (UpdateLoad(current_doc, load_error) && !load_error.empty()) {
+                tinyfd_messageBox("Error", (current_doc.filePath + ": " + load_error).c_str(), "ok", "error", 1);
+                current_doc.open = false;
+                continue;
+            }
+            // A failed reload keeps the current text; the next change event retries.
+            std::string reload_error;
+            UpdateReload(current_doc, reload_error);
+            UpdateSearch(current_doc);
+            // Progress and incoming matches need redraws while a job runs;
+            // its completion requests the final frame itself.
+            if (current_doc.loadJob || current_doc.reloadJob || current_doc.searchState.job) {
+                request_frame(FrameReason_Animation, PROGRESS_FRAME_INTERVAL);
             }
 
-            if (tab_visible) {
+            ImGuiTabItemFlags tab_flags = current_doc.selectTab ? ImGuiTabItemFlags_SetSelected : ImGuiTabItemFlags_None;
+            current_doc.selectTab = false;
+            bool tab_visible = ImGui::BeginTabItem(current_doc.fileName.c_str(), &current_doc.open, tab_flags);
+
+            if (tab_visible && current_doc.loadJob) {
+                active_doc_idx = n;
+                float progress = LoadProgress(current_doc);
+                ImGui::TextDisabled("%s", current_doc.filePath.c_str());
+                ImGui::ProgressBar(progress, ImVec2(-FLT_MIN, 0), progress < 1.0f ? "Loading..." : "Processing...");
+                ImGui::EndTabItem();
+            }
+            else if (tab_visible) {
                 active_doc_idx = n;
                 if (ImGui::Checkbox("Show Comments", &current_doc.showComments)) {
                     process_code(current_doc);
+                    if (current_doc.searchState.active && current_doc.searchState.query[0] != '\0') {
+                        PerformSearch(current_doc);
+                    }
                 }
                 ImGui::SameLine();
                 if (ImGui::Button("Save as Image")) {
                     extern ImFont* g_pCodeFont;
                     capture_code_to_image(current_doc, syntaxColors, g_pCodeFont);
                 }
+                ImGui::SameLine();
+                if (ImGui::Button("Save as SVG")) {
+                    extern ImFont* g_pCodeFont;
+                    export_code_to_svg(current_doc, syntaxColors, g_pCodeFont);
+                }
+                if (!current_doc.filePath.empty() && !file_watcher.is_watched(current_doc.filePath)) {
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("Not watched: changes on disk will not reload");
+                }
 
                 ImGui::Separator();
 
-                int line_count = 0;
-                for (char c : current_doc.processedContent) { if (c == '\n') line_count++; }
-                if (!current_doc.processedContent.empty() && current_doc.processedContent.back() != '\n') line_count++;
-                line_count = std::max(1, line_count);
+                int line_count = document_line_count(current_doc);
 
                 float footer_height = ImGui::GetFrameHeightWithSpacing() * (current_doc.searchState.active ? 2.5f : 1.0f);
                 ImGui::BeginChild("CodeAreaChild", ImVec2(0, -footer_height), false, ImGuiWindowFlags_HorizontalScrollbar);
@@ -133,15 +223,11 @@ void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& docs, int& active
                 if (current_doc.searchState.scrollToMatch) {
                     int line_to_scroll = current_doc.searchState.lineToScrollTo;
 
-                    if (line_to_scroll == -1 && current_doc.searchState.currentMatch != -1) {
-                        size_t match_pos = current_doc.searchState.matchPositions[current_doc.searchState.currentMatch];
-                        line_to_scroll = 0;
-                        for (size_t i = 0; i < match_pos; ++i) {
-                            if (current_doc.processedContent[i] == '\n') {
-                                line_to_scroll++;
-                            }
-                        }
-                        line_to_scroll++;
+                    if (line_to_scroll != -1) {
+                        line_to_scroll = line_from_original(current_doc, line_to_scroll - 1) + 1;
+                    }
+                    else if (current_doc.searchState.currentMatch != -1) {
+                        line_to_scroll = current_doc.searchState.matchLines[current_doc.searchState.currentMatch] + 1;
                     }
 
                     float target_y = ((line_to_scroll - 1) * line_height) - (ImGui::GetWindowHeight() / 2.0f);
@@ -153,133 +239,68 @@ void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& docs, int& active
                 extern ImFont* g_pCodeFont;
                 if (g_pCodeFont) ImGui::PushFont(g_pCodeFont);
 
+                int last_line_number = max_line_number(current_doc);
                 char line_no_fmt[16];
-                int max_digits = (line_count == 0) ? 1 : ((int)log10(line_count) + 1);
-                sprintf_s(line_no_fmt, sizeof(line_no_fmt), "%%-%dd | ", max_digits);
+                int max_digits = (int)log10(last_line_number) + 1;
+                snprintf(line_no_fmt, sizeof(line_no_fmt), "%%-%dd | ", max_digits);
                 char max_line_no_str[16];
-                sprintf_s(max_line_no_str, sizeof(max_line_no_str), "%d | ", line_count);
+                snprintf(max_line_no_str, sizeof(max_line_no_str), "%d | ", last_line_number);
                 float line_no_width = ImGui::CalcTextSize(max_line_no_str).x;
 
-                std::stringstream ss(current_doc.processedContent);
-                std::string line;
-                int current_line_num = 1;
-                size_t char_offset = 0;
-
-                while (std::getline(ss, line)) {
-                    ImGui::TextDisabled(line_no_fmt, current_line_num++);
-                    ImGui::SameLine(line_no_width);
-
-                    if (current_doc.searchState.active && !current_doc.searchState.matchPositions.empty()) {
-                        ImDrawList* draw_list = ImGui::GetWindowDrawList();
-                        const ImVec2 p = ImGui::GetCursorScreenPos();
-                        float line_height_nodraw = ImGui::GetTextLineHeight();
-                        size_t query_len = strlen(current_doc.searchState.query);
-
-                        for (size_t match_pos : current_doc.searchState.matchPositions) {
-                            if (match_pos >= char_offset && match_pos < char_offset + line.length() + 1) {
-                                std::string line_substr = line.substr(0, match_pos - char_offset);
-                                float highlight_x_start = p.x + ImGui::CalcTextSize(line_substr.c_str()).x;
-                                float highlight_x_end = highlight_x_start + ImGui::CalcTextSize(line.substr(match_pos - char_offset, query_len).c_str()).x;
-                                draw_list->AddRectFilled(ImVec2(highlight_x_start, p.y), ImVec2(highlight_x_end, p.y + line_height_nodraw), IM_COL32(100, 100, 0, 100));
-                            }
-                        }
-                    }
-
-                    size_t current_pos = 0;
-                    while (current_pos < line.length()) {
-                        size_t start_token = current_pos;
-                        size_t end_token = current_pos;
-                        ImVec4 current_color = syntaxColors.default_text;
-
-                        auto get_next_token = [&]() {
-                            while (end_token < line.length() && !isspace(line[end_token]) && !ispunct(line[end_token])) {
-                                end_token++;
-                            }
-                            if (end_token == start_token) {
-                                end_token++;
-                            }
-                        };
-
-                        if (in_multiline_comment_states[n]) {
-                            size_t end_comment = line.find("*/", start_token);
-                            if (end_comment == std::string::npos) {
-                                end_token = line.length();
-                            }
-                            else {
-                                end_token = end_comment + 2;
-                                in_multiline_comment_states[n] = false;
-                            }
-                            current_color = syntaxColors.comment;
-                        }
-                        else {
-                            char c = line[start_token];
-                            if (c == '/' && start_token + 1 < line.length() && line[start_token + 1] == '/') {
-                                end_token = line.length();
-                                current_color = syntaxColors.comment;
-                            }
-                            else if (c == '/' && start_token + 1 < line.length() && line[start_token + 1] == '*') {
-                                size_t end_comment = line.find("*/", start_token + 2);
-                                if (end_comment == std::string::npos) {
-                                    end_token = line.length();
-                                    in_multiline_comment_states[n] = true;
-                                }
-                                else {
-                                    end_token = end_comment + 2;
-                                }
-                                current_color = syntaxColors.comment;
-                            }
-                            else if (c == '#') {
-                                end_token = line.length();
-                                current_color = syntaxColors.preprocessor;
-                            }
-                            else if (c == '"' || c == '\'') {
-                                end_token = start_token + 1;
-                                while (end_token < line.length()) {
-                                    if (line[end_token] == c) {
-                                        end_token++;
-                                        break;
-                                    }
-                                    if (line[end_token] == '\\' && end_token + 1 < line.length()) {
-                                        end_token++;
+                ImFont* view_font = ImGui::GetFont();
+                float view_font_size = ImGui::GetFontSize();
+                const GlyphAdvanceTable& advances = font_advances(view_font, view_font_size);
+                ImU32 class_colors[Token_Count];
+                for (int c = 0; c < Token_Count; ++c) class_colors[c] = ImGui::ColorConvertFloat4ToU32(token_color(syntaxColors, (unsigned char)c));
+
+                {
+                    PROFILE_SCOPE("draw_list");
+                    std::string line_scratch;
+                    ImGuiListClipper clipper;
+                    clipper.Begin(current_doc.lineOffsets.empty() && !current_doc.pieces ? 0 : line_count, line_height);
+                    while (clipper.Step()) {
+                        ensure_lexed(current_doc, clipper.DisplayEnd);
+                        for (int line_idx = clipper.DisplayStart; line_idx < clipper.DisplayEnd; ++line_idx) {
+                            size_t char_offset = line_start_offset(current_doc, line_idx);
+                            std::string_view line = line_text(current_doc, line_idx, line_scratch);
+                            const char* line_begin = line.data();
+                            const char* line_end = line_begin + line.size();
+
+                            ImGui::TextDisabled(line_no_fmt, original_line(current_doc, line_idx) + 1);
+                            ImGui::SameLine(line_no_width);
+
+                            if (current_doc.searchState.active && !current_doc.searchState.matchLines.empty()) {
+                                const SearchState& search = current_doc.searchState;
+                                auto hits = std::equal_range(search.matchLines.begin(), search.matchLines.end(), line_idx);
+                                if (hits.first != hits.second) {
+                                    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+                                    const ImVec2 p = ImGui::GetCursorScreenPos();
+                                    float line_height_nodraw = ImGui::GetTextLineHeight();
+                                    for (auto it = hits.first; it != hits.second; ++it) {
+                                        size_t m = it - search.matchLines.begin();
+                                        const char* match_begin = line_begin + (search.matchPositions[m] - char_offset);
+                                        const char* match_end = std::min(match_begin + search.matchLengths[m], line_end);
+                                        float highlight_x_start = p.x + advances.measure(line_begin, match_begin);
+                                        float highlight_x_end = highlight_x_start + advances.measure(match_begin, match_end);
+                                        draw_list->AddRectFilled(ImVec2(highlight_x_start, p.y), ImVec2(highlight_x_end, p.y + line_height_nodraw), IM_COL32(100, 100, 0, 100));
                                     }
-                                    end_token++;
-                                }
-                                current_color = syntaxColors.string_literal;
-                            }
-                            else if (isdigit(c)) {
-                                end_token = start_token;
-                                while (end_token < line.length() && (isdigit(line[end_token]) || line[end_token] == '.')) {
-                                    end_token++;
                                 }
-                                current_color = syntaxColors.number_literal;
-                            }
-                            else if (isalpha(c) || c == '_') {
-                                end_token = start_token;
-                                while (end_token < line.length() && (isalnum(line[end_token]) || line[end_token] == '_')) {
-                                    end_token++;
-                                }
-                                std::string token = line.substr(start_token, end_token - start_token);
-                                if (cppKeywords.count(token)) {
-                                    current_color = syntaxColors.keyword;
-                                }
-                            }
-                            else {
-                                end_token = start_token + 1;
                             }
-                        }
-
-                        std::string token_str = line.substr(start_token, end_token - start_token);
-                        ImGui::PushStyleColor(ImGuiCol_Text, current_color);
-                        ImGui::TextUnformatted(token_str.c_str());
-                        ImGui::PopStyleColor();
 
-                        if (end_token < line.length()) {
-                            ImGui::SameLine(0, 0);
+                            ImDrawList* text_draw_list = ImGui::GetWindowDrawList();
+                            const ImVec2 text_pos = ImGui::GetCursorScreenPos();
+                            float run_x = text_pos.x;
+                            for (uint32_t r = current_doc.lineFirstRun[line_idx]; r < current_doc.lineFirstRun[line_idx + 1]; ++r) {
+                                const TokenRun& run = current_doc.tokenRuns[r];
+                                const char* run_begin = line_begin + run.offset;
+                                const char* run_end = run_begin + run.length;
+                                text_draw_list->AddText(view_font, view_font_size, ImVec2(run_x, text_pos.y), class_colors[run.cls], run_begin, run_end);
+                                run_x += advances.measure(run_begin, run_end);
+                            }
+                            ImGui::Dummy(ImVec2(run_x - text_pos.x, ImGui::GetTextLineHeight()));
                         }
-                        current_pos = end_token;
                     }
-
-                    char_offset += line.length() + 1;
+                    clipper.End();
                 }
 
                 if (g_pCodeFont) ImGui::PopFont();
@@ -291,12 +312,19 @@ void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& docs, int& active
             }
         }
 
-        if (doc_to_close_idx != -1) {
-            docs.erase(docs.begin() + doc_to_close_idx);
-            in_multiline_comment_states.erase(in_multiline_comment_states.begin() + doc_to_close_idx);
-            if (active_doc_idx >= doc_to_close_idx) {
-                active_doc_idx = std::max(0, (int)docs.size() - 1);
-            }
+        // Failed loads, tab close buttons and File > Close all just clear
+        // `open`, so several tabs can go in the same frame.
+        bool active_closed = active_doc_idx >= 0 && active_doc_idx < (int)docs.size() && !docs[active_doc_idx].open;
+        int closed_before_active = 0;
+        for (int n = 0; n < active_doc_idx && n < (int)docs.size(); ++n) {
+            if (!docs[n].open) closed_before_active++;
+        }
+        docs.erase(std::remove_if(docs.begin(), docs.end(), [](const CodeDocument& doc) { return !doc.open; }), docs.end());
+        if (active_closed) {
+            active_doc_idx = std::max(0, (int)docs.size() - 1);
+        }
+        else {
+            active_doc_idx -= closed_before_active;
         }
         ImGui::EndTabBar();
     }
@@ -305,4 +333,7 @@ void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& docs, int& active
     }
 
     ImGui::End();
+
+    ShowFindInFilesPanel(&show_find_in_files, docs, active_doc_idx);
+    ShowProfilerOverlay(&show_profiler);
 }
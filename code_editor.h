@@ -2,38 +2,9 @@
 
 #include <string>
 #include <vector>
-#include <unordered_set>
 #include "imgui.h"
-
-struct SearchState {
-    char query[256] = "";
-    bool caseSensitive = false;
-    bool active = false;
-    int currentMatch = -1;
-    std::vector<size_t> matchPositions;
-
-    bool scrollToMatch = false;
-    int lineToScrollTo = -1;
-};
-
-struct CodeDocument {
-    std::string filePath;
-    std::string fileName;
-    std::string content;
-    std::string processedContent;
-    bool showComments = true;
-    int language = 0;
-    bool open = true;
-    SearchState searchState;
-
-    CodeDocument(std::string path = "", std::string name = "", std::string data = "")
-        : filePath(std::move(path)),
-        fileName(std::move(name)),
-        content(std::move(data)),
-        processedContent(content),
-        open(true)
-    {}
-};
+#include "code_document.h"
+#include "glyph_advance.h"
 
 struct SyntaxColors {
     ImVec4 keyword = ImVec4(0.20f, 0.60f, 0.90f, 1.0f);
@@ -48,10 +19,7 @@ struct SyntaxColors {
     ImVec4 default_text = ImVec4(0.90f, 0.91f, 0.92f, 1.0f);
 };
 
-extern const std::unordered_set<std::string> cppKeywords;
-extern const std::unordered_set<std::string> pythonKeywords;
-extern const std::unordered_set<std::string> jsKeywords;
-extern const std::unordered_set<std::string> cssKeywords;
-extern const std::unordered_set<std::string> htmlKeywords;
+const ImVec4& token_color(const SyntaxColors& colors, unsigned char cls);
+const GlyphAdvanceTable& font_advances(ImFont* font, float font_size);
 
 void ShowCodeViewerUI(bool* p_open, std::vector<CodeDocument>& documents, int& activeDocIndex);
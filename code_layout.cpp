@@ -0,0 +1,27 @@
+#include "code_layout.h"
+#include "code_document.h"
+#include "file_utils.h"
+#include "glyph_advance.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+
+void calculate_image_size(const CodeDocument& doc, const GlyphAdvanceTable& advances, float line_height, int& width_out, int& height_out, int line_num_width_pixels) {
+    PROFILE_SCOPE("layout");
+    width_out = 0;
+    height_out = 0;
+    if (!advances.valid()) return;
+
+    int line_count = document_line_count(doc);
+    float max_line_width = 0.0f;
+
+    std::string scratch;
+    for (int i = 0; i < line_count; ++i) {
+        std::string_view line = line_text(doc, i, scratch);
+        max_line_width = std::max(max_line_width, advances.measure(line.data(), line.data() + line.size()));
+    }
+    line_count = std::max(1, line_count);
+
+    width_out = line_num_width_pixels + (int)std::ceil(max_line_width);
+    height_out = (int)std::ceil((float)line_count * line_height);
+}
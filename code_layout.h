@@ -0,0 +1,6 @@
+#pragma once
+
+struct CodeDocument;
+class GlyphAdvanceTable;
+
+void calculate_image_size(const CodeDocument& doc, const GlyphAdvanceTable& advances, float line_height, int& width_out, int& height_out, int line_num_width_pixels);
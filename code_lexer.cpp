@@ -0,0 +1,50 @@
+#include "code_lexer.h"
+#include "code_document.h"
+#include "file_utils.h"
+#include "language_registry.h"
+#include "profiler.h"
+#include <algorithm>
+
+unsigned char lex_line(const char* line, size_t len, int lang, unsigned char state, std::vector<TokenRun>& runs_out) {
+    return languages().tables(lang).lex_line(line, len, state, runs_out);
+}
+
+void reset_lexer(CodeDocument& doc) {
+    doc.tokenRuns.clear();
+    doc.lineFirstRun.assign(1, 0);
+    doc.lineLexState.assign(1, LexState_Normal);
+}
+
+// Lexing is lazy and resumes from the last lexed line, so an edit only needs
+// to drop the lines from the first touched one; the next frame re-lexes down
+// to the visible end.
+void invalidate_lexed_lines(CodeDocument& doc, int first_line) {
+    int lexed = (int)doc.lineFirstRun.size() - 1;
+    if (first_line < 0 || first_line >= lexed) return;
+    doc.tokenRuns.resize(doc.lineFirstRun[first_line]);
+    doc.lineFirstRun.resize(first_line + 1);
+    doc.lineLexState.resize(first_line + 1);
+}
+
+void ensure_lexed(CodeDocument& doc, int line_end) {
+    if (doc.lineFirstRun.empty()) reset_lexer(doc);
+    int line_count = document_line_count(doc);
+    int lexed = (int)doc.lineFirstRun.size() - 1;
+    line_end = std::min(line_end, line_count);
+    if (lexed >= line_end) return;
+
+    PROFILE_SCOPE("lex");
+    const LexerTables& tables = languages().tables(doc.language);
+    std::string scratch;
+    unsigned char state = doc.lineLexState.back();
+    for (int i = lexed; i < line_end; ++i) {
+        std::string_view line = line_text(doc, i, scratch);
+        state = tables.lex_line(line.data(), line.size(), state, doc.tokenRuns);
+        doc.lineFirstRun.push_back((uint32_t)doc.tokenRuns.size());
+        doc.lineLexState.push_back(state);
+    }
+}
+
+void lex_document(CodeDocument& doc) {
+    ensure_lexed(doc, document_line_count(doc));
+}
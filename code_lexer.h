@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct CodeDocument;
+
+enum TokenClass : unsigned char {
+    Token_Default = 0,
+    Token_Keyword,
+    Token_Comment,
+    Token_String,
+    Token_Number,
+    Token_Preprocessor,
+    Token_Tag,
+    Token_Attribute,
+    Token_Selector,
+    Token_Property,
+    Token_Count
+};
+
+// Line-start states index the language's compiled LexerTables; 0 is the
+// top level of the file.
+enum LexState : unsigned char {
+    LexState_Normal = 0
+};
+
+struct TokenRun {
+    uint32_t offset;
+    uint32_t length;
+    unsigned char cls;
+};
+
+unsigned char lex_line(const char* line, size_t len, int lang, unsigned char state, std::vector<TokenRun>& runs_out);
+void reset_lexer(CodeDocument& doc);
+void invalidate_lexed_lines(CodeDocument& doc, int first_line);
+void ensure_lexed(CodeDocument& doc, int line_end);
+void lex_document(CodeDocument& doc);
@@ -0,0 +1,140 @@
+#include "code_render.h"
+#include "soft_raster.h"
+#include "file_utils.h"
+#include "profiler.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <mutex>
+
+const float CAPTURE_CLEAR_COLOR[4] = { 0.11f, 0.12f, 0.13f, 1.00f };
+
+static_assert(sizeof(ImDrawVert) == sizeof(SoftVertex), "ImDrawVert layout must match SoftVertex");
+static_assert(offsetof(ImDrawVert, uv) == offsetof(SoftVertex, u), "ImDrawVert layout must match SoftVertex");
+static_assert(offsetof(ImDrawVert, col) == offsetof(SoftVertex, col), "ImDrawVert layout must match SoftVertex");
+
+void render_code_to_drawlist(
+    ImDrawList* draw_list,
+    const CodeDocument& doc,
+    const SyntaxColors& colors,
+    ImFont* font,
+    float line_height,
+    int line_num_width_pixels,
+    const ImVec2& offset,
+    int first_line,
+    int line_end)
+{
+    if (!font || !draw_list) return;
+    PROFILE_SCOPE("draw_list");
+
+    int line_count = document_line_count(doc);
+    if (line_end < 0 || line_end > line_count) line_end = line_count;
+    first_line = std::max(0, first_line);
+    float current_y = offset.y + (float)first_line * line_height;
+
+    char line_no_fmt[16];
+    int max_digits = (int)log10(max_line_number(doc)) + 1;
+    snprintf(line_no_fmt, sizeof(line_no_fmt), "%%-%dd | ", max_digits);
+
+    ImU32 class_colors[Token_Count];
+    for (int c = 0; c < Token_Count; ++c) class_colors[c] = ImGui::ColorConvertFloat4ToU32(token_color(colors, (unsigned char)c));
+    ImU32 col_linenum = ImGui::ColorConvertFloat4ToU32(ImVec4(0.5f, 0.5f, 0.5f, 1.0f)); 
+    const GlyphAdvanceTable& advances = font_advances(font, font->FontSize);
+
+    std::string line_scratch;
+    for (int line_idx = first_line; line_idx < line_end; ++line_idx) {
+        float current_x = offset.x;
+        const char* line_begin = line_text(doc, line_idx, line_scratch).data();
+
+        char line_num_str[16];
+        snprintf(line_num_str, sizeof(line_num_str), line_no_fmt, original_line(doc, line_idx) + 1);
+        draw_list->AddText(font, font->FontSize, ImVec2(current_x, current_y), col_linenum, line_num_str);
+        current_x += (float)line_num_width_pixels;
+
+        for (uint32_t r = doc.lineFirstRun[line_idx]; r < doc.lineFirstRun[line_idx + 1]; ++r) {
+            const TokenRun& run = doc.tokenRuns[r];
+            const char* run_begin = line_begin + run.offset;
+            const char* run_end = run_begin + run.length;
+            draw_list->AddText(font, font->FontSize, ImVec2(current_x, current_y), class_colors[run.cls], run_begin, run_end);
+            current_x += advances.measure(run_begin, run_end);
+        }
+
+        current_y += line_height; 
+    } 
+}
+
+bool rasterize_code_tile(
+    const CodeDocument& doc,
+    const SyntaxColors& colors,
+    ImFont* font,
+    float line_height,
+    int line_num_width_pixels,
+    float padding,
+    const CaptureTile& tile,
+    int width,
+    int tile_height,
+    std::vector<unsigned char>& rgba_out,
+    int thread_count)
+{
+    PROFILE_SCOPE("raster");
+    ImGuiIO& io = ImGui::GetIO();
+    SoftTexture atlas;
+    unsigned char* atlas_pixels = nullptr;
+    io.Fonts->GetTexDataAsRGBA32(&atlas_pixels, &atlas.width, &atlas.height);
+    atlas.rgba = atlas_pixels;
+    if (!atlas.rgba) return false;
+
+    rgba_out.resize((size_t)width * tile_height * 4);
+    SoftTarget target;
+    target.rgba = rgba_out.data();
+    target.width = width;
+    target.height = tile_height;
+    target.stride = (size_t)width * 4;
+    soft_clear(target, CAPTURE_CLEAR_COLOR);
+
+    int first_line = 0;
+    int line_end = 0;
+    capture_tile_lines(tile, document_line_count(doc), line_height, padding, first_line, line_end);
+
+    // ImGui's allocation hooks bump counters on the shared context, so draw
+    // lists are built and freed under a lock; only rasterization runs unlocked.
+    static std::mutex draw_list_mutex;
+    std::unique_lock<std::mutex> lock(draw_list_mutex);
+    ImDrawList* draw_list = IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData());
+    draw_list->_ResetForNewFrame();
+    draw_list->PushTextureID(io.Fonts->TexID);
+    draw_list->PushClipRect(ImVec2(0, 0), ImVec2((float)width, (float)tile_height), false);
+    render_code_to_drawlist(draw_list, doc, colors, font, line_height, line_num_width_pixels,
+        ImVec2(padding, padding - (float)tile.y), first_line, line_end);
+    draw_list->PopClipRect();
+    draw_list->PopTextureID();
+
+    SoftDrawList soft_list;
+    soft_list.vertices = reinterpret_cast<const SoftVertex*>(draw_list->VtxBuffer.Data);
+    soft_list.vertexCount = (size_t)draw_list->VtxBuffer.Size;
+    soft_list.indices = draw_list->IdxBuffer.Data;
+    soft_list.indexCount = (size_t)draw_list->IdxBuffer.Size;
+    soft_list.indexSize = (int)sizeof(ImDrawIdx);
+    for (const ImDrawCmd& cmd : draw_list->CmdBuffer) {
+        if (cmd.UserCallback || cmd.ElemCount == 0 || cmd.TextureId != io.Fonts->TexID) continue;
+        SoftDrawCmd soft_cmd;
+        soft_cmd.clipMinX = cmd.ClipRect.x;
+        soft_cmd.clipMinY = cmd.ClipRect.y;
+        soft_cmd.clipMaxX = cmd.ClipRect.z;
+        soft_cmd.clipMaxY = cmd.ClipRect.w;
+        soft_cmd.texture = &atlas;
+        soft_cmd.vtxOffset = cmd.VtxOffset;
+        soft_cmd.idxOffset = cmd.IdxOffset;
+        soft_cmd.elemCount = cmd.ElemCount;
+        soft_list.commands.push_back(soft_cmd);
+    }
+
+    lock.unlock();
+
+    soft_rasterize(soft_list, target, 0.0f, 0.0f, thread_count);
+    lock.lock();
+    IM_DELETE(draw_list);
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "code_editor.h"
+#include "capture_tiles.h"
+#include <vector>
+
+const int CAPTURE_PADDING = 10;
+const int CAPTURE_MAX_WIDTH = 8192;
+extern const float CAPTURE_CLEAR_COLOR[4];
+
+void render_code_to_drawlist(
+    ImDrawList* draw_list,
+    const CodeDocument& doc,
+    const SyntaxColors& colors,
+    ImFont* font,
+    float line_height,
+    int line_num_width_pixels,
+    const ImVec2& offset,
+    int first_line = 0,
+    int line_end = -1
+);
+
+bool rasterize_code_tile(
+    const CodeDocument& doc,
+    const SyntaxColors& colors,
+    ImFont* font,
+    float line_height,
+    int line_num_width_pixels,
+    float padding,
+    const CaptureTile& tile,
+    int width,
+    int tile_height,
+    std::vector<unsigned char>& rgba_out,
+    int thread_count = 0
+);
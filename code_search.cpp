@@ -0,0 +1,160 @@
+#include "code_search.h"
+#include "code_document.h"
+#include "search_kernel.h"
+#include "regex_dfa.h"
+#include "file_utils.h"
+#include "document_edit.h"
+#include "profiler.h"
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+const size_t SEARCH_CHUNK_SIZE = 1 << 20;
+
+SearchJob::~SearchJob() {
+    cancelled = true;
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+static size_t find_matches(std::string_view text, size_t pos, size_t end, const std::string& query, bool case_sensitive,
+    RegexMatcher* regex, std::vector<size_t>& found, std::vector<uint32_t>& lengths)
+{
+    if (regex) {
+        return regex->find_all(text.data(), text.size(), pos, end, found, lengths);
+    }
+    pos = search_literal(text.data(), text.size(), pos, end, query.data(), query.size(), case_sensitive, found);
+    lengths.assign(found.size(), (uint32_t)query.size());
+    return pos;
+}
+
+static void publish_matches(SearchJob* job, const std::vector<size_t>& found, const std::vector<uint32_t>& lengths) {
+    if (found.empty()) return;
+    std::lock_guard<std::mutex> lock(job->resultsMutex);
+    job->pendingMatches.insert(job->pendingMatches.end(), found.begin(), found.end());
+    job->pendingLengths.insert(job->pendingLengths.end(), lengths.begin(), lengths.end());
+    job->matchesFound += found.size();
+}
+
+static void run_search_job(SearchJob* job, TextBufferPtr keep_alive, std::string_view text, std::string query,
+    bool case_sensitive, std::unique_ptr<RegexMatcher> regex)
+{
+    (void)keep_alive;
+    std::vector<size_t> found;
+    std::vector<uint32_t> lengths;
+    size_t pos = 0;
+    while (pos < text.size() && !job->cancelled.load(std::memory_order_relaxed)) {
+        PROFILE_SCOPE("search");
+        size_t chunk_end = std::min(text.size(), pos + SEARCH_CHUNK_SIZE);
+        found.clear();
+        lengths.clear();
+        pos = find_matches(text, pos, chunk_end, query, case_sensitive, regex.get(), found, lengths);
+        publish_matches(job, found, lengths);
+        job->bytesScanned = std::min(pos, text.size());
+    }
+    job->finished = true;
+    request_frame(FrameReason_Job);
+}
+
+// The stripped view has no contiguous text, so whole kept lines are gathered
+// into a chunk buffer and searched there; a match never spans a chunk because
+// chunks end on a newline, which literal queries cannot contain.
+static void run_stripped_search_job(SearchJob* job, StrippedViewPtr view, std::string query,
+    bool case_sensitive, std::unique_ptr<RegexMatcher> regex)
+{
+    std::vector<size_t> found;
+    std::vector<uint32_t> lengths;
+    std::string chunk;
+    std::string scratch;
+    size_t line = 0;
+    while (line < view->line_count() && !job->cancelled.load(std::memory_order_relaxed)) {
+        PROFILE_SCOPE("search");
+        size_t chunk_base = view->line_offset(line);
+        chunk.clear();
+        while (line < view->line_count() && chunk.size() < SEARCH_CHUNK_SIZE) {
+            chunk.append(view->line(line++, scratch));
+            chunk += '\n';
+        }
+        found.clear();
+        lengths.clear();
+        find_matches(chunk, 0, chunk.size(), query, case_sensitive, regex.get(), found, lengths);
+        for (size_t& offset : found) offset += chunk_base;
+        publish_matches(job, found, lengths);
+        job->bytesScanned = chunk_base + chunk.size();
+    }
+    job->finished = true;
+    request_frame(FrameReason_Job);
+}
+
+void PerformSearch(CodeDocument& doc) {
+    CancelSearch(doc);
+    doc.searchState.regexError.clear();
+    size_t query_len = strlen(doc.searchState.query);
+    if (query_len == 0) {
+        return;
+    }
+
+    std::string query(doc.searchState.query, query_len);
+    std::unique_ptr<RegexMatcher> regex;
+    if (doc.searchState.useRegex) {
+        regex.reset(new RegexMatcher());
+        if (!regex->compile(query, doc.searchState.caseSensitive, doc.searchState.regexError)) {
+            return;
+        }
+    }
+
+    std::shared_ptr<SearchJob> job = std::make_shared<SearchJob>();
+    if (doc.strippedView) {
+        job->bytesTotal = doc.stripped->size();
+        job->worker = std::thread(run_stripped_search_job, job.get(), doc.stripped,
+            std::move(query), doc.searchState.caseSensitive, std::move(regex));
+    }
+    else {
+        TextBufferPtr buffer = document_text(doc);
+        job->bytesTotal = buffer->size();
+        job->worker = std::thread(run_search_job, job.get(), buffer, buffer->view(),
+            std::move(query), doc.searchState.caseSensitive, std::move(regex));
+    }
+    doc.searchState.job = std::move(job);
+}
+
+void CancelSearch(CodeDocument& doc) {
+    doc.searchState.job.reset();
+    doc.searchState.matchPositions.clear();
+    doc.searchState.matchLengths.clear();
+    doc.searchState.matchLines.clear();
+    doc.searchState.currentMatch = -1;
+}
+
+bool UpdateSearch(CodeDocument& doc) {
+    SearchJob* job = doc.searchState.job.get();
+    if (!job) return false;
+
+    bool finished = job->finished.load();
+    {
+        std::lock_guard<std::mutex> lock(job->resultsMutex);
+        std::vector<size_t>& matches = doc.searchState.matchPositions;
+        std::vector<uint32_t>& lengths = doc.searchState.matchLengths;
+        std::vector<int>& lines = doc.searchState.matchLines;
+        size_t first_new = matches.size();
+        matches.insert(matches.end(), job->pendingMatches.begin(), job->pendingMatches.end());
+        lengths.insert(lengths.end(), job->pendingLengths.begin(), job->pendingLengths.end());
+        job->pendingMatches.clear();
+        job->pendingLengths.clear();
+
+        lines.reserve(matches.size());
+        for (size_t i = first_new; i < matches.size(); ++i) {
+            lines.push_back(line_from_offset(doc, matches[i]));
+        }
+    }
+    if (finished) {
+        doc.searchState.job.reset();
+        if (doc.searchState.pendingMatch >= 0 && !doc.searchState.matchPositions.empty()) {
+            doc.searchState.currentMatch = std::min(doc.searchState.pendingMatch, (int)doc.searchState.matchPositions.size() - 1);
+        }
+        doc.searchState.pendingMatch = -1;
+    }
+    return !finished;
+}
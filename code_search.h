@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct CodeDocument;
+
+struct SearchJob {
+    std::atomic<bool> cancelled{ false };
+    std::atomic<bool> finished{ false };
+    std::atomic<size_t> matchesFound{ 0 };
+    std::atomic<size_t> bytesScanned{ 0 };
+    size_t bytesTotal = 0;
+
+    std::mutex resultsMutex;
+    std::vector<size_t> pendingMatches;
+    std::vector<uint32_t> pendingLengths;
+    std::thread worker;
+
+    ~SearchJob();
+};
+
+void PerformSearch(CodeDocument& doc);
+void CancelSearch(CodeDocument& doc);
+bool UpdateSearch(CodeDocument& doc);
@@ -0,0 +1,45 @@
+#include "document_edit.h"
+#include "code_document.h"
+#include "code_lexer.h"
+#include "code_search.h"
+#include "file_utils.h"
+#include "piece_table.h"
+
+static bool begin_edit(CodeDocument& doc) {
+    if (doc.strippedView || doc.loadJob) return false;
+    if (!doc.pieces) {
+        doc.pieces = std::make_shared<PieceTable>(doc.source);
+        doc.content = std::string_view();
+        std::vector<size_t>().swap(doc.lineOffsets);
+        doc.stripped.reset();
+    }
+    CancelSearch(doc);
+    return true;
+}
+
+bool insert_text(CodeDocument& doc, size_t offset, std::string_view text) {
+    if (!begin_edit(doc)) return false;
+    offset = std::min(offset, doc.pieces->size());
+    invalidate_lexed_lines(doc, line_from_offset(doc, offset));
+    doc.pieces->insert(offset, text);
+    return true;
+}
+
+bool erase_text(CodeDocument& doc, size_t offset, size_t length) {
+    if (!begin_edit(doc)) return false;
+    invalidate_lexed_lines(doc, line_from_offset(doc, offset));
+    doc.pieces->erase(offset, length);
+    return true;
+}
+
+void flatten_edits(CodeDocument& doc) {
+    if (!doc.pieces) return;
+    doc.source = make_text_buffer(doc.pieces->text());
+    doc.pieces.reset();
+    doc.content = doc.source->view();
+    build_line_index(doc);
+}
+
+TextBufferPtr document_text(const CodeDocument& doc) {
+    return doc.pieces ? make_text_buffer(doc.pieces->text()) : doc.source;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string_view>
+#include "text_buffer.h"
+
+struct CodeDocument;
+
+// Edits address the original text and are rejected while the stripped view is
+// shown or the document is still loading. The first edit moves the document
+// onto a PieceTable; process_code folds the edits back into a flat buffer.
+bool insert_text(CodeDocument& doc, size_t offset, std::string_view text);
+bool erase_text(CodeDocument& doc, size_t offset, size_t length);
+void flatten_edits(CodeDocument& doc);
+TextBufferPtr document_text(const CodeDocument& doc);
@@ -0,0 +1,182 @@
+#include "document_loader.h"
+#include "code_document.h"
+#include "file_utils.h"
+#include "work_pool.h"
+#include "code_search.h"
+#include "profiler.h"
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+const int MAX_LOADER_THREADS = 4;
+const size_t COMPARE_BLOCK_SIZE = 4096;
+
+static WorkStealingPool& loader_pool() {
+    static WorkStealingPool pool(std::max(1, std::min(MAX_LOADER_THREADS, (int)std::thread::hardware_concurrency())));
+    return pool;
+}
+
+std::shared_ptr<const FileSnapshot> make_file_snapshot(const std::string& path, std::string_view text) {
+    std::shared_ptr<FileSnapshot> snapshot = std::make_shared<FileSnapshot>();
+    std::error_code ec;
+    snapshot->size = text.size();
+    snapshot->mtime = std::filesystem::last_write_time(path, ec);
+    return snapshot;
+}
+
+static void run_load_job(const std::shared_ptr<LoadJob>& job) {
+    PROFILE_SCOPE("load");
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(job->path, ec);
+    if (!ec) job->bytesTotal = (size_t)size;
+
+    TextBufferPtr buffer;
+    if (load_file_buffer(job->path.c_str(), buffer, job->error, &job->bytesLoaded)) {
+        std::string name = job->path.substr(job->path.find_last_of("/\\") + 1);
+        std::unique_ptr<CodeDocument> doc(new CodeDocument(job->path, name, std::move(buffer)));
+        doc->language = detect_lang(name);
+        doc->showComments = job->showComments;
+        doc->diskSnapshot = make_file_snapshot(job->path, doc->content);
+        process_code(*doc);
+        job->document = std::move(doc);
+    }
+    job->finished.store(true, std::memory_order_release);
+    request_frame(FrameReason_Job);
+}
+
+void BeginLoadDocument(CodeDocument& doc) {
+    std::shared_ptr<LoadJob> job = std::make_shared<LoadJob>();
+    job->path = doc.filePath;
+    job->showComments = doc.showComments;
+    doc.loadJob = job;
+    loader_pool().submit([job](int) { run_load_job(job); });
+}
+
+// Swaps the loaded document into the placeholder. Tab state and any pending
+// scroll request made while the file was loading are carried over.
+bool UpdateLoad(CodeDocument& doc, std::string& error_out) {
+    if (!doc.loadJob || !doc.loadJob->finished.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    std::shared_ptr<LoadJob> job = std::move(doc.loadJob);
+    if (!job->document) {
+        error_out = job->error.empty() ? "Cannot open file" : job->error;
+        return true;
+    }
+
+    CodeDocument& loaded = *job->document;
+    loaded.open = doc.open;
+    loaded.selectTab = doc.selectTab;
+    loaded.searchState.active = doc.searchState.active;
+    loaded.searchState.scrollToMatch = doc.searchState.scrollToMatch;
+    loaded.searchState.lineToScrollTo = doc.searchState.lineToScrollTo;
+    doc = std::move(loaded);
+    return true;
+}
+
+float LoadProgress(const CodeDocument& doc) {
+    if (!doc.loadJob) return 1.0f;
+    size_t total = doc.loadJob->bytesTotal.load(std::memory_order_relaxed);
+    if (total == 0) return 0.0f;
+    return std::min(1.0f, (float)doc.loadJob->bytesLoaded.load(std::memory_order_relaxed) / (float)total);
+}
+
+static size_t common_prefix_length(std::string_view a, std::string_view b) {
+    size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i + COMPARE_BLOCK_SIZE <= n && memcmp(a.data() + i, b.data() + i, COMPARE_BLOCK_SIZE) == 0) i += COMPARE_BLOCK_SIZE;
+    while (i < n && a[i] == b[i]) i++;
+    return i;
+}
+
+static size_t common_suffix_length(std::string_view a, std::string_view b, size_t limit) {
+    const char* a_end = a.data() + a.size();
+    const char* b_end = b.data() + b.size();
+    size_t i = 0;
+    while (i + COMPARE_BLOCK_SIZE <= limit && memcmp(a_end - i - COMPARE_BLOCK_SIZE, b_end - i - COMPARE_BLOCK_SIZE, COMPARE_BLOCK_SIZE) == 0) {
+        i += COMPARE_BLOCK_SIZE;
+    }
+    while (i < limit && a_end[-(ptrdiff_t)i - 1] == b_end[-(ptrdiff_t)i - 1]) i++;
+    return i;
+}
+
+// Runs on the loader pool. An unchanged size and mtime skips the read; else
+// the new text is compared byte for byte with the document's current text to
+// find the common prefix and suffix. A mapped document whose file was
+// rewritten in place already shows the new bytes, so its old text cannot be
+// compared and the whole index is rebuilt instead.
+static void run_reload_job(const std::shared_ptr<ReloadJob>& job) {
+    PROFILE_SCOPE("reload");
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(job->path, ec);
+    std::filesystem::file_time_type mtime = std::filesystem::last_write_time(job->path, ec);
+    if (ec) {
+        job->error = "Cannot read file: " + ec.message();
+    }
+    else if (job->previous && job->previous->size == size && job->previous->mtime == mtime) {
+        job->unchanged = true;
+    }
+    else {
+        bool stale_view = job->previousText && job->previousText->maps_file(job->path.c_str());
+        if (load_file_buffer(job->path.c_str(), job->source, job->error)) {
+            job->snapshot = make_file_snapshot(job->path, job->source->view());
+            if (job->previousText && !stale_view) {
+                std::string_view before = job->previousText->view();
+                std::string_view after = job->source->view();
+                job->commonPrefix = common_prefix_length(before, after);
+                size_t common = std::min(before.size(), after.size());
+                job->commonSuffix = common_suffix_length(before, after, common - job->commonPrefix);
+                job->unchanged = before.size() == after.size() && job->commonPrefix == common;
+            }
+        }
+    }
+    job->finished.store(true, std::memory_order_release);
+    request_frame(FrameReason_Job);
+}
+
+void BeginReloadDocument(CodeDocument& doc) {
+    if (doc.loadJob || doc.reloadJob) return;
+    std::shared_ptr<ReloadJob> job = std::make_shared<ReloadJob>();
+    job->path = doc.filePath;
+    job->previous = doc.diskSnapshot;
+    if (!doc.pieces) job->previousText = doc.source;
+    doc.reloadJob = job;
+    loader_pool().submit([job](int) { run_reload_job(job); });
+}
+
+// Applies a finished reload in place: only the changed range is re-indexed,
+// lexing restarts at the first changed line, and an open search is re-run
+// with its query while the tab keeps its scroll position.
+bool UpdateReload(CodeDocument& doc, std::string& error_out) {
+    if (!doc.reloadJob || !doc.reloadJob->finished.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    std::shared_ptr<ReloadJob> job = std::move(doc.reloadJob);
+    if (job->snapshot) doc.diskSnapshot = job->snapshot;
+    if (!job->error.empty()) {
+        error_out = job->error;
+        return false;
+    }
+    if (job->unchanged || !job->source) {
+        return false;
+    }
+    if (doc.pieces) {
+        error_out = "The file changed on disk but the document has unsaved edits.";
+        return false;
+    }
+
+    replace_document_text(doc, std::move(job->source), job->commonPrefix, job->commonSuffix);
+    if (doc.searchState.active && doc.searchState.query[0]) {
+        int current = doc.searchState.currentMatch;
+        PerformSearch(doc);
+        doc.searchState.pendingMatch = current;
+    }
+    else {
+        CancelSearch(doc);
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "text_buffer.h"
+
+struct CodeDocument;
+
+struct LoadJob {
+    std::atomic<bool> finished{ false };
+    std::atomic<size_t> bytesLoaded{ 0 };
+    std::atomic<size_t> bytesTotal{ 0 };
+
+    std::string path;
+    bool showComments = true;
+
+    // Written by the loader thread before `finished` is released.
+    std::string error;
+    std::unique_ptr<CodeDocument> document;
+};
+
+// Size and mtime of a file as last read; a reload whose stat matches skips
+// reading the file at all.
+struct FileSnapshot {
+    uintmax_t size = 0;
+    std::filesystem::file_time_type mtime;
+};
+
+struct ReloadJob {
+    std::atomic<bool> finished{ false };
+
+    std::string path;
+    std::shared_ptr<const FileSnapshot> previous;
+    TextBufferPtr previousText;
+
+    // Written by the loader thread before `finished` is released.
+    bool unchanged = false;
+    std::string error;
+    TextBufferPtr source;
+    std::shared_ptr<const FileSnapshot> snapshot;
+    size_t commonPrefix = 0;
+    size_t commonSuffix = 0;
+};
+
+std::shared_ptr<const FileSnapshot> make_file_snapshot(const std::string& path, std::string_view text);
+
+void BeginLoadDocument(CodeDocument& doc);
+bool UpdateLoad(CodeDocument& doc, std::string& error_out);
+float LoadProgress(const CodeDocument& doc);
+
+void BeginReloadDocument(CodeDocument& doc);
+bool UpdateReload(CodeDocument& doc, std::string& error_out);
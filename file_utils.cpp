@@ -1,139 +1,230 @@
 #include "file_utils.h"
-#include "code_editor.h" 
-#include "tinyfiledialogs.h"
+#include "code_document.h"
+#include "code_lexer.h"
+#include "code_search.h"
+#include "document_edit.h"
+#include "language_registry.h"
+#include "piece_table.h"
+#include "stripped_view.h"
 #include <fstream>
-#include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 
-bool load_file_str(const char* path, std::string& content_out) {
+const long long MAP_THRESHOLD = 4LL * 1024 * 1024;
+const size_t LOAD_CHUNK_SIZE = 1 << 20;
+
+bool load_file_buffer(const char* path, TextBufferPtr& buffer_out, std::string& error_out, std::atomic<size_t>* bytes_loaded) {
     std::ifstream file(path, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
-        tinyfd_messageBox("Error", "Cannot open file", "ok", "error", 1);
+        error_out = "Cannot open file";
         return false;
     }
     std::streamsize len = file.tellg();
     file.seekg(0, std::ios::beg);
 
-    const long long max_size = 20LL * 1024 * 1024; 
-    if (len > max_size || len < 0) {
-        tinyfd_messageBox("Error", "File is too large (>20MB) or size is invalid.", "ok", "error", 1);
-        file.close();
+    if (len < 0) {
+        error_out = "File size is invalid.";
         return false;
     }
 
+#ifndef _WIN32
+    // A mapping that cannot be made (or guarded) falls back to a plain read.
+    if (len >= MAP_THRESHOLD) {
+        std::shared_ptr<TextBuffer> mapped = std::make_shared<TextBuffer>();
+        std::string map_error;
+        if (mapped->map_file(path, map_error)) {
+            if (bytes_loaded) *bytes_loaded = mapped->size();
+            buffer_out = std::move(mapped);
+            return true;
+        }
+    }
+#endif
+
+    std::string content;
     try {
-        content_out.resize(static_cast<size_t>(len));
-        if (len > 0) {
-            file.read(&content_out[0], len);
+        content.resize(static_cast<size_t>(len));
+        size_t loaded = 0;
+        while (loaded < content.size() && file) {
+            size_t chunk = std::min(LOAD_CHUNK_SIZE, content.size() - loaded);
+            file.read(&content[loaded], (std::streamsize)chunk);
+            loaded += (size_t)file.gcount();
+            if (bytes_loaded) *bytes_loaded = loaded;
         }
+        content.resize(loaded);
     }
     catch (const std::exception& e) {
-        tinyfd_messageBox("Error", e.what(), "ok", "error", 1);
-        file.close();
+        error_out = e.what();
         return false;
     }
-    file.close();
+    buffer_out = make_text_buffer(std::move(content));
     return true;
 }
 
-
 int detect_lang(const std::string& fname) {
-    size_t dot_pos = fname.find_last_of(".");
-    if (dot_pos == std::string::npos) return -1;
-    std::string ext = fname.substr(dot_pos + 1);
-    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
-    if (ext == "cpp" || ext == "h" || ext == "hpp" || ext == "cxx" || ext == "hxx" || ext == "c") return 0;
-    if (ext == "py" || ext == "pyw") return 1;
-    if (ext == "html" || ext == "htm") return 2;
-    if (ext == "css") return 3;
-    if (ext == "js") return 4;
-    return -1; 
+    return languages().find_by_file_name(fname);
 }
 
-std::string strip_comments(const std::string& code, int lang) {
-    std::string result = "";
-    std::stringstream ss(code);
-    std::string line;
-    bool in_multi_comment = false;
-
-    while (std::getline(ss, line)) {
-        std::string processed_line = "";
-        bool line_had_content = false;
-
-        if (lang == 0 || lang == 4 || lang == 3) { 
-            size_t current_pos = 0;
-            while (current_pos < line.length()) {
-                if (in_multi_comment) {
-                    size_t end_comment = line.find("*/", current_pos);
-                    if (end_comment != std::string::npos) {
-                        current_pos = end_comment + 2;
-                        in_multi_comment = false;
-                    }
-                    else {
-                        break;
-                    }
-                }
-                else {
-                    size_t single_comment = (lang == 0 || lang == 4) ? line.find("//", current_pos) : std::string::npos;
-                    size_t multi_comment_start = line.find("/*", current_pos);
-                    size_t next_comment_start = std::min(single_comment, multi_comment_start);
-
-                    if (next_comment_start == std::string::npos) {
-                        processed_line += line.substr(current_pos);
-                        if (line.substr(current_pos).find_first_not_of(" \t\r\n") != std::string::npos) line_had_content = true;
-                        break;
-                    }
-
-                    processed_line += line.substr(current_pos, next_comment_start - current_pos);
-                    if (line.substr(current_pos, next_comment_start - current_pos).find_first_not_of(" \t\r\n") != std::string::npos) line_had_content = true;
-
-                    if (next_comment_start == single_comment) {
-                        break;
-                    }
-                    else {
-                        size_t end_comment = line.find("*/", next_comment_start + 2);
-                        if (end_comment != std::string::npos) {
-                            current_pos = end_comment + 2;
-                        }
-                        else {
-                            in_multi_comment = true;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-        else if (lang == 1) { 
-            size_t comment_pos = line.find("#");
-            processed_line += line.substr(0, comment_pos);
-            if (processed_line.find_first_not_of(" \t\r\n") != std::string::npos) line_had_content = true;
-        }
-        else {
-            processed_line += line;
-            if (processed_line.find_first_not_of(" \t\r\n") != std::string::npos) line_had_content = true;
-        }
+void strip_comments(std::string_view code, int lang, std::string& out) {
+    StrippedView(code, lang).copy(out);
+}
 
-        size_t endpos = processed_line.find_last_not_of(" \t\r\n");
-        if (std::string::npos != endpos) {
-            processed_line = processed_line.substr(0, endpos + 1);
-        }
-        else {
-            processed_line.clear();
-        }
+// The stripped view is built once per document as ranges over the original
+// text and cached, so toggling comments afterwards costs only a lexer reset.
+void process_code(CodeDocument& doc) {
+    CancelSearch(doc);
+    flatten_edits(doc);
+    if (doc.lineOffsets.empty()) {
+        build_line_index(doc);
+    }
+    doc.strippedView = !doc.showComments;
+    if (doc.strippedView && !doc.stripped) {
+        doc.stripped = std::make_shared<const StrippedView>(doc.content, doc.language, doc.source);
+    }
+    reset_lexer(doc);
+}
 
-        if (!processed_line.empty() || line_had_content) {
-            result += processed_line + "\n";
-        }
+int original_line(const CodeDocument& doc, int line) {
+    if (!doc.strippedView) return line;
+    if (doc.stripped->line_count() == 0) return 0;
+    size_t kept = std::min((size_t)std::max(line, 0), doc.stripped->line_count() - 1);
+    auto it = std::upper_bound(doc.lineOffsets.begin(), doc.lineOffsets.end(), doc.stripped->source_offset(kept));
+    return (int)(it - doc.lineOffsets.begin()) - 1;
+}
+
+int line_from_original(const CodeDocument& doc, int original) {
+    if (!doc.strippedView) return original;
+    if (doc.stripped->line_count() == 0 || doc.lineOffsets.empty()) return 0;
+    original = std::max(0, std::min(original, (int)doc.lineOffsets.size() - 1));
+    size_t kept = doc.stripped->line_from_source(doc.lineOffsets[original]);
+    return (int)std::min(kept, doc.stripped->line_count() - 1);
+}
+
+int max_line_number(const CodeDocument& doc) {
+    if (doc.strippedView) {
+        size_t kept = doc.stripped->line_count();
+        return kept == 0 ? 1 : original_line(doc, (int)kept - 1) + 1;
     }
-    return result;
+    return document_line_count(doc);
 }
 
-void process_code(CodeDocument& doc) {
-    if (doc.showComments) {
-        doc.processedContent = doc.content;
+void build_line_index(CodeDocument& doc) {
+    std::string_view text = doc.content;
+    doc.lineOffsets.clear();
+    doc.lineOffsets.push_back(0);
+
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* p = begin;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!nl || nl + 1 == end) break;
+        doc.lineOffsets.push_back(static_cast<size_t>(nl + 1 - begin));
+        p = nl + 1;
+    }
+}
+
+// Swaps in new text that matches the current one outside
+// [common_prefix, size - common_suffix). Line starts are rescanned only for
+// that range; the ones after it are shifted by the size change. Returns the
+// first changed line of the original text.
+int replace_document_text(CodeDocument& doc, TextBufferPtr source, size_t common_prefix, size_t common_suffix) {
+    std::string_view text = source->view();
+    std::vector<size_t>& index = doc.lineOffsets;
+    int first_line = 0;
+    if (index.empty()) {
+        common_prefix = common_suffix = 0;
     }
     else {
-        doc.processedContent = strip_comments(doc.content, doc.language);
+        first_line = (int)(std::upper_bound(index.begin(), index.end(), common_prefix) - index.begin()) - 1;
+    }
+    long long delta = (long long)text.size() - (long long)doc.content.size();
+    size_t suffix_start = text.size() - common_suffix;
+
+    std::vector<size_t> rebuilt(index.begin(), index.begin() + (index.empty() ? 0 : first_line + 1));
+    if (rebuilt.empty()) rebuilt.push_back(0);
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* p = begin + rebuilt.back();
+    size_t joined = 0;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!nl || nl + 1 == end) break;
+        p = nl + 1;
+        size_t start = (size_t)(p - begin);
+        rebuilt.push_back(start);
+        if (common_suffix > 0 && start >= suffix_start) {
+            joined = start;
+            break;
+        }
+    }
+    if (joined) {
+        auto tail = std::upper_bound(index.begin(), index.end(), (size_t)((long long)joined - delta));
+        for (; tail != index.end(); ++tail) rebuilt.push_back((size_t)((long long)*tail + delta));
+    }
+    index.swap(rebuilt);
+
+    doc.source = std::move(source);
+    doc.content = doc.source->view();
+    doc.stripped.reset();
+    if (doc.strippedView) {
+        doc.stripped = std::make_shared<const StrippedView>(doc.content, doc.language, doc.source);
+    }
+    invalidate_lexed_lines(doc, line_from_original(doc, first_line));
+    return first_line;
+}
+
+int line_from_offset(const CodeDocument& doc, size_t offset) {
+    if (doc.strippedView) return (int)doc.stripped->line_from_offset(offset);
+    if (doc.pieces) return (int)doc.pieces->line_of(offset);
+    if (doc.lineOffsets.empty()) return 0;
+    auto it = std::upper_bound(doc.lineOffsets.begin(), doc.lineOffsets.end(), offset);
+    return static_cast<int>(it - doc.lineOffsets.begin()) - 1;
+}
+
+// Line access for the active view. The stripped view answers from its ranges;
+// an edited document has no flat text or lineOffsets and its piece table
+// answers in O(log pieces), with a trailing newline not starting a line.
+int document_line_count(const CodeDocument& doc) {
+    if (doc.strippedView) return std::max(1, (int)doc.stripped->line_count());
+    if (doc.pieces) {
+        size_t newlines = doc.pieces->newline_count();
+        size_t size = doc.pieces->size();
+        if (size > 0 && doc.pieces->char_at(size - 1) == '\n') newlines--;
+        return (int)newlines + 1;
+    }
+    return std::max(1, (int)doc.lineOffsets.size());
+}
+
+size_t line_start_offset(const CodeDocument& doc, int line) {
+    if (doc.strippedView) return (size_t)line < doc.stripped->line_count() ? doc.stripped->line_offset(line) : 0;
+    if (doc.pieces) return doc.pieces->line_start(line);
+    return doc.lineOffsets.empty() ? 0 : doc.lineOffsets[line];
+}
+
+std::string_view line_text(const CodeDocument& doc, int line, std::string& scratch) {
+    if (doc.strippedView) return doc.stripped->line(line, scratch);
+    size_t start = line_start_offset(doc, line);
+    size_t end = line_end_offset(doc, line);
+    if (doc.pieces) return doc.pieces->view(start, end, scratch);
+    return doc.content.substr(start, end - start);
+}
+
+size_t line_end_offset(const CodeDocument& doc, int line) {
+    if (doc.strippedView) {
+        if ((size_t)line >= doc.stripped->line_count()) return 0;
+        return doc.stripped->line_offset(line) + doc.stripped->line_length(line);
+    }
+    if (doc.pieces) {
+        size_t size = doc.pieces->size();
+        size_t start = doc.pieces->line_start(line);
+        size_t end = (size_t)line < doc.pieces->newline_count() ? doc.pieces->line_start(line + 1) - 1 : size;
+        if (end == size && end > start && doc.pieces->char_at(end - 1) == '\n') end--;
+        return end;
     }
+    if (doc.lineOffsets.empty()) return 0;
+    std::string_view text = doc.content;
+    size_t end = (line + 1 < (int)doc.lineOffsets.size()) ? doc.lineOffsets[line + 1] - 1 : text.size();
+    if (end == text.size() && end > doc.lineOffsets[line] && text[end - 1] == '\n') end--;
+    return end;
 }
@@ -1,11 +1,27 @@
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <string_view>
+#include <vector>
+#include "text_buffer.h"
 
 struct CodeDocument;
 
-bool load_file_str(const char* path, std::string& content_out);
+bool load_file_buffer(const char* path, TextBufferPtr& buffer_out, std::string& error_out, std::atomic<size_t>* bytes_loaded = nullptr);
 
 int detect_lang(const std::string& fname);
-std::string strip_comments(const std::string& code, int lang);
+void strip_comments(std::string_view code, int lang, std::string& out);
 void process_code(CodeDocument& doc);
+
+void build_line_index(CodeDocument& doc);
+int replace_document_text(CodeDocument& doc, TextBufferPtr source, size_t common_prefix, size_t common_suffix);
+int line_from_offset(const CodeDocument& doc, size_t offset);
+size_t line_end_offset(const CodeDocument& doc, int line);
+int document_line_count(const CodeDocument& doc);
+size_t line_start_offset(const CodeDocument& doc, int line);
+std::string_view line_text(const CodeDocument& doc, int line, std::string& scratch);
+
+int original_line(const CodeDocument& doc, int line);
+int line_from_original(const CodeDocument& doc, int original);
+int max_line_number(const CodeDocument& doc);
@@ -0,0 +1,430 @@
+#include "file_watcher.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#endif
+
+const int BATCH_QUIET_MS = 100;
+
+typedef std::chrono::steady_clock WatchClock;
+
+std::string FileWatcher::normalize_path(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+    std::string normal = (ec ? std::filesystem::path(path) : absolute).lexically_normal().make_preferred().string();
+#ifdef _WIN32
+    std::transform(normal.begin(), normal.end(), normal.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+    return normal;
+}
+
+static std::string parent_directory(const std::string& normalized) {
+    return std::filesystem::path(normalized).parent_path().string();
+}
+
+void FileWatcher::watch(const std::string& path) {
+    std::string normal = normalize_path(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (files_[normal]++ > 0) return;
+        directories_[parent_directory(normal)]++;
+    }
+    wake();
+}
+
+void FileWatcher::unwatch(const std::string& path) {
+    std::string normal = normalize_path(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto file = files_.find(normal);
+        if (file == files_.end() || --file->second > 0) return;
+        files_.erase(file);
+        auto dir = directories_.find(parent_directory(normal));
+        if (dir != directories_.end() && --dir->second == 0) directories_.erase(dir);
+        published_.erase(normal);
+    }
+    wake();
+}
+
+std::vector<std::string> FileWatcher::take_changes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> changes(published_.begin(), published_.end());
+    published_.clear();
+    hasChanges_.store(false, std::memory_order_release);
+    return changes;
+}
+
+// Directories that have not been synced yet count as watched, so a newly
+// opened file does not flash as unwatched for a frame.
+bool FileWatcher::is_watched(const std::string& path) {
+    std::string normal = normalize_path(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return files_.count(normal) && !unwatched_.count(parent_directory(normal));
+}
+
+// Called on the watcher thread only.
+void FileWatcher::set_unwatched(std::set<std::string> directories) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unwatched_.swap(directories);
+}
+
+// Called on the watcher thread only.
+void FileWatcher::note_change(const std::string& path) {
+    std::string normal = normalize_path(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (files_.count(normal)) batch_.insert(normal);
+}
+
+void FileWatcher::publish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        published_.insert(batch_.begin(), batch_.end());
+        batch_.clear();
+        hasChanges_.store(true, std::memory_order_release);
+    }
+    if (onChange_) onChange_();
+}
+
+static int quiet_timeout_ms(bool batching, WatchClock::time_point last_event) {
+    if (!batching) return -1;
+    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(WatchClock::now() - last_event).count();
+    return (int)std::max(0LL, BATCH_QUIET_MS - elapsed);
+}
+
+#ifdef _WIN32
+
+const size_t NOTIFY_BUFFER_SIZE = 32 * 1024;
+
+struct DirectoryWatch {
+    std::string path;
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped = {};
+    DWORD buffer[NOTIFY_BUFFER_SIZE / sizeof(DWORD)];
+};
+
+struct FileWatcher::Platform {
+    HANDLE wakeEvent = nullptr;
+    std::map<std::string, std::unique_ptr<DirectoryWatch>> watches;
+};
+
+static bool issue_read(DirectoryWatch& watch) {
+    ResetEvent(watch.overlapped.hEvent);
+    return ReadDirectoryChangesW(watch.handle, watch.buffer, sizeof(watch.buffer), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+        nullptr, &watch.overlapped, nullptr) != 0;
+}
+
+static void close_watch(DirectoryWatch& watch) {
+    DWORD bytes = 0;
+    if (CancelIoEx(watch.handle, &watch.overlapped) || GetLastError() != ERROR_NOT_FOUND) {
+        GetOverlappedResult(watch.handle, &watch.overlapped, &bytes, TRUE);
+    }
+    CloseHandle(watch.handle);
+    CloseHandle(watch.overlapped.hEvent);
+}
+
+FileWatcher::FileWatcher(ChangeFn on_change)
+    : onChange_(std::move(on_change)),
+    platform_(new Platform())
+{
+    platform_->wakeEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    thread_ = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher() {
+    stopping_ = true;
+    wake();
+    thread_.join();
+    for (auto& entry : platform_->watches) close_watch(*entry.second);
+    CloseHandle(platform_->wakeEvent);
+}
+
+void FileWatcher::wake() {
+    SetEvent(platform_->wakeEvent);
+}
+
+void FileWatcher::sync_directories() {
+    std::map<std::string, int> wanted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wanted = directories_;
+    }
+    std::map<std::string, std::unique_ptr<DirectoryWatch>>& watches = platform_->watches;
+    for (auto it = watches.begin(); it != watches.end();) {
+        if (wanted.count(it->first)) {
+            ++it;
+            continue;
+        }
+        close_watch(*it->second);
+        it = watches.erase(it);
+    }
+    std::set<std::string> unwatched;
+    for (const auto& dir : wanted) {
+        if (watches.count(dir.first)) continue;
+        // WaitForMultipleObjects takes the wake event plus at most 63 directories.
+        if (watches.size() + 1 >= MAXIMUM_WAIT_OBJECTS) {
+            unwatched.insert(dir.first);
+            continue;
+        }
+        std::unique_ptr<DirectoryWatch> watch(new DirectoryWatch());
+        watch->path = dir.first;
+        watch->handle = CreateFileA(dir.first.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (watch->handle == INVALID_HANDLE_VALUE) {
+            unwatched.insert(dir.first);
+            continue;
+        }
+        watch->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        if (!issue_read(*watch)) {
+            CloseHandle(watch->handle);
+            CloseHandle(watch->overlapped.hEvent);
+            unwatched.insert(dir.first);
+            continue;
+        }
+        watches[dir.first] = std::move(watch);
+    }
+    set_unwatched(std::move(unwatched));
+}
+
+void FileWatcher::run() {
+    WatchClock::time_point last_event = WatchClock::now();
+    bool batching = false;
+    std::vector<HANDLE> handles;
+    std::vector<DirectoryWatch*> order;
+    while (!stopping_) {
+        handles.assign(1, platform_->wakeEvent);
+        order.clear();
+        for (auto& entry : platform_->watches) {
+            handles.push_back(entry.second->overlapped.hEvent);
+            order.push_back(entry.second.get());
+        }
+
+        int timeout = quiet_timeout_ms(batching, last_event);
+        DWORD result = WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, timeout < 0 ? INFINITE : (DWORD)timeout);
+        if (result == WAIT_OBJECT_0) {
+            sync_directories();
+        }
+        else if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + handles.size()) {
+            DirectoryWatch& watch = *order[result - WAIT_OBJECT_0 - 1];
+            DWORD bytes = 0;
+            if (GetOverlappedResult(watch.handle, &watch.overlapped, &bytes, FALSE)) {
+                if (bytes == 0) {
+                    // The notification buffer overflowed: treat every watched file in the directory as changed.
+                    std::vector<std::string> files;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        for (const auto& file : files_) {
+                            if (parent_directory(file.first) == watch.path) files.push_back(file.first);
+                        }
+                    }
+                    for (const std::string& file : files) note_change(file);
+                }
+                const char* p = reinterpret_cast<const char*>(watch.buffer);
+                while (bytes > 0) {
+                    const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+                    int wide_len = (int)(info->FileNameLength / sizeof(WCHAR));
+                    int len = WideCharToMultiByte(CP_ACP, 0, info->FileName, wide_len, nullptr, 0, nullptr, nullptr);
+                    std::string name(len, '\0');
+                    WideCharToMultiByte(CP_ACP, 0, info->FileName, wide_len, &name[0], len, nullptr, nullptr);
+                    note_change(watch.path + "\\" + name);
+                    if (info->NextEntryOffset == 0) break;
+                    p += info->NextEntryOffset;
+                }
+                last_event = WatchClock::now();
+                batching = true;
+            }
+            issue_read(watch);
+        }
+
+        if (batching && quiet_timeout_ms(batching, last_event) == 0) {
+            batching = false;
+            publish();
+        }
+    }
+}
+
+#elif defined(__linux__)
+
+const size_t INOTIFY_BUFFER_SIZE = 64 * 1024;
+
+struct FileWatcher::Platform {
+    int inotifyFd = -1;
+    int wakeFd = -1;
+    std::map<std::string, int> watches;
+    std::map<int, std::string> directories;
+};
+
+FileWatcher::FileWatcher(ChangeFn on_change)
+    : onChange_(std::move(on_change)),
+    platform_(new Platform())
+{
+    platform_->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    platform_->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    thread_ = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher() {
+    stopping_ = true;
+    wake();
+    thread_.join();
+    if (platform_->inotifyFd >= 0) close(platform_->inotifyFd);
+    if (platform_->wakeFd >= 0) close(platform_->wakeFd);
+}
+
+void FileWatcher::wake() {
+    uint64_t one = 1;
+    if (write(platform_->wakeFd, &one, sizeof(one)) < 0) {
+        // The counter only saturates if the thread is already due to wake.
+    }
+}
+
+void FileWatcher::sync_directories() {
+    std::map<std::string, int> wanted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wanted = directories_;
+    }
+    std::map<std::string, int>& watches = platform_->watches;
+    for (auto it = watches.begin(); it != watches.end();) {
+        if (wanted.count(it->first)) {
+            ++it;
+            continue;
+        }
+        inotify_rm_watch(platform_->inotifyFd, it->second);
+        platform_->directories.erase(it->second);
+        it = watches.erase(it);
+    }
+    std::set<std::string> unwatched;
+    for (const auto& dir : wanted) {
+        if (watches.count(dir.first)) continue;
+        int wd = inotify_add_watch(platform_->inotifyFd, dir.first.c_str(),
+            IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_ATTRIB);
+        if (wd < 0) {
+            unwatched.insert(dir.first);
+            continue;
+        }
+        watches[dir.first] = wd;
+        platform_->directories[wd] = dir.first;
+    }
+    set_unwatched(std::move(unwatched));
+}
+
+void FileWatcher::run() {
+    WatchClock::time_point last_event = WatchClock::now();
+    bool batching = false;
+    std::vector<char> buffer(INOTIFY_BUFFER_SIZE);
+    while (!stopping_) {
+        pollfd fds[2] = { { platform_->inotifyFd, POLLIN, 0 }, { platform_->wakeFd, POLLIN, 0 } };
+        int ready = poll(fds, 2, quiet_timeout_ms(batching, last_event));
+        if (ready > 0 && (fds[1].revents & POLLIN)) {
+            uint64_t count;
+            if (read(platform_->wakeFd, &count, sizeof(count)) > 0) sync_directories();
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            ssize_t bytes;
+            while ((bytes = read(platform_->inotifyFd, buffer.data(), buffer.size())) > 0) {
+                for (ssize_t offset = 0; offset < bytes;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        // The kernel queue overflowed and events were dropped: treat every watched file as changed.
+                        std::vector<std::string> files;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            for (const auto& file : files_) files.push_back(file.first);
+                        }
+                        for (const std::string& file : files) note_change(file);
+                    }
+                    auto dir = platform_->directories.find(event->wd);
+                    if (event->len > 0 && dir != platform_->directories.end()) {
+                        note_change(dir->second + "/" + event->name);
+                    }
+                    offset += sizeof(inotify_event) + event->len;
+                }
+                last_event = WatchClock::now();
+                batching = true;
+            }
+        }
+
+        if (batching && quiet_timeout_ms(batching, last_event) == 0) {
+            batching = false;
+            publish();
+        }
+    }
+}
+
+#else
+
+const int POLL_INTERVAL_MS = 500;
+
+struct FileWatcher::Platform {
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool woken = false;
+    std::map<std::string, std::filesystem::file_time_type> stamps;
+};
+
+FileWatcher::FileWatcher(ChangeFn on_change)
+    : onChange_(std::move(on_change)),
+    platform_(new Platform())
+{
+    thread_ = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher() {
+    stopping_ = true;
+    wake();
+    thread_.join();
+}
+
+void FileWatcher::wake() {
+    std::lock_guard<std::mutex> lock(platform_->wakeMutex);
+    platform_->woken = true;
+    platform_->wakeCondition.notify_one();
+}
+
+void FileWatcher::sync_directories() {
+}
+
+// No native notification API: stat every watched file on an interval.
+void FileWatcher::run() {
+    while (!stopping_) {
+        {
+            std::unique_lock<std::mutex> lock(platform_->wakeMutex);
+            platform_->wakeCondition.wait_for(lock, std::chrono::milliseconds(POLL_INTERVAL_MS), [this] { return platform_->woken; });
+            platform_->woken = false;
+        }
+        std::vector<std::string> files;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& file : files_) files.push_back(file.first);
+        }
+        bool changed = false;
+        for (const std::string& file : files) {
+            std::error_code ec;
+            std::filesystem::file_time_type stamp = std::filesystem::last_write_time(file, ec);
+            auto known = platform_->stamps.find(file);
+            if (known != platform_->stamps.end() && known->second != stamp) {
+                note_change(file);
+                changed = true;
+            }
+            platform_->stamps[file] = stamp;
+        }
+        if (changed) publish();
+    }
+}
+
+#endif
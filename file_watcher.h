@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches individual files through their parent directories (inotify on
+// Linux, ReadDirectoryChangesW on Windows, mtime polling elsewhere) so that
+// editors saving via rename are seen too. Events are coalesced on a
+// background thread and published once a batch has been quiet for a moment.
+// A directory the platform refuses to watch (Windows caps one wait at 63
+// directories, inotify at max_user_watches) leaves its files unwatched;
+// is_watched() reports that so the UI can say so instead of going stale.
+class FileWatcher {
+public:
+    typedef std::function<void()> ChangeFn;
+
+    explicit FileWatcher(ChangeFn on_change = nullptr);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    void watch(const std::string& path);
+    void unwatch(const std::string& path);
+    bool has_changes() const { return hasChanges_.load(std::memory_order_acquire); }
+    std::vector<std::string> take_changes();
+    bool is_watched(const std::string& path);
+
+    static std::string normalize_path(const std::string& path);
+
+private:
+    struct Platform;
+
+    void run();
+    void wake();
+    void sync_directories();
+    void set_unwatched(std::set<std::string> directories);
+    void note_change(const std::string& path);
+    void publish();
+
+    ChangeFn onChange_;
+    std::unique_ptr<Platform> platform_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{ false };
+    std::atomic<bool> hasChanges_{ false };
+
+    std::mutex mutex_;
+    std::map<std::string, int> files_;
+    std::map<std::string, int> directories_;
+    std::set<std::string> batch_;
+    std::set<std::string> published_;
+    std::set<std::string> unwatched_;
+};
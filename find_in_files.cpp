@@ -0,0 +1,241 @@
+#include "find_in_files.h"
+#include "file_utils.h"
+#include "regex_dfa.h"
+#include "search_kernel.h"
+#include "work_pool.h"
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <unordered_set>
+
+const size_t FIND_IN_FILES_CHUNK_SIZE = 1 << 20;
+const size_t BINARY_SNIFF_BYTES = 8192;
+const size_t MAX_PREVIEW_LENGTH = 200;
+const size_t PREVIEW_CONTEXT = 40;
+
+FindInFilesJob::~FindInFilesJob() {
+    cancelled = true;
+    if (coordinator.joinable()) {
+        coordinator.join();
+    }
+}
+
+bool is_probably_binary(const char* data, size_t len) {
+    return memchr(data, '\0', std::min(len, BINARY_SNIFF_BYTES)) != nullptr;
+}
+
+static size_t utf8_boundary(std::string_view text, size_t pos, size_t floor) {
+    while (pos > floor && ((unsigned char)text[pos] & 0xC0) == 0x80) pos--;
+    return pos;
+}
+
+// Matches arrive in order, so the line scan only moves forward and each
+// line's end is found once however many matches it holds. A long line is
+// previewed in a window that starts shortly before the match.
+static void describe_matches(std::string_view text, const std::vector<size_t>& positions,
+    const std::vector<uint32_t>& lengths, FindInFilesResult& result)
+{
+    result.matches.reserve(positions.size());
+    size_t line_start = 0;
+    size_t line_end = std::string_view::npos;
+    size_t scanned = 0;
+    int line = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        size_t pos = positions[i];
+        while (scanned < pos) {
+            const char* nl = static_cast<const char*>(memchr(text.data() + scanned, '\n', pos - scanned));
+            if (!nl) {
+                scanned = pos;
+                break;
+            }
+            line++;
+            scanned = (size_t)(nl - text.data()) + 1;
+            line_start = scanned;
+            line_end = std::string_view::npos;
+        }
+
+        if (line_end == std::string_view::npos) {
+            line_end = text.find('\n', line_start);
+            if (line_end == std::string_view::npos) line_end = text.size();
+            if (line_end > line_start && text[line_end - 1] == '\r') line_end--;
+        }
+
+        size_t preview_start = line_start;
+        if (line_end - line_start > MAX_PREVIEW_LENGTH && pos - line_start > PREVIEW_CONTEXT) {
+            preview_start = utf8_boundary(text, std::min(pos, line_end - MAX_PREVIEW_LENGTH + PREVIEW_CONTEXT) - PREVIEW_CONTEXT, line_start);
+        }
+        size_t preview_end = std::min(line_end, preview_start + MAX_PREVIEW_LENGTH);
+        if (preview_end < line_end) preview_end = utf8_boundary(text, preview_end, preview_start);
+
+        FindInFilesMatch match;
+        match.offset = pos;
+        match.line = line + 1;
+        match.column = (int)(pos - line_start) + 1;
+        match.length = lengths[i];
+        match.preview.assign(text.data() + preview_start, preview_end - preview_start);
+        result.matches.push_back(std::move(match));
+    }
+}
+
+struct FindInFilesContext {
+    FindInFilesJob* job;
+    const FindInFilesOptions* options;
+    std::vector<std::unique_ptr<RegexMatcher>> matchers;
+
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    size_t inFlight = 0;
+};
+
+static void search_source(FindInFilesContext& ctx, int worker, const std::string& path, std::string_view text) {
+    FindInFilesJob* job = ctx.job;
+    const FindInFilesOptions& options = *ctx.options;
+    std::vector<size_t> positions;
+    std::vector<uint32_t> lengths;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (job->cancelled.load(std::memory_order_relaxed)) return;
+        size_t chunk_end = std::min(text.size(), pos + FIND_IN_FILES_CHUNK_SIZE);
+        if (options.useRegex) {
+            pos = ctx.matchers[worker]->find_all(text.data(), text.size(), pos, chunk_end, positions, lengths);
+        }
+        else {
+            pos = search_literal(text.data(), text.size(), pos, chunk_end,
+                options.query.data(), options.query.size(), options.caseSensitive, positions);
+            lengths.resize(positions.size(), (uint32_t)options.query.size());
+        }
+    }
+
+    job->filesSearched++;
+    job->bytesSearched += text.size();
+    if (positions.empty()) return;
+
+    FindInFilesResult result;
+    result.path = path;
+    describe_matches(text, positions, lengths, result);
+    job->matchesFound += result.matches.size();
+
+    std::lock_guard<std::mutex> lock(job->resultsMutex);
+    job->pendingResults.push_back(std::move(result));
+}
+
+static void search_file(FindInFilesContext& ctx, int worker, const std::string& path) {
+    if (ctx.job->cancelled.load(std::memory_order_relaxed)) return;
+    TextBufferPtr buffer;
+    std::string error;
+    if (!load_file_buffer(path.c_str(), buffer, error) || is_probably_binary(buffer->data(), buffer->size())) {
+        ctx.job->filesSkipped++;
+        return;
+    }
+    search_source(ctx, worker, path, buffer->view());
+}
+
+static void finish_file(FindInFilesContext& ctx) {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    ctx.inFlight--;
+    ctx.slotFree.notify_one();
+}
+
+// Files are submitted only while fewer than a couple per worker are queued,
+// so cancelling never has to drain a whole tree's worth of tasks before the
+// job's destructor can join.
+static void walk_directory(FindInFilesContext& ctx, WorkStealingPool& pool, const std::unordered_set<std::string>& open_paths) {
+    namespace fs = std::filesystem;
+    FindInFilesJob* job = ctx.job;
+    const size_t max_in_flight = (size_t)pool.thread_count() * 2;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(ctx.options->directory, fs::directory_options::skip_permission_denied, ec);
+    for (fs::recursive_directory_iterator end; !ec && it != end; it.increment(ec)) {
+        if (job->cancelled.load(std::memory_order_relaxed)) return;
+
+        const fs::directory_entry& entry = *it;
+        std::string name = entry.path().filename().string();
+        std::error_code type_ec;
+        if (entry.is_directory(type_ec)) {
+            if (!name.empty() && name[0] == '.') {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!entry.is_regular_file(type_ec)) continue;
+
+        std::string path = entry.path().string();
+        if (!open_paths.empty() && open_paths.count(entry.path().lexically_normal().string())) continue;
+
+        std::error_code size_ec;
+        uintmax_t size = entry.file_size(size_ec);
+        if (size_ec || size == 0 || size > ctx.options->maxFileSize) {
+            job->filesSkipped++;
+            continue;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(ctx.mutex);
+            ctx.slotFree.wait(lock, [&] { return ctx.inFlight < max_in_flight; });
+            ctx.inFlight++;
+        }
+        FindInFilesContext* context = &ctx;
+        pool.submit([context, path](int worker) {
+            search_file(*context, worker, path);
+            finish_file(*context);
+        });
+    }
+}
+
+static void run_find_in_files(FindInFilesJob* job, FindInFilesOptions options) {
+    WorkStealingPool pool(options.threadCount);
+
+    FindInFilesContext ctx;
+    ctx.job = job;
+    ctx.options = &options;
+    if (options.useRegex) {
+        for (int i = 0; i < pool.thread_count(); ++i) {
+            ctx.matchers.emplace_back(new RegexMatcher());
+            std::string error;
+            ctx.matchers.back()->compile(options.query, options.caseSensitive, error);
+        }
+    }
+
+    std::unordered_set<std::string> open_paths;
+    for (const FindInFilesSource& source : options.openDocuments) {
+        open_paths.insert(std::filesystem::path(source.path).lexically_normal().string());
+        const FindInFilesSource* src = &source;
+        FindInFilesContext* context = &ctx;
+        pool.submit([context, src](int worker) { search_source(*context, worker, src->path, src->text); });
+    }
+
+    if (!options.directory.empty()) {
+        walk_directory(ctx, pool, open_paths);
+    }
+
+    pool.wait_idle();
+    job->finished = true;
+    request_frame(FrameReason_Job);
+}
+
+std::shared_ptr<FindInFilesJob> start_find_in_files(FindInFilesOptions options, std::string& error_out) {
+    if (options.query.empty()) {
+        error_out = "Search query is empty.";
+        return nullptr;
+    }
+    if (options.useRegex) {
+        RegexMatcher probe;
+        if (!probe.compile(options.query, options.caseSensitive, error_out)) {
+            return nullptr;
+        }
+    }
+    if (!options.directory.empty()) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(options.directory, ec)) {
+            error_out = "Not a directory: " + options.directory;
+            return nullptr;
+        }
+    }
+
+    std::shared_ptr<FindInFilesJob> job = std::make_shared<FindInFilesJob>();
+    job->coordinator = std::thread(run_find_in_files, job.get(), std::move(options));
+    return job;
+}
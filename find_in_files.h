@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "text_buffer.h"
+
+struct FindInFilesMatch {
+    size_t offset = 0;
+    int line = 0;
+    int column = 0;
+    uint32_t length = 0;
+    std::string preview;
+};
+
+struct FindInFilesResult {
+    std::string path;
+    std::vector<FindInFilesMatch> matches;
+};
+
+struct FindInFilesSource {
+    std::string path;
+    TextBufferPtr buffer;
+    std::string_view text;
+};
+
+struct FindInFilesOptions {
+    std::string query;
+    bool caseSensitive = false;
+    bool useRegex = false;
+    std::vector<FindInFilesSource> openDocuments;
+    std::string directory;
+    size_t maxFileSize = 64 * 1024 * 1024;
+    int threadCount = 0;
+};
+
+struct FindInFilesJob {
+    std::atomic<bool> cancelled{ false };
+    std::atomic<bool> finished{ false };
+    std::atomic<size_t> filesSearched{ 0 };
+    std::atomic<size_t> filesSkipped{ 0 };
+    std::atomic<size_t> bytesSearched{ 0 };
+    std::atomic<size_t> matchesFound{ 0 };
+
+    std::mutex resultsMutex;
+    std::vector<FindInFilesResult> pendingResults;
+    std::thread coordinator;
+
+    ~FindInFilesJob();
+};
+
+bool is_probably_binary(const char* data, size_t len);
+
+std::shared_ptr<FindInFilesJob> start_find_in_files(FindInFilesOptions options, std::string& error_out);
@@ -0,0 +1,76 @@
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+static const double NEVER = std::numeric_limits<double>::infinity();
+
+EventFramePolicy::EventFramePolicy(double active_window, int settle_frames)
+    : activeWindow_(active_window), settleFrames_(settle_frames), activeUntil_(-NEVER), nextFrameAt_(NEVER) {}
+
+void EventFramePolicy::on_request(unsigned reasons, double now, double delay) {
+    if (delay <= 0.0) {
+        pendingFrames_ = std::max(pendingFrames_, settleFrames_);
+    }
+    else {
+        nextFrameAt_ = std::min(nextFrameAt_, now + delay);
+    }
+    if (reasons & FrameReason_Input) {
+        activeUntil_ = std::max(activeUntil_, now + activeWindow_);
+    }
+}
+
+void EventFramePolicy::on_frame_started(double now) {
+    if (nextFrameAt_ <= now) nextFrameAt_ = NEVER;
+    if (pendingFrames_ > 0) --pendingFrames_;
+}
+
+double EventFramePolicy::next_frame_delay(double now) const {
+    if (now < activeUntil_ || pendingFrames_ > 0) return 0.0;
+    if (nextFrameAt_ == NEVER) return -1.0;
+    return std::max(0.0, nextFrameAt_ - now);
+}
+
+FrameScheduler::FrameScheduler(std::unique_ptr<FramePolicy> policy, WakeFn wake)
+    : policy_(std::move(policy)), wake_(std::move(wake)) {}
+
+void FrameScheduler::request_frame(unsigned reasons, double delay) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        policy_->on_request(reasons, now_seconds(), delay);
+    }
+    if (wake_) wake_();
+}
+
+double FrameScheduler::next_frame_delay() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_->next_frame_delay(now_seconds());
+}
+
+void FrameScheduler::frame_started() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_->on_frame_started(now_seconds());
+}
+
+double FrameScheduler::now_seconds() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+// Requests hold the lock for the whole call, so clearing the scheduler waits
+// for calls already inside it: after set_frame_scheduler(nullptr) returns, no
+// thread can still reach the old scheduler or its wake function. Requests
+// serialize on the scheduler's own mutex anyway, so a shared lock would buy
+// nothing and could starve the writer.
+static std::mutex s_frame_scheduler_mutex;
+static FrameScheduler* s_frame_scheduler = nullptr;
+
+void set_frame_scheduler(FrameScheduler* scheduler) {
+    std::lock_guard<std::mutex> lock(s_frame_scheduler_mutex);
+    s_frame_scheduler = scheduler;
+}
+
+void request_frame(unsigned reasons, double delay) {
+    std::lock_guard<std::mutex> lock(s_frame_scheduler_mutex);
+    if (s_frame_scheduler) s_frame_scheduler->request_frame(reasons, delay);
+}
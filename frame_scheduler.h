@@ -0,0 +1,83 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+enum FrameReason {
+    FrameReason_Input = 1 << 0,
+    FrameReason_Job = 1 << 1,
+    FrameReason_FileChange = 1 << 2,
+    FrameReason_Animation = 1 << 3,
+};
+
+// Redraw rate while progress is on screen, and for the text caret blink.
+const double PROGRESS_FRAME_INTERVAL = 0.1;
+const double CARET_BLINK_FRAME_INTERVAL = 0.2;
+
+// Decides when the next frame is due. Policies only see timestamps, so they
+// can be driven by a simulated clock without a window.
+class FramePolicy {
+public:
+    virtual ~FramePolicy() {}
+
+    // A frame was requested for `reasons`, due `delay` seconds after `now`.
+    virtual void on_request(unsigned reasons, double now, double delay) = 0;
+    // A frame is starting; it serves every request due by `now`. Requests
+    // made while it is built are for later frames.
+    virtual void on_frame_started(double now) = 0;
+    // Seconds until the next frame is due: 0 renders now, negative means
+    // nothing is pending and the caller may block until the next request.
+    virtual double next_frame_delay(double now) const = 0;
+};
+
+// Renders only on request. Input keeps frames coming for a short active
+// window so hover, key repeat and layout settle without every widget having
+// to ask. Immediate requests get a couple of frames since a change often
+// takes ImGui one extra frame to lay out; delayed ones (animation ticks) get
+// exactly one frame when due.
+class EventFramePolicy : public FramePolicy {
+public:
+    explicit EventFramePolicy(double active_window = 0.5, int settle_frames = 2);
+
+    void on_request(unsigned reasons, double now, double delay) override;
+    void on_frame_started(double now) override;
+    double next_frame_delay(double now) const override;
+
+private:
+    double activeWindow_;
+    int settleFrames_;
+    double activeUntil_;
+    double nextFrameAt_;
+    int pendingFrames_ = 0;
+};
+
+// Thread-safe front end to a policy. Requests may come from any thread;
+// `wake` is called after each one so the UI thread can leave its wait.
+class FrameScheduler {
+public:
+    typedef std::function<void()> WakeFn;
+
+    FrameScheduler(std::unique_ptr<FramePolicy> policy, WakeFn wake = nullptr);
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    void request_frame(unsigned reasons, double delay = 0.0);
+    double next_frame_delay();
+    void frame_started();
+
+    static double now_seconds();
+
+private:
+    std::mutex mutex_;
+    std::unique_ptr<FramePolicy> policy_;
+    WakeFn wake_;
+};
+
+// Routes requests from core code (job completion, file changes) to the
+// scheduler the application registered; without one they are ignored.
+// Clearing the scheduler waits for requests already in flight, so the
+// application can destroy it and its window right afterwards.
+void set_frame_scheduler(FrameScheduler* scheduler);
+void request_frame(unsigned reasons, double delay = 0.0);
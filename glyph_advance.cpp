@@ -0,0 +1,125 @@
+#include "glyph_advance.h"
+
+const char* utf8_decode(const char* begin, const char* end, unsigned int& codepoint_out) {
+    unsigned char lead = (unsigned char)*begin;
+    int extra = lead < 0x80 ? 0 : (lead & 0xE0) == 0xC0 ? 1 : (lead & 0xF0) == 0xE0 ? 2 : (lead & 0xF8) == 0xF0 ? 3 : -1;
+    if (extra < 0 || end - begin <= extra) {
+        codepoint_out = 0xFFFD;
+        return begin + 1;
+    }
+
+    unsigned int cp = extra == 0 ? lead : lead & (0x3F >> extra);
+    for (int i = 1; i <= extra; ++i) {
+        unsigned char c = (unsigned char)begin[i];
+        if ((c & 0xC0) != 0x80) {
+            codepoint_out = 0xFFFD;
+            return begin + 1;
+        }
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    codepoint_out = cp;
+    return begin + 1 + extra;
+}
+
+int utf8_encode(unsigned int codepoint, char out[4]) {
+    if (codepoint < 0x80) {
+        out[0] = (char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (codepoint >> 18));
+    out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+void GlyphAdvanceTable::build(AdvanceFn advance_fn) {
+    advance_fn_ = std::move(advance_fn);
+    wide_.clear();
+    for (unsigned int c = 0; c < 128; ++c) {
+        ascii_[c] = advance_fn_(c);
+    }
+    ascii_[(unsigned char)'\r'] = 0.0f;
+    ascii_[(unsigned char)'\n'] = 0.0f;
+
+    cell_advance_ = ascii_[(unsigned char)' '];
+    fixed_pitch_ = true;
+    for (unsigned int c = 33; c < 127; ++c) {
+        if (ascii_[c] != cell_advance_) {
+            fixed_pitch_ = false;
+            break;
+        }
+    }
+}
+
+float GlyphAdvanceTable::codepoint_advance(unsigned int codepoint) const {
+    if (codepoint < 128) return ascii_[codepoint];
+    auto it = wide_.find(codepoint);
+    if (it != wide_.end()) return it->second;
+    float advance = advance_fn_(codepoint);
+    wide_.emplace(codepoint, advance);
+    return advance;
+}
+
+float GlyphAdvanceTable::measure_slow(const char* begin, const char* end) const {
+    float width = 0.0f;
+    const char* p = begin;
+    while (p < end) {
+        unsigned char c = (unsigned char)*p;
+        if (c < 128) {
+            width += ascii_[c];
+            ++p;
+            continue;
+        }
+        unsigned int codepoint;
+        p = utf8_decode(p, end, codepoint);
+        width += codepoint_advance(codepoint);
+    }
+    return width;
+}
+
+float GlyphAdvanceTable::measure(const char* begin, const char* end) const {
+    if (!fixed_pitch_) {
+        return measure_slow(begin, end);
+    }
+
+    size_t tabs = 0;
+    for (const char* p = begin; p < end; ++p) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '\t') {
+            tabs++;
+        }
+        else if (c < 32 || c >= 127) {
+            return measure_slow(begin, end);
+        }
+    }
+    size_t columns = (size_t)(end - begin) - tabs;
+    return (float)columns * cell_advance_ + (float)tabs * tab_advance();
+}
+
+const char* GlyphAdvanceTable::hit_test(const char* begin, const char* end, float x) const {
+    if (x <= 0.0f) return begin;
+
+    float width = 0.0f;
+    const char* p = begin;
+    while (p < end) {
+        unsigned int codepoint;
+        const char* next = utf8_decode(p, end, codepoint);
+        float advance = codepoint_advance(codepoint);
+        if (x < width + advance * 0.5f) return p;
+        width += advance;
+        p = next;
+    }
+    return end;
+}
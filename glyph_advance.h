@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+
+class GlyphAdvanceTable {
+public:
+    typedef std::function<float(unsigned int codepoint)> AdvanceFn;
+
+    void build(AdvanceFn advance_fn);
+
+    bool valid() const { return (bool)advance_fn_; }
+    bool is_fixed_pitch() const { return fixed_pitch_; }
+    float cell_advance() const { return cell_advance_; }
+    float tab_advance() const { return ascii_[(unsigned char)'\t']; }
+
+    float measure(const char* begin, const char* end) const;
+    const char* hit_test(const char* begin, const char* end, float x) const;
+
+private:
+    float codepoint_advance(unsigned int codepoint) const;
+    float measure_slow(const char* begin, const char* end) const;
+
+    AdvanceFn advance_fn_;
+    float ascii_[128] = {};
+    float cell_advance_ = 0.0f;
+    bool fixed_pitch_ = false;
+    mutable std::unordered_map<unsigned int, float> wide_;
+};
+
+const char* utf8_decode(const char* begin, const char* end, unsigned int& codepoint_out);
+int utf8_encode(unsigned int codepoint, char out[4]);
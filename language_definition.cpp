@@ -0,0 +1,141 @@
+#include "language_definition.h"
+#include "code_lexer.h"
+#include <cctype>
+
+static const char* const s_token_class_names[Token_Count] = {
+    "default", "keyword", "comment", "string", "number", "preprocessor", "tag", "attribute", "selector", "property",
+};
+
+bool token_class_from_name(std::string_view name, unsigned char& cls_out) {
+    for (int c = 0; c < Token_Count; ++c) {
+        if (name == s_token_class_names[c]) {
+            cls_out = (unsigned char)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::vector<std::string_view> split_words(std::string_view text) {
+    std::vector<std::string_view> words;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && isspace((unsigned char)text[pos])) pos++;
+        size_t end = pos;
+        while (end < text.size() && !isspace((unsigned char)text[end])) end++;
+        if (end > pos) words.push_back(text.substr(pos, end - pos));
+        pos = end;
+    }
+    return words;
+}
+
+// Reads the optional `[class] [escape=c] [multiline] [in_tags]` tail of a span rule.
+static bool parse_span_options(const std::vector<std::string_view>& args, size_t first, LanguageSpan& span, std::string& error_out) {
+    for (size_t i = first; i < args.size(); ++i) {
+        std::string_view arg = args[i];
+        if (arg == "multiline") {
+            span.multiline = true;
+        }
+        else if (arg == "in_tags") {
+            span.inTags = true;
+        }
+        else if (arg.substr(0, 7) == "escape=" && arg.size() == 8) {
+            span.escape = arg[7];
+        }
+        else if (!token_class_from_name(arg, span.cls)) {
+            error_out = "unknown span option '" + std::string(arg) + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_language_definition(std::string_view text, const std::string& id, LanguageDefinition& out, std::string& error_out) {
+    out = LanguageDefinition();
+    out.id = id;
+    out.name = id;
+    int line_number = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t nl = text.find('\n', pos);
+        if (nl == std::string_view::npos) nl = text.size();
+        std::string_view line = text.substr(pos, nl - pos);
+        pos = nl + 1;
+        line_number++;
+
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos || line[first] == '#') continue;
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            error_out = id + ".lang:" + std::to_string(line_number) + ": expected 'key: value'";
+            return false;
+        }
+        std::string_view key = line.substr(first, colon - first);
+        while (!key.empty() && isspace((unsigned char)key.back())) key.remove_suffix(1);
+        std::string_view value = line.substr(colon + 1);
+        std::vector<std::string_view> args = split_words(value);
+
+        std::string error;
+        unsigned char cls = Token_Default;
+        if (key == "name") {
+            size_t begin = value.find_first_not_of(" \t");
+            size_t end = value.find_last_not_of(" \t\r");
+            if (begin != std::string_view::npos) out.name = std::string(value.substr(begin, end - begin + 1));
+        }
+        else if (key == "extensions") {
+            for (std::string_view ext : args) {
+                std::string lower(ext);
+                for (char& c : lower) c = (char)tolower((unsigned char)c);
+                out.extensions.push_back(lower);
+            }
+        }
+        else if (key == "line_comment" && args.size() == 1) {
+            out.lineRules.push_back({ std::string(args[0]), Token_Comment });
+        }
+        else if (key == "line_token" && args.size() == 2 && token_class_from_name(args[1], cls)) {
+            out.lineRules.push_back({ std::string(args[0]), cls });
+        }
+        else if (key == "block_comment" && args.size() == 2) {
+            LanguageSpan span;
+            span.open = std::string(args[0]);
+            span.close = std::string(args[1]);
+            span.cls = Token_Comment;
+            span.multiline = true;
+            out.spans.push_back(span);
+        }
+        else if ((key == "string" || key == "span") && args.size() >= 2) {
+            LanguageSpan span;
+            span.open = std::string(args[0]);
+            span.close = std::string(args[1]);
+            span.cls = key == "string" ? Token_String : Token_Default;
+            if (!parse_span_options(args, 2, span, error)) {
+                error_out = id + ".lang:" + std::to_string(line_number) + ": " + error;
+                return false;
+            }
+            out.spans.push_back(span);
+        }
+        else if (key == "word_prefix" && args.size() == 2 && token_class_from_name(args[1], cls)) {
+            out.wordPrefixes.push_back({ std::string(args[0]), cls });
+        }
+        else if (key == "word_chars" && args.size() == 1) {
+            out.wordChars = std::string(args[0]);
+        }
+        else if (key == "numbers" && args.size() == 1 && (args[0] == "yes" || args[0] == "no")) {
+            out.numbers = args[0] == "yes";
+        }
+        else if (key == "keywords" && args.size() >= 1 && token_class_from_name(args[0], cls)) {
+            for (size_t i = 1; i < args.size(); ++i) out.words.push_back({ std::string(args[i]), cls });
+        }
+        else if (key == "tag" && args.size() == 2) {
+            out.tags.push_back({ std::string(args[0]), std::string(args[1]) });
+        }
+        else if (key == "embed" && args.size() == 4) {
+            out.embeds.push_back({ std::string(args[0]), std::string(args[1]), std::string(args[2]), std::string(args[3]) });
+        }
+        else {
+            error_out = id + ".lang:" + std::to_string(line_number) + ": invalid '" + std::string(key) + "' entry";
+            return false;
+        }
+    }
+    return true;
+}
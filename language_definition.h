@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A language as described by a .lang file: plain `key: value` lines, where
+// values are whitespace-separated and lines starting with '#' are comments.
+//
+//   name: C++
+//   extensions: cpp h hpp
+//   line_comment: //
+//   block_comment: /* */
+//   string: " " escape=\ string
+//   line_token: # preprocessor
+//   word_prefix: . selector
+//   word_chars: -
+//   numbers: yes
+//   keywords: keyword int float double
+//   tag: < >
+//   embed: <script > </script javascript
+//
+// `string` and `span` take `open close` and then any of `class`, `escape=c`,
+// `multiline` and `in_tags`. `tag` colours `open` and the word after it as a
+// tag and lexes attributes up to `close`; `embed` does the same for
+// `open ... open_end`, then lexes another language until `close`. Delimiters
+// cannot contain whitespace.
+
+struct LanguageLineRule {
+    std::string prefix;
+    unsigned char cls;
+};
+
+struct LanguageSpan {
+    std::string open;
+    std::string close;
+    unsigned char cls;
+    char escape = 0;
+    bool multiline = false;
+    bool inTags = false;
+};
+
+struct LanguageWord {
+    std::string word;
+    unsigned char cls;
+};
+
+struct LanguageTag {
+    std::string open;
+    std::string close;
+};
+
+struct LanguageEmbed {
+    std::string open;
+    std::string openEnd;
+    std::string close;
+    std::string language;
+};
+
+struct LanguageDefinition {
+    std::string id;
+    std::string name;
+    std::vector<std::string> extensions;
+    std::vector<LanguageLineRule> lineRules;
+    std::vector<LanguageSpan> spans;
+    std::vector<LanguageLineRule> wordPrefixes;
+    std::vector<LanguageWord> words;
+    std::vector<LanguageTag> tags;
+    std::vector<LanguageEmbed> embeds;
+    std::string wordChars;
+    bool numbers = true;
+};
+
+bool parse_language_definition(std::string_view text, const std::string& id, LanguageDefinition& out, std::string& error_out);
+bool token_class_from_name(std::string_view name, unsigned char& cls_out);
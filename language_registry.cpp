@@ -0,0 +1,232 @@
+#include "language_registry.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static bool read_text_file(const fs::path& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::ostringstream text;
+    text << file.rdbuf();
+    out = text.str();
+    return true;
+}
+
+uint64_t LanguageSet::hash_text(std::string_view text, uint64_t h) {
+    for (char c : text) {
+        h ^= (unsigned char)c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t LanguageSet::cache_key(int index, int depth) const {
+    const Language& language = languages_[index];
+    uint64_t h = hash_text(language.def.id);
+    h = hash_text(std::string_view(language.text), h);
+    for (const LanguageEmbed& embed : language.def.embeds) {
+        int inner = -1;
+        for (int i = 0; i < (int)languages_.size() && inner < 0; ++i) {
+            if (languages_[i].def.id == embed.language) inner = i;
+        }
+        if (inner < 0 || depth >= LexerTables::MAX_EMBED_DEPTH) {
+            h = hash_text(embed.language, h);
+            continue;
+        }
+        uint64_t inner_key = cache_key(inner, depth + 1);
+        h = hash_text(std::string_view(reinterpret_cast<const char*>(&inner_key), sizeof(inner_key)), h);
+    }
+    return h;
+}
+
+// Cache writes go through a temporary file and a rename so a concurrent
+// instance never reads a half-written table; failures only cost a recompile
+// next time.
+bool LanguageSet::load_tables(int index, const fs::path& cache_dir) {
+    Language& language = languages_[index];
+    uint64_t key = cache_key(index, 0);
+    char key_text[24];
+    snprintf(key_text, sizeof(key_text), "%016llx", (unsigned long long)key);
+    std::string file_name = language.def.id + "-" + key_text + ".lexer";
+    fs::path cache_path = cache_dir / file_name;
+
+    std::string cached;
+    if (!cache_dir.empty() && read_text_file(cache_path, cached) && language.tables.deserialize(cached, key)) {
+        cacheHits_++;
+        return true;
+    }
+
+    std::string error;
+    LanguageResolver resolve = [this](const std::string& id) -> const LanguageDefinition* {
+        for (const Language& other : languages_) {
+            if (other.def.id == id) return &other.def;
+        }
+        return nullptr;
+    };
+    if (!LexerTables::compile(language.def, resolve, language.tables, error)) {
+        errors_.push_back(error);
+        return false;
+    }
+    compiled_++;
+    if (cache_dir.empty()) return true;
+
+    std::error_code ec;
+    fs::create_directories(cache_dir, ec);
+    std::string data;
+    language.tables.serialize(key, data);
+    std::ostringstream tmp_name;
+    tmp_name << file_name << "." << std::this_thread::get_id() << ".tmp";
+    fs::path tmp_path = cache_dir / tmp_name.str();
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), (std::streamsize)data.size());
+        if (!out) {
+            out.close();
+            fs::remove(tmp_path, ec);
+            return true;
+        }
+    }
+    fs::rename(tmp_path, cache_path, ec);
+    if (ec) {
+        fs::remove(tmp_path, ec);
+        return true;
+    }
+
+    std::string stale_prefix = language.def.id + "-";
+    for (fs::directory_iterator it(cache_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name != file_name && name.size() == file_name.size() && name.compare(0, stale_prefix.size(), stale_prefix) == 0 &&
+            it->path().extension() == ".lexer")
+        {
+            std::error_code remove_ec;
+            fs::remove(it->path(), remove_ec);
+        }
+    }
+    return true;
+}
+
+void LanguageSet::load(const fs::path& language_dir, const fs::path& cache_dir) {
+    languages_.clear();
+    extensions_.clear();
+    errors_.clear();
+    cacheHits_ = 0;
+    compiled_ = 0;
+    std::string error;
+    LexerTables::compile(LanguageDefinition(), nullptr, plainText_, error);
+
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (fs::directory_iterator it(language_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == ".lang") files.push_back(it->path());
+    }
+    if (ec) errors_.push_back("Cannot read language directory " + language_dir.string() + ": " + ec.message());
+    else if (files.empty()) errors_.push_back("No .lang files in " + language_dir.string());
+    std::sort(files.begin(), files.end());
+
+    for (const fs::path& path : files) {
+        Language language;
+        if (!read_text_file(path, language.text)) {
+            errors_.push_back("Cannot open " + path.string());
+            continue;
+        }
+        if (!parse_language_definition(language.text, path.stem().string(), language.def, error)) {
+            errors_.push_back(error);
+            continue;
+        }
+        languages_.push_back(std::move(language));
+    }
+
+    std::vector<bool> loaded(languages_.size());
+    for (int i = 0; i < (int)languages_.size(); ++i) loaded[i] = load_tables(i, cache_dir);
+    int kept = 0;
+    for (int i = 0; i < (int)languages_.size(); ++i) {
+        if (!loaded[i]) continue;
+        if (kept != i) languages_[kept] = std::move(languages_[i]);
+        kept++;
+    }
+    languages_.resize(kept);
+
+    for (int i = 0; i < (int)languages_.size(); ++i) {
+        for (const std::string& ext : languages_[i].def.extensions) extensions_.emplace(ext, i);
+    }
+}
+
+int LanguageSet::find_by_file_name(std::string_view file_name) const {
+    size_t dot_pos = file_name.find_last_of('.');
+    if (dot_pos == std::string_view::npos) return -1;
+    std::string ext(file_name.substr(dot_pos + 1));
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    auto it = extensions_.find(ext);
+    return it == extensions_.end() ? -1 : it->second;
+}
+
+int LanguageSet::find_by_id(std::string_view id) const {
+    for (int i = 0; i < (int)languages_.size(); ++i) {
+        if (languages_[i].def.id == id) return i;
+    }
+    return -1;
+}
+
+const LexerTables& LanguageSet::tables(int lang) const {
+    if (lang < 0 || lang >= (int)languages_.size()) return plainText_;
+    return languages_[lang].tables;
+}
+
+const std::string& LanguageSet::name(int lang) const {
+    static const std::string plain_text = "Plain Text";
+    if (lang < 0 || lang >= (int)languages_.size()) return plain_text;
+    return languages_[lang].def.name;
+}
+
+const std::string& LanguageSet::id(int lang) const {
+    static const std::string plain_text = "text";
+    if (lang < 0 || lang >= (int)languages_.size()) return plain_text;
+    return languages_[lang].def.id;
+}
+
+static fs::path s_language_dir;
+static fs::path s_cache_dir;
+
+void set_language_directories(const fs::path& language_dir, const fs::path& cache_dir) {
+    s_language_dir = language_dir;
+    s_cache_dir = cache_dir;
+}
+
+static fs::path default_language_dir() {
+    std::error_code ec;
+    fs::path local = fs::current_path(ec) / "languages";
+    if (!ec && fs::is_directory(local, ec)) return local;
+#ifdef CODEVIEWER_LANGUAGE_DIR
+    return fs::path(CODEVIEWER_LANGUAGE_DIR);
+#else
+    return local;
+#endif
+}
+
+static fs::path default_cache_dir() {
+    std::error_code ec;
+    fs::path temp = fs::temp_directory_path(ec);
+    return ec ? fs::path() : temp / "codeviewer-lexer-cache";
+}
+
+// Loaded once on first use from whichever thread gets there first; the set
+// is immutable afterwards, so lexing and stripping jobs read it unlocked.
+const LanguageSet& languages() {
+    static LanguageSet set;
+    static std::once_flag once;
+    std::call_once(once, []() {
+        set.load(s_language_dir.empty() ? default_language_dir() : s_language_dir,
+            s_cache_dir.empty() ? default_cache_dir() : s_cache_dir);
+    });
+    return set;
+}
+
+const char* language_name(int lang) {
+    return languages().name(lang).c_str();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "language_definition.h"
+#include "lexer_tables.h"
+
+// Every *.lang file in a directory, compiled to LexerTables. Compiled tables
+// are cached on disk as `<id>-<key>.lexer`, where the key hashes the
+// definition text together with the definitions it embeds, so editing any of
+// them recompiles exactly the languages that use it. Language numbers are
+// indices in id order; -1 is plain text.
+class LanguageSet {
+public:
+    void load(const std::filesystem::path& language_dir, const std::filesystem::path& cache_dir);
+
+    int count() const { return (int)languages_.size(); }
+    int find_by_file_name(std::string_view file_name) const;
+    int find_by_id(std::string_view id) const;
+    const LexerTables& tables(int lang) const;
+    const std::string& name(int lang) const;
+    const std::string& id(int lang) const;
+
+    int cache_hits() const { return cacheHits_; }
+    int compiled_count() const { return compiled_; }
+    const std::vector<std::string>& errors() const { return errors_; }
+
+    static uint64_t hash_text(std::string_view text, uint64_t h = 14695981039346656037ull);
+
+private:
+    struct Language {
+        LanguageDefinition def;
+        std::string text;
+        LexerTables tables;
+    };
+
+    uint64_t cache_key(int index, int depth) const;
+    bool load_tables(int index, const std::filesystem::path& cache_dir);
+
+    std::vector<Language> languages_;
+    std::unordered_map<std::string, int> extensions_;
+    LexerTables plainText_;
+    std::vector<std::string> errors_;
+    int cacheHits_ = 0;
+    int compiled_ = 0;
+};
+
+// Must be called before the first languages() call to take effect; an empty
+// path keeps its default. Defaults are ./languages (or the source tree's
+// copy) and a directory under the system temp path.
+void set_language_directories(const std::filesystem::path& language_dir, const std::filesystem::path& cache_dir);
+const LanguageSet& languages();
+const char* language_name(int lang);
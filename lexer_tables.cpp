@@ -0,0 +1,564 @@
+#include "lexer_tables.h"
+#include "language_definition.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+
+static const uint32_t LEXER_CACHE_MAGIC = 0x584C5643;
+static const uint32_t LEXER_CACHE_VERSION = 1;
+static const size_t MAX_LEX_STATES = 256;
+static const uint32_t MAX_SEED_TRIES = 10000;
+
+static_assert(sizeof(LexRule) == 16 && sizeof(LexStateInfo) == 16 && sizeof(LexWordSet) == 24 && sizeof(LexWord) == 8,
+    "lexer tables are cached as raw bytes");
+
+// Seeded FNV-1a with a final xor-shift; it mixes short keywords well enough
+// that the seed search for a collision-free slot table stays short.
+static uint32_t word_hash(const char* word, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)word[i];
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+static void push_run(std::vector<TokenRun>& runs, size_t first_run, size_t start, size_t end, unsigned char cls) {
+    if (end <= start) return;
+    if (runs.size() > first_run) {
+        TokenRun& last = runs.back();
+        if (last.cls == cls && last.offset + last.length == start) {
+            last.length += (uint32_t)(end - start);
+            return;
+        }
+    }
+    runs.push_back({ (uint32_t)start, (uint32_t)(end - start), cls });
+}
+
+struct PendingRule {
+    LexRule rule;
+    uint8_t state;
+    bool exit;
+    size_t order;
+};
+
+struct PendingExit {
+    std::string open;
+    uint8_t target;
+};
+
+class LexerCompiler {
+public:
+    LexerCompiler(const LanguageResolver& resolve, LexerTables& out) : resolve_(resolve), out_(out) {}
+
+    bool build(const LanguageDefinition& def, std::string& error_out) {
+        out_ = LexerTables();
+        for (const LanguageLineRule& rule : def.lineRules) {
+            if (rule.cls == Token_Comment) out_.comments_.lineComments.push_back(rule.prefix);
+        }
+        for (const LanguageSpan& span : def.spans) {
+            if (span.cls == Token_Comment && !span.inTags) out_.comments_.blockComments.push_back({ span.open, span.close });
+        }
+        uint8_t top = 0;
+        if (!add_language(def, {}, 0, top)) {
+            error_out = def.id + ": " + error_;
+            return false;
+        }
+        finish();
+        return true;
+    }
+
+private:
+    bool add_state(const LexStateInfo& info, uint8_t& state_out) {
+        if (out_.states_.size() >= MAX_LEX_STATES) {
+            error_ = "more than 256 lexer states";
+            return false;
+        }
+        state_out = (uint8_t)out_.states_.size();
+        out_.states_.push_back(info);
+        return true;
+    }
+
+    uint32_t intern(const std::string& text) {
+        size_t found = out_.pool_.find(text);
+        if (found != std::string::npos) return (uint32_t)found;
+        out_.pool_ += text;
+        return (uint32_t)(out_.pool_.size() - text.size());
+    }
+
+    uint8_t char_class(const std::string& word_chars) {
+        uint8_t table[256];
+        for (int c = 0; c < 256; ++c) {
+            uint8_t kind = 0;
+            if (isspace(c)) kind |= LexChar_Space;
+            if (isalpha(c) || c == '_') kind |= LexChar_WordStart | LexChar_Word;
+            if (isdigit(c)) kind |= LexChar_Word | LexChar_Digit;
+            table[c] = kind;
+        }
+        for (char c : word_chars) table[(unsigned char)c] |= LexChar_Word;
+        size_t count = out_.charClasses_.size() / 256;
+        for (size_t i = 0; i < count; ++i) {
+            if (memcmp(&out_.charClasses_[i * 256], table, 256) == 0) return (uint8_t)i;
+        }
+        out_.charClasses_.insert(out_.charClasses_.end(), table, table + 256);
+        return (uint8_t)count;
+    }
+
+    bool word_set(const LanguageDefinition& def, uint16_t& set_out) {
+        set_out = LexerTables::NO_WORD_SET;
+        std::vector<const LanguageWord*> words;
+        for (const LanguageWord& word : def.words) {
+            if (word.word.empty() || word.word.size() > 255) {
+                error_ = "invalid keyword '" + word.word + "'";
+                return false;
+            }
+            bool duplicate = false;
+            for (const LanguageWord* seen : words) duplicate |= seen->word == word.word;
+            if (!duplicate) words.push_back(&word);
+        }
+        if (words.empty()) return true;
+        if (out_.wordSets_.size() >= LexerTables::NO_WORD_SET || words.size() >= 0xFFFF) {
+            error_ = "too many keywords";
+            return false;
+        }
+
+        LexWordSet set = {};
+        uint32_t slot_count = 1;
+        while (slot_count < words.size() * 8) slot_count <<= 1;
+        set.firstSlot = (uint32_t)out_.slots_.size();
+        set.slotMask = slot_count - 1;
+        set.firstWord = (uint32_t)out_.words_.size();
+        set.wordCount = (uint32_t)words.size();
+        set.minLength = 0xFFFF;
+        for (const LanguageWord* word : words) {
+            set.minLength = std::min(set.minLength, (uint16_t)word->word.size());
+            set.maxLength = std::max(set.maxLength, (uint16_t)word->word.size());
+            out_.words_.push_back({ intern(word->word), (uint8_t)word->word.size(), word->cls, 0 });
+        }
+
+        std::vector<uint16_t> slots(slot_count);
+        for (uint32_t seed = 1; seed < MAX_SEED_TRIES && set.seed == 0; ++seed) {
+            std::fill(slots.begin(), slots.end(), 0);
+            bool ok = true;
+            for (size_t i = 0; i < words.size() && ok; ++i) {
+                uint16_t& slot = slots[word_hash(words[i]->word.data(), words[i]->word.size(), seed) & set.slotMask];
+                ok = slot == 0;
+                slot = (uint16_t)(i + 1);
+            }
+            if (ok) set.seed = seed;
+        }
+        if (set.seed == 0) {
+            error_ = "no perfect-hash seed found for the keywords";
+            return false;
+        }
+        out_.slots_.insert(out_.slots_.end(), slots.begin(), slots.end());
+        set_out = (uint16_t)out_.wordSets_.size();
+        out_.wordSets_.push_back(set);
+        return true;
+    }
+
+    bool add_rule(uint8_t state, const std::string& open, LexRuleAction action, unsigned char cls, uint8_t target, uint8_t flags,
+        bool exit = false, const LanguageSpan* span = nullptr)
+    {
+        if (open.empty() || open.size() > 255 || (span && (span->close.empty() || span->close.size() > 255))) {
+            error_ = "delimiters must be 1 to 255 bytes";
+            return false;
+        }
+        const uint8_t* chars = &out_.charClasses_[out_.states_[state].charClass * 256];
+        LexRule rule = {};
+        rule.open = intern(open);
+        rule.openLength = (uint8_t)open.size();
+        rule.action = action;
+        rule.cls = cls;
+        rule.target = target;
+        rule.flags = flags;
+        if (chars[(unsigned char)open.back()] & LexChar_Word) rule.flags |= LexRule_Boundary;
+        if (span) {
+            rule.close = intern(span->close);
+            rule.closeLength = (uint8_t)span->close.size();
+            rule.escape = (uint8_t)span->escape;
+        }
+        pending_.push_back({ rule, state, exit, pending_.size() });
+        return true;
+    }
+
+    // Attribute region of a tag or embed head: words are attributes and
+    // in_tags strings apply. The caller adds the rule that leaves it.
+    bool add_attribute_state(const LanguageDefinition& def, uint8_t& state_out) {
+        LexStateInfo info = {};
+        info.wordSet = LexerTables::NO_WORD_SET;
+        info.cls = Token_Attribute;
+        info.charClass = char_class(def.wordChars);
+        info.numbers = 1;
+        if (!add_state(info, state_out)) return false;
+        for (const LanguageSpan& span : def.spans) {
+            if (span.inTags && !add_rule(state_out, span.open, LexRule_Span, span.cls, 0, 0, false, &span)) return false;
+        }
+        return true;
+    }
+
+    bool add_language(const LanguageDefinition& def, const std::vector<PendingExit>& exits, int depth, uint8_t& state_out) {
+        if (depth > LexerTables::MAX_EMBED_DEPTH) {
+            error_ = "languages embedded more than " + std::to_string(LexerTables::MAX_EMBED_DEPTH) + " deep";
+            return false;
+        }
+        LexStateInfo info = {};
+        info.cls = Token_Default;
+        info.charClass = char_class(def.wordChars);
+        info.numbers = def.numbers ? 1 : 0;
+        if (!word_set(def, info.wordSet)) return false;
+        uint8_t top = 0;
+        if (!add_state(info, top)) return false;
+        state_out = top;
+
+        for (const PendingExit& exit : exits) {
+            if (!add_rule(top, exit.open, LexRule_Goto, Token_Tag, exit.target, 0, true)) return false;
+        }
+        for (const LanguageLineRule& rule : def.lineRules) {
+            if (!add_rule(top, rule.prefix, LexRule_LineToEnd, rule.cls, 0, 0)) return false;
+        }
+        for (const LanguageSpan& span : def.spans) {
+            if (span.inTags) continue;
+            uint8_t span_state = 0;
+            if (span.multiline) {
+                LexStateInfo inside = {};
+                inside.wordSet = LexerTables::NO_WORD_SET;
+                inside.span = 1;
+                inside.cls = span.cls;
+                inside.escape = (uint8_t)span.escape;
+                inside.next = top;
+                inside.charClass = info.charClass;
+                if (span.close.empty() || span.close.size() > 255) {
+                    error_ = "delimiters must be 1 to 255 bytes";
+                    return false;
+                }
+                inside.close = intern(span.close);
+                inside.closeLength = (uint8_t)span.close.size();
+                if (!add_state(inside, span_state)) return false;
+            }
+            if (!add_rule(top, span.open, LexRule_Span, span.cls, span_state, span.multiline ? LexRule_Multiline : 0, false, &span)) return false;
+        }
+        for (const LanguageLineRule& prefix : def.wordPrefixes) {
+            if (!add_rule(top, prefix.prefix, LexRule_Word, prefix.cls, 0, LexRule_TakeWord)) return false;
+        }
+        for (const LanguageTag& tag : def.tags) {
+            uint8_t attributes = 0;
+            if (!add_attribute_state(def, attributes)) return false;
+            if (!add_rule(attributes, tag.close, LexRule_Goto, Token_Tag, top, 0)) return false;
+            if (!add_rule(top, tag.open, LexRule_Goto, Token_Tag, attributes, LexRule_TakeWord)) return false;
+        }
+        for (const LanguageEmbed& embed : def.embeds) {
+            const LanguageDefinition* inner = resolve_ ? resolve_(embed.language) : nullptr;
+            if (!inner) {
+                error_ = "embedded language '" + embed.language + "' not found";
+                return false;
+            }
+            uint8_t head = 0;
+            uint8_t tail = 0;
+            uint8_t body = 0;
+            if (!add_attribute_state(def, head) || !add_attribute_state(def, tail)) return false;
+            if (!add_rule(tail, embed.openEnd, LexRule_Goto, Token_Tag, top, 0)) return false;
+            if (!add_language(*inner, { { embed.close, tail } }, depth + 1, body)) return false;
+            if (!add_rule(head, embed.openEnd, LexRule_Goto, Token_Tag, body, 0)) return false;
+            if (!add_rule(top, embed.open, LexRule_Goto, Token_Tag, head, 0)) return false;
+        }
+        return true;
+    }
+
+    // Rules for one state and first byte become a contiguous range: embed
+    // exits first, then longer delimiters, then definition order.
+    void finish() {
+        const std::string& pool = out_.pool_;
+        std::sort(pending_.begin(), pending_.end(), [&](const PendingRule& a, const PendingRule& b) {
+            unsigned char a_first = (unsigned char)pool[a.rule.open];
+            unsigned char b_first = (unsigned char)pool[b.rule.open];
+            if (a.state != b.state) return a.state < b.state;
+            if (a_first != b_first) return a_first < b_first;
+            if (a.exit != b.exit) return a.exit;
+            if (a.rule.openLength != b.rule.openLength) return a.rule.openLength > b.rule.openLength;
+            return a.order < b.order;
+        });
+        out_.rules_.clear();
+        out_.dispatch_.assign(out_.states_.size() * 256 + 1, 0);
+        size_t next = 0;
+        for (size_t slot = 0; slot < out_.states_.size() * 256; ++slot) {
+            out_.dispatch_[slot] = (uint32_t)out_.rules_.size();
+            while (next < pending_.size() && (size_t)pending_[next].state * 256 + (unsigned char)pool[pending_[next].rule.open] == slot) {
+                out_.rules_.push_back(pending_[next++].rule);
+            }
+        }
+        out_.dispatch_.back() = (uint32_t)out_.rules_.size();
+    }
+
+    const LanguageResolver& resolve_;
+    LexerTables& out_;
+    std::vector<PendingRule> pending_;
+    std::string error_;
+};
+
+bool LexerTables::compile(const LanguageDefinition& def, const LanguageResolver& resolve, LexerTables& out, std::string& error_out) {
+    LexerCompiler compiler(resolve, out);
+    if (!compiler.build(def, error_out)) return false;
+    assert(out.validate());
+    return true;
+}
+
+size_t LexerTables::find_close(const char* line, size_t len, size_t from, const char* close, size_t close_len, unsigned char escape) const {
+    if (!escape) {
+        while (from + close_len <= len) {
+            const char* hit = static_cast<const char*>(memchr(line + from, close[0], len - close_len + 1 - from));
+            if (!hit) return std::string::npos;
+            from = (size_t)(hit - line);
+            if (close_len == 1 || (hit[1] == close[1] && memcmp(hit + 2, close + 2, close_len - 2) == 0)) return from + close_len;
+            from++;
+        }
+        return std::string::npos;
+    }
+    while (from < len) {
+        if ((unsigned char)line[from] == escape && from + 1 < len) {
+            from += 2;
+            continue;
+        }
+        if (from + close_len <= len && memcmp(line + from, close, close_len) == 0) return from + close_len;
+        from++;
+    }
+    return std::string::npos;
+}
+
+const LexWord* LexerTables::find_word(const LexWordSet& set, const char* word, size_t len) const {
+    if (len < set.minLength || len > set.maxLength) return nullptr;
+    uint16_t slot = slots_[set.firstSlot + (word_hash(word, len, set.seed) & set.slotMask)];
+    if (slot == 0) return nullptr;
+    const LexWord& entry = words_[set.firstWord + slot - 1];
+    return entry.length == len && memcmp(pool_.data() + entry.text, word, len) == 0 ? &entry : nullptr;
+}
+
+unsigned char LexerTables::word_class(std::string_view word) const {
+    if (states_.empty() || states_[0].wordSet == NO_WORD_SET) return Token_Default;
+    const LexWord* entry = find_word(wordSets_[states_[0].wordSet], word.data(), word.size());
+    return entry ? entry->cls : (unsigned char)Token_Default;
+}
+
+unsigned char LexerTables::lex_line(const char* line, size_t len, unsigned char state, std::vector<TokenRun>& runs_out) const {
+    if (state >= states_.size()) state = 0;
+    size_t first_run = runs_out.size();
+    size_t pos = 0;
+
+    while (pos < len) {
+        const LexStateInfo& info = states_[state];
+        if (info.span) {
+            size_t end = find_close(line, len, pos, pool_.data() + info.close, info.closeLength, info.escape);
+            if (end == std::string::npos) end = len;
+            else state = info.next;
+            push_run(runs_out, first_run, pos, end, info.cls);
+            pos = end;
+            continue;
+        }
+
+        const uint8_t* chars = &charClasses_[info.charClass * 256];
+        unsigned char c = (unsigned char)line[pos];
+        size_t end = pos + 1;
+        unsigned char cls = Token_Default;
+        bool matched = false;
+
+        const uint32_t* range = &dispatch_[(size_t)state * 256 + c];
+        for (uint32_t r = range[0]; r < range[1] && !matched; ++r) {
+            const LexRule& rule = rules_[r];
+            if (rule.openLength > len - pos || memcmp(line + pos, pool_.data() + rule.open, rule.openLength) != 0) continue;
+            size_t rule_end = pos + rule.openLength;
+            if ((rule.flags & LexRule_Boundary) && rule_end < len && (chars[(unsigned char)line[rule_end]] & LexChar_Word)) continue;
+            if (rule.flags & LexRule_TakeWord) {
+                if (rule_end >= len || !(chars[(unsigned char)line[rule_end]] & LexChar_WordStart)) continue;
+                while (rule_end < len && (chars[(unsigned char)line[rule_end]] & LexChar_Word)) rule_end++;
+            }
+            if (rule.action == LexRule_LineToEnd) {
+                rule_end = len;
+            }
+            else if (rule.action == LexRule_Span) {
+                rule_end = find_close(line, len, rule_end, pool_.data() + rule.close, rule.closeLength, rule.escape);
+                if (rule_end == std::string::npos) {
+                    rule_end = len;
+                    if (rule.flags & LexRule_Multiline) state = rule.target;
+                }
+            }
+            else if (rule.action == LexRule_Goto) {
+                state = rule.target;
+            }
+            end = rule_end;
+            cls = rule.cls;
+            matched = true;
+        }
+
+        if (!matched) {
+            unsigned char kind = chars[c];
+            unsigned char next = (pos + 1 < len) ? (unsigned char)line[pos + 1] : 0;
+            if (kind & LexChar_Space) {
+                while (end < len && (chars[(unsigned char)line[end]] & LexChar_Space)) end++;
+            }
+            else if (kind & LexChar_WordStart) {
+                while (end < len && (chars[(unsigned char)line[end]] & LexChar_Word)) end++;
+                cls = info.cls;
+                if (info.wordSet != NO_WORD_SET) {
+                    const LexWord* entry = find_word(wordSets_[info.wordSet], line + pos, end - pos);
+                    if (entry) cls = entry->cls;
+                }
+            }
+            else if (info.numbers && ((kind & LexChar_Digit) || (c == '.' && (chars[next] & LexChar_Digit)))) {
+                while (end < len && ((chars[(unsigned char)line[end]] & LexChar_Digit) || line[end] == '.' || tolower((unsigned char)line[end]) == 'f')) end++;
+                cls = Token_Number;
+            }
+        }
+
+        push_run(runs_out, first_run, pos, end, cls);
+        pos = end;
+    }
+    return state;
+}
+
+static void put_u32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void put_string(std::string& out, const std::string& text) {
+    put_u32(out, (uint32_t)text.size());
+    out += text;
+}
+
+template <typename T>
+static void put_vector(std::string& out, const std::vector<T>& items) {
+    put_u32(out, (uint32_t)items.size());
+    out.append(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+}
+
+struct CacheReader {
+    std::string_view data;
+    size_t pos = 0;
+    bool ok = true;
+
+    bool read(void* dst, size_t bytes) {
+        if (!ok || bytes > data.size() - pos) return ok = false;
+        memcpy(dst, data.data() + pos, bytes);
+        pos += bytes;
+        return true;
+    }
+    uint32_t u32() {
+        uint32_t value = 0;
+        read(&value, sizeof(value));
+        return value;
+    }
+    void string(std::string& out) {
+        uint32_t size = u32();
+        if (!ok || size > data.size() - pos) {
+            ok = false;
+            return;
+        }
+        out.assign(data.data() + pos, size);
+        pos += size;
+    }
+    template <typename T>
+    void vector(std::vector<T>& out) {
+        uint32_t count = u32();
+        if (!ok || count > (data.size() - pos) / sizeof(T)) {
+            ok = false;
+            return;
+        }
+        out.resize(count);
+        read(out.data(), count * sizeof(T));
+    }
+};
+
+void LexerTables::serialize(uint64_t key, std::string& out) const {
+    out.clear();
+    put_u32(out, LEXER_CACHE_MAGIC);
+    put_u32(out, LEXER_CACHE_VERSION);
+    out.append(reinterpret_cast<const char*>(&key), sizeof(key));
+    put_string(out, pool_);
+    put_vector(out, states_);
+    put_vector(out, rules_);
+    put_vector(out, dispatch_);
+    put_vector(out, charClasses_);
+    put_vector(out, wordSets_);
+    put_vector(out, words_);
+    put_vector(out, slots_);
+    put_u32(out, (uint32_t)comments_.lineComments.size());
+    for (const std::string& open : comments_.lineComments) put_string(out, open);
+    put_u32(out, (uint32_t)comments_.blockComments.size());
+    for (const auto& block : comments_.blockComments) {
+        put_string(out, block.first);
+        put_string(out, block.second);
+    }
+}
+
+bool LexerTables::deserialize(std::string_view data, uint64_t key) {
+    CacheReader in{ data };
+    uint64_t stored_key = 0;
+    if (in.u32() != LEXER_CACHE_MAGIC || in.u32() != LEXER_CACHE_VERSION || !in.read(&stored_key, sizeof(stored_key)) || stored_key != key) {
+        return false;
+    }
+    LexerTables loaded;
+    in.string(loaded.pool_);
+    in.vector(loaded.states_);
+    in.vector(loaded.rules_);
+    in.vector(loaded.dispatch_);
+    in.vector(loaded.charClasses_);
+    in.vector(loaded.wordSets_);
+    in.vector(loaded.words_);
+    in.vector(loaded.slots_);
+    uint32_t line_count = in.u32();
+    for (uint32_t i = 0; i < line_count && in.ok; ++i) {
+        loaded.comments_.lineComments.emplace_back();
+        in.string(loaded.comments_.lineComments.back());
+    }
+    uint32_t block_count = in.u32();
+    for (uint32_t i = 0; i < block_count && in.ok; ++i) {
+        loaded.comments_.blockComments.emplace_back();
+        in.string(loaded.comments_.blockComments.back().first);
+        in.string(loaded.comments_.blockComments.back().second);
+    }
+    if (!in.ok || in.pos != data.size() || !loaded.validate()) return false;
+    *this = std::move(loaded);
+    return true;
+}
+
+// A cache file is only trusted once every index in it is in range, so a
+// truncated or stale file falls back to compiling instead of crashing.
+bool LexerTables::validate() const {
+    size_t state_count = states_.size();
+    size_t class_count = charClasses_.size() / 256;
+    if (state_count == 0 || state_count > MAX_LEX_STATES || charClasses_.size() % 256 != 0) return false;
+    if (dispatch_.size() != state_count * 256 + 1 || dispatch_.back() != rules_.size()) return false;
+    for (size_t i = 1; i < dispatch_.size(); ++i) {
+        if (dispatch_[i] < dispatch_[i - 1]) return false;
+    }
+    auto in_pool = [&](uint32_t offset, size_t length) { return offset <= pool_.size() && length <= pool_.size() - offset; };
+    for (const LexRule& rule : rules_) {
+        if (rule.openLength == 0 || !in_pool(rule.open, rule.openLength) || !in_pool(rule.close, rule.closeLength)) return false;
+        if (rule.target >= state_count || rule.action > LexRule_Word) return false;
+        if (rule.action == LexRule_Span && rule.closeLength == 0) return false;
+    }
+    for (const LexStateInfo& info : states_) {
+        if (info.charClass >= class_count || info.next >= state_count) return false;
+        if (info.wordSet != NO_WORD_SET && info.wordSet >= wordSets_.size()) return false;
+        if (info.span && (info.closeLength == 0 || !in_pool(info.close, info.closeLength))) return false;
+    }
+    for (const LexWordSet& set : wordSets_) {
+        if (set.firstSlot > slots_.size() || (size_t)set.slotMask + 1 > slots_.size() - set.firstSlot) return false;
+        if ((set.slotMask & (set.slotMask + 1)) != 0) return false;
+        if (set.firstWord > words_.size() || set.wordCount > words_.size() - set.firstWord) return false;
+        for (uint32_t i = 0; i <= set.slotMask; ++i) {
+            if (slots_[set.firstSlot + i] > set.wordCount) return false;
+        }
+    }
+    for (const LexWord& word : words_) {
+        if (!in_pool(word.text, word.length)) return false;
+    }
+    // Comment stripping indexes the first byte of every delimiter.
+    for (const std::string& open : comments_.lineComments) {
+        if (open.empty()) return false;
+    }
+    for (const auto& block : comments_.blockComments) {
+        if (block.first.empty() || block.second.empty()) return false;
+    }
+    return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "code_lexer.h"
+
+struct LanguageDefinition;
+
+enum LexRuleAction : unsigned char {
+    LexRule_LineToEnd,
+    LexRule_Span,
+    LexRule_Goto,
+    LexRule_Word
+};
+
+enum LexRuleFlags : unsigned char {
+    LexRule_Multiline = 1,
+    LexRule_TakeWord = 2,
+    LexRule_Boundary = 4
+};
+
+enum LexCharClass : unsigned char {
+    LexChar_Space = 1,
+    LexChar_WordStart = 2,
+    LexChar_Word = 4,
+    LexChar_Digit = 8
+};
+
+// The tables below are written to the lexer cache as raw bytes, so they are
+// padded by hand and must not change layout without a version bump.
+struct LexRule {
+    uint32_t open;
+    uint32_t close;
+    uint8_t openLength;
+    uint8_t closeLength;
+    uint8_t action;
+    uint8_t cls;
+    uint8_t escape;
+    uint8_t target;
+    uint8_t flags;
+    uint8_t reserved;
+};
+
+struct LexStateInfo {
+    uint32_t close;
+    uint16_t wordSet;
+    uint8_t closeLength;
+    uint8_t span;
+    uint8_t cls;
+    uint8_t escape;
+    uint8_t next;
+    uint8_t charClass;
+    uint8_t numbers;
+    uint8_t reserved[3];
+};
+
+struct LexWordSet {
+    uint32_t firstSlot;
+    uint32_t slotMask;
+    uint32_t seed;
+    uint32_t firstWord;
+    uint32_t wordCount;
+    uint16_t minLength;
+    uint16_t maxLength;
+};
+
+struct LexWord {
+    uint32_t text;
+    uint8_t length;
+    uint8_t cls;
+    uint16_t reserved;
+};
+
+struct CommentSyntax {
+    std::vector<std::string> lineComments;
+    std::vector<std::pair<std::string, std::string>> blockComments;
+};
+
+typedef std::function<const LanguageDefinition*(const std::string& id)> LanguageResolver;
+
+// A language definition compiled to a byte-dispatched state machine. Each
+// state owns the rules that can start at a given byte, sorted so embed exits
+// and longer delimiters win; a multiline span or an embedded language is
+// just another state, so the per-line lex state stays one byte. Embedded
+// languages are compiled inline, once per embedding, with their exit rules
+// added to their top state.
+class LexerTables {
+public:
+    static const uint16_t NO_WORD_SET = 0xFFFF;
+    static const int MAX_EMBED_DEPTH = 4;
+
+    static bool compile(const LanguageDefinition& def, const LanguageResolver& resolve, LexerTables& out, std::string& error_out);
+
+    void serialize(uint64_t key, std::string& out) const;
+    bool deserialize(std::string_view data, uint64_t key);
+
+    unsigned char lex_line(const char* line, size_t len, unsigned char state, std::vector<TokenRun>& runs_out) const;
+    unsigned char word_class(std::string_view word) const;
+
+    size_t state_count() const { return states_.size(); }
+    size_t rule_count() const { return rules_.size(); }
+    const CommentSyntax& comments() const { return comments_; }
+
+private:
+    friend class LexerCompiler;
+
+    bool validate() const;
+    const LexWord* find_word(const LexWordSet& set, const char* word, size_t len) const;
+    size_t find_close(const char* line, size_t len, size_t from, const char* close, size_t close_len, unsigned char escape) const;
+
+    std::string pool_;
+    std::vector<LexStateInfo> states_;
+    std::vector<LexRule> rules_;
+    std::vector<uint32_t> dispatch_;
+    std::vector<uint8_t> charClasses_;
+    std::vector<LexWordSet> wordSets_;
+    std::vector<LexWord> words_;
+    std::vector<uint16_t> slots_;
+    CommentSyntax comments_;
+};
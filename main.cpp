@@ -13,11 +13,30 @@
 #include "window_setup.h"
 #include "file_utils.h"
 #include "ui_addons.h"
+#include "batch_export_cli.h"
+#include "profiler.h"
+#include "frame_scheduler.h"
+#include "language_registry.h"
+#include <cmath>
+#include <filesystem>
+#include <memory>
 
 ImFont* g_pCodeFont = nullptr;
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    wchar_t exe_path[MAX_PATH];
+    DWORD exe_path_len = GetModuleFileNameW(NULL, exe_path, MAX_PATH);
+    if (exe_path_len > 0 && exe_path_len < MAX_PATH) {
+        std::error_code ec;
+        std::filesystem::path language_dir = std::filesystem::path(exe_path).parent_path() / "languages";
+        if (std::filesystem::is_directory(language_dir, ec)) set_language_directories(language_dir, {});
+    }
+
+    if (IsBatchExportCommand(argc, argv)) {
+        return RunBatchExportCli(argc, argv);
+    }
+
     HINSTANCE hInstance = GetModuleHandle(NULL);
     const TCHAR* className = _T("ImGuiCodeViewerClass");
     HWND hwnd = SetupWindow(hInstance, className);
@@ -40,13 +59,7 @@ int main(int, char**)
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
     io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
 
-    io.Fonts->AddFontDefault();
-    const char* firaCodePath = "C:/libs/fonts/Fira_Code_v6.2/ttf/FiraCode-Bold.ttf";
-    float fontSize = 14.0f;
-    ImFontConfig fontConfig;
-    fontConfig.OversampleH = 2;
-    fontConfig.OversampleV = 1;
-    g_pCodeFont = io.Fonts->AddFontFromFileTTF(firaCodePath, fontSize, &fontConfig, io.Fonts->GetGlyphRangesDefault());
+    g_pCodeFont = LoadCodeViewerFonts();
 
     if (!g_pCodeFont) {
         MessageBox(hwnd, _T("Failed to load Fira Code font. Using default ImGui font."), _T("Font Warning"), MB_OK | MB_ICONWARNING);
@@ -54,6 +67,13 @@ int main(int, char**)
     }
     io.FontDefault = g_pCodeFont;
 
+    // Without definitions every file opens as plain text, so say why up front.
+    if (!languages().errors().empty()) {
+        std::string message = "Some language definitions could not be loaded; their files open as plain text.\n";
+        for (const std::string& error : languages().errors()) message += "\n" + error;
+        MessageBoxA(hwnd, message.c_str(), "Language Warning", MB_OK | MB_ICONWARNING);
+    }
+
     ApplyCodeViewerStyle();
     ImGuiStyle& style = ImGui::GetStyle();
     if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
@@ -69,18 +89,55 @@ int main(int, char**)
     int activeDocumentIndex = -1;
     bool showApp = true;
 
+    // Background threads wake the loop by posting WM_NULL to the host window;
+    // everything else arriving in the queue counts as input. Requests made by
+    // the UI itself are seen before the next wait and need no wake-up.
+    DWORD ui_thread = ::GetCurrentThreadId();
+    FrameScheduler scheduler(std::unique_ptr<FramePolicy>(new EventFramePolicy()),
+        [hwnd, ui_thread]() {
+            if (::GetCurrentThreadId() != ui_thread) ::PostMessage(hwnd, WM_NULL, 0, 0);
+        });
+    set_frame_scheduler(&scheduler);
+    scheduler.request_frame(FrameReason_Input);
+
     while (showApp)
     {
-        MSG msg;
-        while (::PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
+        // Sleep until a message arrives or the policy's next frame is due.
+        bool queue_signaled = false;
+        double delay = scheduler.next_frame_delay();
+        if (delay != 0.0) {
+            DWORD timeout = delay < 0.0 ? INFINITE : (DWORD)std::ceil(delay * 1000.0);
+            queue_signaled = ::MsgWaitForMultipleObjectsEx(0, NULL, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE) == WAIT_OBJECT_0;
+        }
+
         {
-            ::TranslateMessage(&msg);
-            ::DispatchMessage(&msg);
-            if (msg.message == WM_QUIT)
-                showApp = false;
+            PROFILE_SCOPE("messages");
+            bool had_wake = false;
+            bool had_input = false;
+            MSG msg;
+            while (::PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
+            {
+                if (msg.message == WM_NULL && msg.hwnd == hwnd) {
+                    had_wake = true;
+                    continue;
+                }
+                ::TranslateMessage(&msg);
+                ::DispatchMessage(&msg);
+                had_input = true;
+                if (msg.message == WM_QUIT)
+                    showApp = false;
+            }
+            // A wait that ends with nothing posted was a sent message (resize,
+            // activation), which PeekMessage dispatched directly.
+            if (had_input || (queue_signaled && !had_wake)) {
+                scheduler.request_frame(FrameReason_Input);
+            }
         }
         if (!showApp)
             break;
+        if (scheduler.next_frame_delay() != 0.0)
+            continue;
+        scheduler.frame_started();
 
         HandleDroppedFiles(openDocuments, activeDocumentIndex);
 
@@ -88,33 +145,45 @@ int main(int, char**)
         ImGui_ImplWin32_NewFrame();
         ImGui::NewFrame();
 
-        ShowCodeViewerUI(&showApp, openDocuments, activeDocumentIndex);
+        {
+            PROFILE_SCOPE("ui");
+            ShowCodeViewerUI(&showApp, openDocuments, activeDocumentIndex);
+        }
 
-        ImGui::Render();
+        {
+            PROFILE_SCOPE("imgui_render");
+            ImGui::Render();
+        }
         const float clear_color_with_alpha[4] = { 0.1f, 0.1f, 0.1f, 1.00f };
         ID3D11RenderTargetView* mainRenderTargetView = GetMainRenderTargetView();
         ID3D11DeviceContext* context = GetImmediateContext();
 
-        if (mainRenderTargetView && context) {
-            context->OMSetRenderTargets(1, &mainRenderTargetView, NULL);
-            context->ClearRenderTargetView(mainRenderTargetView, clear_color_with_alpha);
-        }
-
-        if (ImGui::GetDrawData()) {
-            ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
-        }
-
-        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
         {
-            ImGui::UpdatePlatformWindows();
-            ImGui::RenderPlatformWindowsDefault();
+            PROFILE_SCOPE("render");
+            if (mainRenderTargetView && context) {
+                context->OMSetRenderTargets(1, &mainRenderTargetView, NULL);
+                context->ClearRenderTargetView(mainRenderTargetView, clear_color_with_alpha);
+            }
+
+            if (ImGui::GetDrawData()) {
+                ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+            }
+
+            if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+            {
+                ImGui::UpdatePlatformWindows();
+                ImGui::RenderPlatformWindowsDefault();
+            }
         }
 
         IDXGISwapChain* swapChain = GetSwapChain();
         if (swapChain) {
+            PROFILE_SCOPE("present");
             swapChain->Present(1, 0);
         }
+        PROFILE_FRAME_MARK();
     }
+    set_frame_scheduler(nullptr);
 
     ImGui_ImplDX11_Shutdown();
     ImGui_ImplWin32_Shutdown();
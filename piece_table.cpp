@@ -0,0 +1,330 @@
+#include "piece_table.h"
+#include <algorithm>
+#include <cstring>
+
+const size_t ADD_CHUNK_SIZE = 64 * 1024;
+
+static void index_newlines(const char* data, size_t begin, size_t end, std::vector<size_t>& out) {
+    const char* p = data + begin;
+    const char* last = data + end;
+    while (p < last) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', last - p));
+        if (!nl) break;
+        out.push_back((size_t)(nl - data));
+        p = nl + 1;
+    }
+}
+
+PieceTable::PieceTable() = default;
+
+PieceTable::PieceTable(TextBufferPtr original) {
+    if (!original || original->size() == 0) return;
+    Buffer buffer;
+    buffer.data = original->data();
+    buffer.size = original->size();
+    buffer.capacity = buffer.size;
+    index_newlines(buffer.data, 0, buffer.size, buffer.newlines);
+    buffer.original = std::move(original);
+    buffers_.push_back(std::move(buffer));
+    root_ = new_node(0, 0, buffers_[0].size);
+}
+
+size_t PieceTable::size() const {
+    return sum_length(root_);
+}
+
+size_t PieceTable::newline_count() const {
+    return sum_newlines(root_);
+}
+
+size_t PieceTable::count_newlines(uint32_t buffer, size_t start, size_t length) const {
+    const std::vector<size_t>& newlines = buffers_[buffer].newlines;
+    auto first = std::lower_bound(newlines.begin(), newlines.end(), start);
+    auto last = std::lower_bound(first, newlines.end(), start + length);
+    return (size_t)(last - first);
+}
+
+int PieceTable::new_node(uint32_t buffer, size_t start, size_t length) {
+    int index;
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    }
+    else {
+        index = (int)nodes_.size();
+        nodes_.emplace_back();
+    }
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+
+    Node& node = nodes_[index];
+    node = Node();
+    node.priority = seed_;
+    node.buffer = buffer;
+    node.start = start;
+    node.length = length;
+    node.newlines = count_newlines(buffer, start, length);
+    pull(index);
+    return index;
+}
+
+void PieceTable::free_subtree(int node) {
+    std::vector<int> stack;
+    if (node >= 0) stack.push_back(node);
+    while (!stack.empty()) {
+        int n = stack.back();
+        stack.pop_back();
+        if (nodes_[n].left >= 0) stack.push_back(nodes_[n].left);
+        if (nodes_[n].right >= 0) stack.push_back(nodes_[n].right);
+        free_.push_back(n);
+    }
+}
+
+void PieceTable::pull(int node) {
+    Node& n = nodes_[node];
+    n.sumLength = n.length + sum_length(n.left) + sum_length(n.right);
+    n.sumNewlines = n.newlines + sum_newlines(n.left) + sum_newlines(n.right);
+}
+
+// Splits `node` so that left_out holds the first `offset` bytes, cutting the
+// piece that straddles the boundary in two.
+void PieceTable::split(int node, size_t offset, int& left_out, int& right_out) {
+    if (node < 0) {
+        left_out = right_out = -1;
+        return;
+    }
+    size_t left_len = sum_length(nodes_[node].left);
+    if (offset <= left_len) {
+        int right_of_left;
+        split(nodes_[node].left, offset, left_out, right_of_left);
+        nodes_[node].left = right_of_left;
+        pull(node);
+        right_out = node;
+        return;
+    }
+    if (offset >= left_len + nodes_[node].length) {
+        int left_of_right;
+        split(nodes_[node].right, offset - left_len - nodes_[node].length, left_of_right, right_out);
+        nodes_[node].right = left_of_right;
+        pull(node);
+        left_out = node;
+        return;
+    }
+
+    size_t cut = offset - left_len;
+    int tail = new_node(nodes_[node].buffer, nodes_[node].start + cut, nodes_[node].length - cut);
+    Node& head = nodes_[node];
+    int old_right = head.right;
+    head.length = cut;
+    head.newlines -= nodes_[tail].newlines;
+    head.right = -1;
+    pull(node);
+    left_out = node;
+    right_out = merge(tail, old_right);
+}
+
+int PieceTable::merge(int left, int right) {
+    if (left < 0) return right;
+    if (right < 0) return left;
+    if (nodes_[left].priority > nodes_[right].priority) {
+        int merged = merge(nodes_[left].right, right);
+        nodes_[left].right = merged;
+        pull(left);
+        return left;
+    }
+    int merged = merge(left, nodes_[right].left);
+    nodes_[right].left = merged;
+    pull(right);
+    return right;
+}
+
+uint32_t PieceTable::append_to_add_buffer(std::string_view text, size_t& start_out) {
+    if (buffers_.empty() || !buffers_.back().storage || buffers_.back().capacity - buffers_.back().size < text.size()) {
+        Buffer chunk;
+        chunk.capacity = std::max(ADD_CHUNK_SIZE, text.size());
+        chunk.storage.reset(new char[chunk.capacity]);
+        chunk.data = chunk.storage.get();
+        buffers_.push_back(std::move(chunk));
+    }
+    Buffer& chunk = buffers_.back();
+    start_out = chunk.size;
+    memcpy(chunk.storage.get() + chunk.size, text.data(), text.size());
+    chunk.size += text.size();
+    index_newlines(chunk.data, start_out, chunk.size, chunk.newlines);
+    return (uint32_t)(buffers_.size() - 1);
+}
+
+// Typing appends to the add chunk right after the previous keystroke, so the
+// piece ending at the cursor can usually grow in place instead of adding a node.
+bool PieceTable::append_to_last_piece(int tree, std::string_view text) {
+    if (tree < 0 || buffers_.empty()) return false;
+    std::vector<int> path;
+    for (int n = tree; n >= 0; n = nodes_[n].right) path.push_back(n);
+
+    Node& last = nodes_[path.back()];
+    const Buffer& chunk = buffers_.back();
+    if (last.buffer != buffers_.size() - 1 || !chunk.storage || last.start + last.length != chunk.size ||
+        chunk.capacity - chunk.size < text.size()) {
+        return false;
+    }
+
+    size_t start;
+    append_to_add_buffer(text, start);
+    last.length += text.size();
+    last.newlines = count_newlines(last.buffer, last.start, last.length);
+    for (auto it = path.rbegin(); it != path.rend(); ++it) pull(*it);
+    return true;
+}
+
+void PieceTable::insert(size_t offset, std::string_view text) {
+    if (text.empty()) return;
+    offset = std::min(offset, size());
+    int left, right;
+    split(root_, offset, left, right);
+    if (!append_to_last_piece(left, text)) {
+        size_t start;
+        uint32_t buffer = append_to_add_buffer(text, start);
+        left = merge(left, new_node(buffer, start, text.size()));
+    }
+    root_ = merge(left, right);
+}
+
+void PieceTable::erase(size_t offset, size_t length) {
+    size_t total = size();
+    if (offset >= total || length == 0) return;
+    length = std::min(length, total - offset);
+    int left, middle, right;
+    split(root_, offset, left, middle);
+    split(middle, length, middle, right);
+    free_subtree(middle);
+    root_ = merge(left, right);
+}
+
+size_t PieceTable::line_start(size_t line) const {
+    if (line == 0) return 0;
+    if (line > newline_count()) return size();
+    size_t base = 0;
+    int node = root_;
+    while (node >= 0) {
+        const Node& n = nodes_[node];
+        size_t left_newlines = sum_newlines(n.left);
+        if (line <= left_newlines) {
+            node = n.left;
+            continue;
+        }
+        line -= left_newlines;
+        base += sum_length(n.left);
+        if (line <= n.newlines) {
+            const std::vector<size_t>& newlines = buffers_[n.buffer].newlines;
+            auto it = std::lower_bound(newlines.begin(), newlines.end(), n.start) + (line - 1);
+            return base + (*it - n.start) + 1;
+        }
+        line -= n.newlines;
+        base += n.length;
+        node = n.right;
+    }
+    return base;
+}
+
+size_t PieceTable::line_of(size_t offset) const {
+    size_t line = 0;
+    int node = root_;
+    while (node >= 0) {
+        const Node& n = nodes_[node];
+        size_t left_len = sum_length(n.left);
+        if (offset < left_len) {
+            node = n.left;
+            continue;
+        }
+        line += sum_newlines(n.left);
+        offset -= left_len;
+        if (offset < n.length) {
+            return line + count_newlines(n.buffer, n.start, offset);
+        }
+        line += n.newlines;
+        offset -= n.length;
+        node = n.right;
+    }
+    return line;
+}
+
+char PieceTable::char_at(size_t offset) const {
+    int node = root_;
+    while (node >= 0) {
+        const Node& n = nodes_[node];
+        size_t left_len = sum_length(n.left);
+        if (offset < left_len) {
+            node = n.left;
+            continue;
+        }
+        offset -= left_len;
+        if (offset < n.length) return buffers_[n.buffer].data[n.start + offset];
+        offset -= n.length;
+        node = n.right;
+    }
+    return '\0';
+}
+
+template <typename Fn>
+void PieceTable::for_each_span(int node, size_t base, size_t begin, size_t end, Fn& fn) const {
+    while (node >= 0) {
+        const Node& n = nodes_[node];
+        size_t piece_begin = base + sum_length(n.left);
+        size_t piece_end = piece_begin + n.length;
+        if (begin < piece_begin) {
+            for_each_span(n.left, base, begin, end, fn);
+        }
+        if (begin < piece_end && end > piece_begin) {
+            size_t from = std::max(begin, piece_begin);
+            size_t to = std::min(end, piece_end);
+            fn(buffers_[n.buffer].data + n.start + (from - piece_begin), to - from);
+        }
+        if (end <= piece_end) return;
+        base = piece_end;
+        node = n.right;
+    }
+}
+
+std::string_view PieceTable::view(size_t begin, size_t end, std::string& scratch) const {
+    end = std::min(end, size());
+    if (begin >= end) return std::string_view();
+
+    size_t offset = begin;
+    int node = root_;
+    while (node >= 0) {
+        const Node& n = nodes_[node];
+        size_t left_len = sum_length(n.left);
+        if (offset < left_len) {
+            node = n.left;
+            continue;
+        }
+        offset -= left_len;
+        if (offset < n.length) {
+            if (offset + (end - begin) <= n.length) {
+                return std::string_view(buffers_[n.buffer].data + n.start + offset, end - begin);
+            }
+            break;
+        }
+        offset -= n.length;
+        node = n.right;
+    }
+
+    copy(begin, end, scratch);
+    return scratch;
+}
+
+void PieceTable::copy(size_t begin, size_t end, std::string& out) const {
+    out.clear();
+    end = std::min(end, size());
+    if (begin >= end) return;
+    out.reserve(end - begin);
+    auto append = [&out](const char* data, size_t length) { out.append(data, length); };
+    for_each_span(root_, 0, begin, end, append);
+}
+
+std::string PieceTable::text() const {
+    std::string out;
+    copy(0, size(), out);
+    return out;
+}
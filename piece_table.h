@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "text_buffer.h"
+
+// Editable text stored as pieces of an immutable original buffer and
+// append-only add chunks. Pieces live in a treap ordered by position whose
+// nodes carry subtree byte and newline counts, so edits and line lookups
+// are O(log pieces) regardless of file size.
+class PieceTable {
+public:
+    PieceTable();
+    explicit PieceTable(TextBufferPtr original);
+
+    PieceTable(const PieceTable&) = delete;
+    PieceTable& operator=(const PieceTable&) = delete;
+
+    size_t size() const;
+    size_t newline_count() const;
+    size_t piece_count() const { return nodes_.size() - free_.size(); }
+
+    void insert(size_t offset, std::string_view text);
+    void erase(size_t offset, size_t length);
+
+    // Offset of the first byte after the n-th newline (n >= 1); 0 for n == 0.
+    size_t line_start(size_t line) const;
+    // Number of newlines before `offset`, i.e. the line containing it.
+    size_t line_of(size_t offset) const;
+    char char_at(size_t offset) const;
+
+    // Returns [begin, end) without copying when it lies in a single piece,
+    // otherwise assembles it in `scratch`. Buffers never move, so a view into
+    // a piece stays valid for the lifetime of the table.
+    std::string_view view(size_t begin, size_t end, std::string& scratch) const;
+    void copy(size_t begin, size_t end, std::string& out) const;
+    std::string text() const;
+
+private:
+    struct Buffer {
+        TextBufferPtr original;
+        std::unique_ptr<char[]> storage;
+        const char* data = nullptr;
+        size_t size = 0;
+        size_t capacity = 0;
+        std::vector<size_t> newlines;
+    };
+
+    struct Node {
+        int left = -1;
+        int right = -1;
+        uint32_t priority = 0;
+        uint32_t buffer = 0;
+        size_t start = 0;
+        size_t length = 0;
+        size_t newlines = 0;
+        size_t sumLength = 0;
+        size_t sumNewlines = 0;
+    };
+
+    size_t count_newlines(uint32_t buffer, size_t start, size_t length) const;
+    int new_node(uint32_t buffer, size_t start, size_t length);
+    void free_subtree(int node);
+    void pull(int node);
+    size_t sum_length(int node) const { return node < 0 ? 0 : nodes_[node].sumLength; }
+    size_t sum_newlines(int node) const { return node < 0 ? 0 : nodes_[node].sumNewlines; }
+    void split(int node, size_t offset, int& left_out, int& right_out);
+    int merge(int left, int right);
+    bool append_to_last_piece(int tree, std::string_view text);
+    uint32_t append_to_add_buffer(std::string_view text, size_t& start_out);
+    template <typename Fn> void for_each_span(int node, size_t base, size_t begin, size_t end, Fn& fn) const;
+
+    std::vector<Buffer> buffers_;
+    std::vector<Node> nodes_;
+    std::vector<int> free_;
+    int root_ = -1;
+    uint32_t seed_ = 0x9E3779B9u;
+};
@@ -0,0 +1,541 @@
+#include "png_writer.h"
+#include "work_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+const size_t DEFLATE_WINDOW = 32768;
+const int DEFLATE_MIN_MATCH = 3;
+const int DEFLATE_MAX_MATCH = 258;
+const int DEFLATE_HASH_BITS = 15;
+const int DEFLATE_MAX_CHAIN = 32;
+const int DEFLATE_MAX_INSERT = 32;
+const size_t PNG_SEGMENT_BYTES = 1024 * 1024;
+
+static const unsigned short LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const unsigned char LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const unsigned short DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const unsigned char DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+struct DeflateTables {
+    unsigned char lengthCode[DEFLATE_MAX_MATCH + 1];
+    unsigned char distCode[512];
+
+    DeflateTables() {
+        for (int code = 0; code < 28; ++code) {
+            for (int len = LENGTH_BASE[code]; len < LENGTH_BASE[code] + (1 << LENGTH_EXTRA[code]) && len <= DEFLATE_MAX_MATCH; ++len) {
+                lengthCode[len] = (unsigned char)code;
+            }
+        }
+        lengthCode[DEFLATE_MAX_MATCH] = 28;
+        for (int code = 0; code < 30; ++code) {
+            for (int dist = DIST_BASE[code]; dist < DIST_BASE[code] + (1 << DIST_EXTRA[code]); ++dist) {
+                distCode[dist <= 256 ? dist - 1 : 256 + ((dist - 1) >> 7)] = (unsigned char)code;
+            }
+        }
+    }
+
+    int dist_code(int dist) const {
+        return dist <= 256 ? distCode[dist - 1] : distCode[256 + ((dist - 1) >> 7)];
+    }
+};
+
+static const DeflateTables& deflate_tables() {
+    static const DeflateTables tables;
+    return tables;
+}
+
+struct Crc32Table {
+    uint32_t entries[256];
+
+    Crc32Table() {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+    }
+};
+
+uint32_t crc32_update(uint32_t crc, const unsigned char* data, size_t len) {
+    static const Crc32Table table;
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t adler32_update(uint32_t adler, const unsigned char* data, size_t len) {
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (len > 0) {
+        size_t block = std::min(len, (size_t)5552);
+        len -= block;
+        while (block--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2) {
+    const uint32_t base = 65521;
+    uint32_t rem = (uint32_t)(len2 % base);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % base);
+    sum1 += (adler2 & 0xFFFF) + base - 1;
+    sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + base - rem;
+    if (sum1 >= base) sum1 -= base;
+    if (sum1 >= base) sum1 -= base;
+    if (sum2 >= base * 2) sum2 -= base * 2;
+    if (sum2 >= base) sum2 -= base;
+    return sum1 | (sum2 << 16);
+}
+
+DeflateStream::DeflateStream(bool last_block)
+    : head_((size_t)1 << DEFLATE_HASH_BITS, -1),
+    prev_(DEFLATE_WINDOW, -1),
+    lastBlock_(last_block)
+{}
+
+static inline uint32_t deflate_hash(const unsigned char* p) {
+    return (((uint32_t)p[0] << 10) ^ ((uint32_t)p[1] << 5) ^ p[2]) & (((uint32_t)1 << DEFLATE_HASH_BITS) - 1);
+}
+
+void DeflateStream::insert_hash(size_t pos) {
+    uint32_t h = deflate_hash(window_.data() + (pos - windowBase_));
+    prev_[pos & (DEFLATE_WINDOW - 1)] = head_[h];
+    head_[h] = (int64_t)pos;
+}
+
+void DeflateStream::put_bits(uint32_t bits, int count, std::vector<unsigned char>& out) {
+    bitBuffer_ |= bits << bitCount_;
+    bitCount_ += count;
+    while (bitCount_ >= 8) {
+        out.push_back((unsigned char)bitBuffer_);
+        bitBuffer_ >>= 8;
+        bitCount_ -= 8;
+    }
+}
+
+void DeflateStream::put_huffman(uint32_t code, int length, std::vector<unsigned char>& out) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; ++i) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    put_bits(reversed, length, out);
+}
+
+void DeflateStream::put_literal(int symbol, std::vector<unsigned char>& out) {
+    if (symbol <= 143) put_huffman(0x30 + symbol, 8, out);
+    else if (symbol <= 255) put_huffman(0x190 + (symbol - 144), 9, out);
+    else if (symbol <= 279) put_huffman(symbol - 256, 7, out);
+    else put_huffman(0xC0 + (symbol - 280), 8, out);
+}
+
+void DeflateStream::put_match(int length, int distance, std::vector<unsigned char>& out) {
+    const DeflateTables& tables = deflate_tables();
+    int lcode = tables.lengthCode[length];
+    put_literal(257 + lcode, out);
+    if (LENGTH_EXTRA[lcode]) put_bits(length - LENGTH_BASE[lcode], LENGTH_EXTRA[lcode], out);
+    int dcode = tables.dist_code(distance);
+    put_huffman(dcode, 5, out);
+    if (DIST_EXTRA[dcode]) put_bits(distance - DIST_BASE[dcode], DIST_EXTRA[dcode], out);
+}
+
+void DeflateStream::compress(size_t end, std::vector<unsigned char>& out) {
+    if (!headerWritten_) {
+        put_bits(lastBlock_ ? 1 : 0, 1, out);
+        put_bits(1, 2, out);
+        headerWritten_ = true;
+    }
+
+    size_t data_end = windowBase_ + window_.size();
+    const unsigned char* base = window_.data() - windowBase_;
+    while (pos_ < end) {
+        size_t avail = data_end - pos_;
+        int best_len = 0;
+        size_t best_dist = 0;
+        if (avail >= (size_t)DEFLATE_MIN_MATCH) {
+            int max_len = (int)std::min(avail, (size_t)DEFLATE_MAX_MATCH);
+            const unsigned char* cur = base + pos_;
+            int64_t cand = head_[deflate_hash(cur)];
+            int chain = DEFLATE_MAX_CHAIN;
+            while (cand >= (int64_t)windowBase_ && pos_ - (size_t)cand <= DEFLATE_WINDOW && chain-- > 0) {
+                const unsigned char* match = base + cand;
+                if (match[best_len] == cur[best_len] && match[0] == cur[0]) {
+                    int len = 0;
+                    while (len < max_len && match[len] == cur[len]) ++len;
+                    if (len > best_len) {
+                        best_len = len;
+                        best_dist = pos_ - (size_t)cand;
+                        if (len == max_len) break;
+                    }
+                }
+                int64_t next = prev_[(size_t)cand & (DEFLATE_WINDOW - 1)];
+                if (next >= cand) break;
+                cand = next;
+            }
+            insert_hash(pos_);
+        }
+
+        if (best_len >= DEFLATE_MIN_MATCH) {
+            put_match(best_len, (int)best_dist, out);
+            if (best_len <= DEFLATE_MAX_INSERT) {
+                for (size_t p = pos_ + 1; p < pos_ + best_len; ++p) {
+                    if (p + DEFLATE_MIN_MATCH <= data_end) insert_hash(p);
+                }
+            }
+            else if (pos_ + best_len + DEFLATE_MIN_MATCH <= data_end + 1) {
+                insert_hash(pos_ + best_len - 1);
+            }
+            pos_ += best_len;
+        }
+        else {
+            put_literal(base[pos_], out);
+            pos_++;
+        }
+    }
+}
+
+void DeflateStream::write(const unsigned char* data, size_t len, std::vector<unsigned char>& out) {
+    window_.insert(window_.end(), data, data + len);
+    size_t data_end = windowBase_ + window_.size();
+    if (data_end >= pos_ + DEFLATE_MAX_MATCH) {
+        compress(data_end - DEFLATE_MAX_MATCH, out);
+    }
+
+    if (pos_ > windowBase_ + 2 * DEFLATE_WINDOW) {
+        size_t drop = pos_ - DEFLATE_WINDOW - windowBase_;
+        window_.erase(window_.begin(), window_.begin() + drop);
+        windowBase_ += drop;
+    }
+}
+
+void DeflateStream::set_dictionary(const unsigned char* data, size_t len) {
+    len = std::min(len, DEFLATE_WINDOW);
+    window_.assign(data, data + len);
+    windowBase_ = 0;
+    for (size_t p = 0; p + DEFLATE_MIN_MATCH <= len; ++p) {
+        insert_hash(p);
+    }
+    pos_ = len;
+}
+
+void DeflateStream::finish(std::vector<unsigned char>& out) {
+    compress(windowBase_ + window_.size(), out);
+    put_literal(256, out);
+    if (!lastBlock_) {
+        put_bits(0, 3, out);
+        if (bitCount_ > 0) put_bits(0, 8 - bitCount_, out);
+        const unsigned char sync_marker[4] = { 0x00, 0x00, 0xFF, 0xFF };
+        out.insert(out.end(), sync_marker, sync_marker + 4);
+    }
+    else if (bitCount_ > 0) {
+        put_bits(0, 8 - bitCount_, out);
+    }
+}
+
+static void put_be32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+struct PngSegment {
+    std::vector<unsigned char> context;
+    int contextRows = 0;
+    std::vector<unsigned char> rows;
+    int rowCount = 0;
+    bool last = false;
+
+    std::vector<unsigned char> output;
+    uint32_t adler = 1;
+    size_t filteredSize = 0;
+    bool done = false;
+};
+
+static inline unsigned char paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return (unsigned char)a;
+    return (unsigned char)(pb <= pc ? b : c);
+}
+
+static size_t filter_cost(const unsigned char* data, size_t len) {
+    size_t cost = 0;
+    for (size_t i = 0; i < len; ++i) {
+        signed char v = (signed char)data[i];
+        cost += v < 0 ? -v : v;
+    }
+    return cost;
+}
+
+static void filter_row(const unsigned char* row, const unsigned char* up, size_t len,
+    std::vector<unsigned char>& filtered, std::vector<unsigned char>& candidate)
+{
+    size_t best_cost = (size_t)-1;
+    for (int type = 0; type < 5; ++type) {
+        unsigned char* dst = candidate.data() + 1;
+        switch (type) {
+        case 0:
+            memcpy(dst, row, len);
+            break;
+        case 1:
+            memcpy(dst, row, std::min(len, (size_t)4));
+            for (size_t i = 4; i < len; ++i) dst[i] = (unsigned char)(row[i] - row[i - 4]);
+            break;
+        case 2:
+            for (size_t i = 0; i < len; ++i) dst[i] = (unsigned char)(row[i] - up[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < std::min(len, (size_t)4); ++i) dst[i] = (unsigned char)(row[i] - (up[i] >> 1));
+            for (size_t i = 4; i < len; ++i) dst[i] = (unsigned char)(row[i] - ((row[i - 4] + up[i]) >> 1));
+            break;
+        case 4:
+            for (size_t i = 0; i < std::min(len, (size_t)4); ++i) dst[i] = (unsigned char)(row[i] - up[i]);
+            for (size_t i = 4; i < len; ++i) dst[i] = (unsigned char)(row[i] - paeth(row[i - 4], up[i], up[i - 4]));
+            break;
+        }
+        size_t cost = filter_cost(dst, len);
+        if (cost < best_cost) {
+            best_cost = cost;
+            candidate[0] = (unsigned char)type;
+            filtered.swap(candidate);
+        }
+    }
+}
+
+static void encode_segment(PngSegment& segment, size_t row_bytes) {
+    std::vector<unsigned char> zero_row(row_bytes, 0);
+    std::vector<unsigned char> filtered(row_bytes + 1);
+    std::vector<unsigned char> candidate(row_bytes + 1);
+
+    const unsigned char* up = zero_row.data();
+    std::vector<unsigned char> dictionary;
+    for (int r = 0; r < segment.contextRows; ++r) {
+        const unsigned char* row = segment.context.data() + (size_t)r * row_bytes;
+        if (r > 0) {
+            filter_row(row, up, row_bytes, filtered, candidate);
+            dictionary.insert(dictionary.end(), filtered.begin(), filtered.end());
+        }
+        up = row;
+    }
+
+    DeflateStream deflate(segment.last);
+    if (!dictionary.empty()) {
+        size_t keep = std::min(dictionary.size(), DEFLATE_WINDOW);
+        deflate.set_dictionary(dictionary.data() + dictionary.size() - keep, keep);
+    }
+
+    segment.output.reserve(segment.rows.size() / 4);
+    for (int r = 0; r < segment.rowCount; ++r) {
+        const unsigned char* row = segment.rows.data() + (size_t)r * row_bytes;
+        filter_row(row, up, row_bytes, filtered, candidate);
+        segment.adler = adler32_update(segment.adler, filtered.data(), filtered.size());
+        segment.filteredSize += filtered.size();
+        deflate.write(filtered.data(), filtered.size(), segment.output);
+        up = row;
+    }
+    deflate.finish(segment.output);
+
+    std::vector<unsigned char>().swap(segment.rows);
+    std::vector<unsigned char>().swap(segment.context);
+}
+
+PngStreamWriter::PngStreamWriter() = default;
+
+PngStreamWriter::~PngStreamWriter() {
+    wait_for_segments();
+    pool_.reset();
+    if (file_) fclose(file_);
+}
+
+bool PngStreamWriter::write_chunk(const char type[4], const unsigned char* data, size_t len) {
+    unsigned char header[8];
+    put_be32(header, (uint32_t)len);
+    memcpy(header + 4, type, 4);
+    uint32_t crc = crc32_update(0, header + 4, 4);
+    crc = crc32_update(crc, data, len);
+    unsigned char trailer[4];
+    put_be32(trailer, crc);
+    return fwrite(header, 1, 8, file_) == 8
+        && (len == 0 || fwrite(data, 1, len, file_) == len)
+        && fwrite(trailer, 1, 4, file_) == 4;
+}
+
+bool PngStreamWriter::open(const char* path, int width, int height, std::string& error_out, int thread_count) {
+    if (width <= 0 || height <= 0) {
+        error_out = "Invalid image size.";
+        return false;
+    }
+    file_ = fopen(path, "wb");
+    if (!file_) {
+        error_out = std::string("Could not open file for writing: ") + path;
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    rowsWritten_ = 0;
+    rowBytes_ = (size_t)width * 4;
+    segmentRows_ = (int)std::max((size_t)1, PNG_SEGMENT_BYTES / (rowBytes_ + 1));
+    contextRows_ = (int)((DEFLATE_WINDOW + rowBytes_) / (rowBytes_ + 1)) + 1;
+    pendingRows_.reserve((size_t)segmentRows_ * rowBytes_);
+
+    if (thread_count <= 0) {
+        thread_count = (int)std::thread::hardware_concurrency();
+    }
+    if (thread_count > 1) {
+        pool_.reset(new WorkStealingPool(thread_count));
+        maxInFlight_ = (size_t)thread_count * 2;
+    }
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    unsigned char ihdr[13];
+    put_be32(ihdr, (uint32_t)width);
+    put_be32(ihdr + 4, (uint32_t)height);
+    ihdr[8] = 8;
+    ihdr[9] = 6;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+    if (fwrite(signature, 1, 8, file_) != 8 || !write_chunk("IHDR", ihdr, sizeof(ihdr))) {
+        error_out = "Failed to write PNG header.";
+        return false;
+    }
+    return true;
+}
+
+void PngStreamWriter::dispatch_segment() {
+    std::shared_ptr<PngSegment> segment = std::make_shared<PngSegment>();
+    segment->context = tailRows_;
+    segment->contextRows = tailRowCount_;
+    segment->rowCount = pendingRowCount_;
+    segment->last = rowsWritten_ == height_;
+
+    std::vector<unsigned char> combined;
+    int combined_rows = tailRowCount_ + pendingRowCount_;
+    int keep_rows = std::min(contextRows_, combined_rows);
+    if (pendingRowCount_ >= keep_rows) {
+        tailRows_.assign(pendingRows_.end() - (size_t)keep_rows * rowBytes_, pendingRows_.end());
+    }
+    else {
+        combined = tailRows_;
+        combined.insert(combined.end(), pendingRows_.begin(), pendingRows_.end());
+        tailRows_.assign(combined.end() - (size_t)keep_rows * rowBytes_, combined.end());
+    }
+    tailRowCount_ = keep_rows;
+
+    segment->rows.swap(pendingRows_);
+    pendingRows_.clear();
+    pendingRows_.reserve((size_t)segmentRows_ * rowBytes_);
+    pendingRowCount_ = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(segmentMutex_);
+        inFlight_.push_back(segment);
+    }
+
+    if (!pool_) {
+        encode_segment(*segment, rowBytes_);
+        segment->done = true;
+        return;
+    }
+
+    size_t row_bytes = rowBytes_;
+    pool_->submit([this, segment, row_bytes](int) {
+        encode_segment(*segment, row_bytes);
+        std::lock_guard<std::mutex> lock(segmentMutex_);
+        segment->done = true;
+        segmentDone_.notify_all();
+    });
+}
+
+bool PngStreamWriter::drain_segments(size_t max_in_flight) {
+    for (;;) {
+        std::shared_ptr<PngSegment> segment;
+        {
+            std::unique_lock<std::mutex> lock(segmentMutex_);
+            if (inFlight_.empty()) return true;
+            if (inFlight_.size() > max_in_flight) {
+                segmentDone_.wait(lock, [this] { return inFlight_.front()->done; });
+            }
+            else if (!inFlight_.front()->done) {
+                return true;
+            }
+            segment = inFlight_.front();
+            inFlight_.pop_front();
+        }
+
+        idat_.clear();
+        if (headerPending_) {
+            idat_.push_back(0x78);
+            idat_.push_back(0x01);
+            headerPending_ = false;
+        }
+        idat_.insert(idat_.end(), segment->output.begin(), segment->output.end());
+        adler_ = adler32_combine(adler_, segment->adler, segment->filteredSize);
+        if (segment->last) {
+            unsigned char adler[4];
+            put_be32(adler, adler_);
+            idat_.insert(idat_.end(), adler, adler + 4);
+        }
+        if (!write_chunk("IDAT", idat_.data(), idat_.size())) {
+            return false;
+        }
+    }
+}
+
+void PngStreamWriter::wait_for_segments() {
+    std::unique_lock<std::mutex> lock(segmentMutex_);
+    segmentDone_.wait(lock, [this] {
+        for (const std::shared_ptr<PngSegment>& segment : inFlight_) {
+            if (!segment->done) return false;
+        }
+        return true;
+    });
+}
+
+bool PngStreamWriter::write_rows(const unsigned char* rgba, int rows, size_t stride, std::string& error_out) {
+    if (!file_ || rowsWritten_ + rows > height_) {
+        error_out = "Too many rows written to PNG.";
+        return false;
+    }
+    for (int y = 0; y < rows; ++y) {
+        const unsigned char* row = rgba + (size_t)y * stride;
+        pendingRows_.insert(pendingRows_.end(), row, row + rowBytes_);
+        pendingRowCount_++;
+        rowsWritten_++;
+        if (pendingRowCount_ == segmentRows_ || rowsWritten_ == height_) {
+            dispatch_segment();
+            if (!drain_segments(maxInFlight_)) {
+                error_out = "Failed to write PNG data.";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool PngStreamWriter::finish(std::string& error_out) {
+    if (!file_) {
+        error_out = "PNG file is not open.";
+        return false;
+    }
+    if (rowsWritten_ != height_) {
+        error_out = "PNG image is incomplete.";
+        return false;
+    }
+
+    bool ok = drain_segments(0) && write_chunk("IEND", nullptr, 0);
+    ok = (fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    if (!ok) {
+        error_out = "Failed to write PNG data.";
+    }
+    return ok;
+}
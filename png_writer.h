@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class WorkStealingPool;
+
+class DeflateStream {
+public:
+    explicit DeflateStream(bool last_block = true);
+
+    void set_dictionary(const unsigned char* data, size_t len);
+    void write(const unsigned char* data, size_t len, std::vector<unsigned char>& out);
+    void finish(std::vector<unsigned char>& out);
+
+private:
+    void compress(size_t end, std::vector<unsigned char>& out);
+    void insert_hash(size_t pos);
+    void put_bits(uint32_t bits, int count, std::vector<unsigned char>& out);
+    void put_huffman(uint32_t code, int length, std::vector<unsigned char>& out);
+    void put_literal(int symbol, std::vector<unsigned char>& out);
+    void put_match(int length, int distance, std::vector<unsigned char>& out);
+
+    std::vector<unsigned char> window_;
+    size_t windowBase_ = 0;
+    size_t pos_ = 0;
+    std::vector<int64_t> head_;
+    std::vector<int64_t> prev_;
+    uint32_t bitBuffer_ = 0;
+    int bitCount_ = 0;
+    bool lastBlock_ = true;
+    bool headerWritten_ = false;
+};
+
+struct PngSegment;
+
+class PngStreamWriter {
+public:
+    PngStreamWriter();
+    ~PngStreamWriter();
+
+    PngStreamWriter(const PngStreamWriter&) = delete;
+    PngStreamWriter& operator=(const PngStreamWriter&) = delete;
+
+    bool open(const char* path, int width, int height, std::string& error_out, int thread_count = 0);
+    bool write_rows(const unsigned char* rgba, int rows, size_t stride, std::string& error_out);
+    bool finish(std::string& error_out);
+
+private:
+    bool write_chunk(const char type[4], const unsigned char* data, size_t len);
+    void dispatch_segment();
+    bool drain_segments(size_t max_in_flight);
+    void wait_for_segments();
+
+    FILE* file_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    int rowsWritten_ = 0;
+    size_t rowBytes_ = 0;
+    int segmentRows_ = 0;
+    int contextRows_ = 0;
+    std::vector<unsigned char> pendingRows_;
+    int pendingRowCount_ = 0;
+    std::vector<unsigned char> tailRows_;
+    int tailRowCount_ = 0;
+    bool headerPending_ = true;
+    uint32_t adler_ = 1;
+    std::vector<unsigned char> idat_;
+
+    std::unique_ptr<WorkStealingPool> pool_;
+    size_t maxInFlight_ = 1;
+    std::deque<std::shared_ptr<PngSegment>> inFlight_;
+    std::mutex segmentMutex_;
+    std::condition_variable segmentDone_;
+};
+
+uint32_t crc32_update(uint32_t crc, const unsigned char* data, size_t len);
+uint32_t adler32_update(uint32_t adler, const unsigned char* data, size_t len);
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2);
@@ -0,0 +1,103 @@
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+const size_t PROFILER_RING_SIZE = 1 << 15;
+
+// Each slot is a small seqlock: the writer marks it odd while filling it and
+// stores 2 * index + 2 when done, so a reader can tell a complete event for
+// the index it expects from one in progress or already overwritten.
+struct ProfileSlot {
+    std::atomic<uint64_t> sequence{ 0 };
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<uint64_t> startNs{ 0 };
+    std::atomic<uint64_t> durationNs{ 0 };
+    std::atomic<uint32_t> threadId{ 0 };
+};
+
+static ProfileSlot s_ring[PROFILER_RING_SIZE];
+static std::atomic<uint64_t> s_write_index{ 0 };
+static std::atomic<uint32_t> s_next_thread_id{ 0 };
+
+static uint32_t current_thread_id() {
+    thread_local uint32_t id = s_next_thread_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    return id;
+}
+
+uint64_t profiler_now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void profiler_record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    uint64_t index = s_write_index.fetch_add(1, std::memory_order_relaxed);
+    ProfileSlot& slot = s_ring[index & (PROFILER_RING_SIZE - 1)];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(start_ns, std::memory_order_relaxed);
+    slot.durationNs.store(end_ns - start_ns, std::memory_order_relaxed);
+    slot.threadId.store(current_thread_id(), std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void profiler_frame_mark() {
+    static uint64_t last_mark = profiler_now_ns();
+    uint64_t now = profiler_now_ns();
+    profiler_record("frame", last_mark, now);
+    last_mark = now;
+}
+
+void profiler_read(std::vector<ProfileEvent>& out, uint64_t& cursor) {
+    uint64_t end = s_write_index.load(std::memory_order_acquire);
+    if (end - cursor > PROFILER_RING_SIZE) cursor = end - PROFILER_RING_SIZE;
+    for (; cursor < end; ++cursor) {
+        const ProfileSlot& slot = s_ring[cursor & (PROFILER_RING_SIZE - 1)];
+        uint64_t expected = 2 * cursor + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != expected) continue;
+        ProfileEvent event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+        event.threadId = slot.threadId.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) continue;
+        out.push_back(event);
+    }
+}
+
+bool profiler_write_chrome_trace(const char* path, std::string& error_out) {
+    std::vector<ProfileEvent> events;
+    uint64_t cursor = 0;
+    profiler_read(events, cursor);
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        error_out = "Cannot open file for writing";
+        return false;
+    }
+    uint64_t origin = events.empty() ? 0 : events.front().startNs;
+    for (const ProfileEvent& event : events) origin = std::min(origin, event.startNs);
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    for (size_t i = 0; i < events.size(); ++i) {
+        const ProfileEvent& event = events[i];
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"codeviewer\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            i ? ",\n" : "", event.name, event.threadId, (event.startNs - origin) / 1000.0, event.durationNs / 1000.0);
+    }
+    fputs("\n]}\n", file);
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) error_out = "Failed while writing trace file";
+    return ok;
+}
+
+bool profiler_enabled() {
+#ifdef CODEVIEWER_PROFILER
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped stage timers recorded into a fixed lock-free ring. Without
+// CODEVIEWER_PROFILER the macros expand to nothing, so instrumented code
+// carries no timing calls; the reader side below then just sees no events.
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint32_t threadId;
+};
+
+uint64_t profiler_now_ns();
+void profiler_record(const char* name, uint64_t start_ns, uint64_t end_ns);
+void profiler_frame_mark();
+
+// Appends events recorded since `cursor` and advances it. Events overwritten
+// before they were read are skipped.
+void profiler_read(std::vector<ProfileEvent>& out, uint64_t& cursor);
+bool profiler_write_chrome_trace(const char* path, std::string& error_out);
+bool profiler_enabled();
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : name_(name), start_(profiler_now_ns()) {}
+    ~ProfileScope() { profiler_record(name_, start_, profiler_now_ns()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_;
+};
+
+#ifdef CODEVIEWER_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_FRAME_MARK() profiler_frame_mark()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FRAME_MARK() ((void)0)
+#endif
@@ -0,0 +1,615 @@
+#include "regex_dfa.h"
+#include <algorithm>
+#include <cstring>
+
+const int MAX_NFA_STATES = 20000;
+const int MAX_REPEAT = 1000;
+const size_t MAX_DFA_STATES = 4096;
+
+struct RegexNode {
+    enum Type { Empty, Set, Concat, Alt, Repeat, LineStart, LineEnd };
+    Type type = Empty;
+    ByteSet set;
+    std::vector<int> children;
+    int min = 0;
+    int max = 0;
+};
+
+class RegexParser {
+public:
+    RegexParser(const std::string& pattern, bool case_sensitive)
+        : pattern_(pattern), case_sensitive_(case_sensitive) {}
+
+    bool parse(std::vector<RegexNode>& nodes_out, int& root_out, std::string& error_out) {
+        int root = parse_alt();
+        if (error_.empty() && pos_ < pattern_.size()) {
+            error_ = "Unmatched ')'";
+        }
+        if (!error_.empty()) {
+            error_out = error_;
+            return false;
+        }
+        nodes_out = std::move(nodes_);
+        root_out = root;
+        return true;
+    }
+
+private:
+    int add(RegexNode node) {
+        nodes_.push_back(std::move(node));
+        return (int)nodes_.size() - 1;
+    }
+
+    int add_set(ByteSet set) {
+        set.bits[0] &= ~((uint64_t)1 << '\n');
+        if (!case_sensitive_) {
+            for (unsigned c = 'a'; c <= 'z'; ++c) {
+                unsigned char upper = (unsigned char)(c - 'a' + 'A');
+                if (set.test((unsigned char)c) || set.test(upper)) {
+                    set.set((unsigned char)c);
+                    set.set(upper);
+                }
+            }
+        }
+        RegexNode node;
+        node.type = RegexNode::Set;
+        node.set = set;
+        return add(node);
+    }
+
+    bool at_end() const { return pos_ >= pattern_.size(); }
+    char peek() const { return pattern_[pos_]; }
+
+    int parse_alt() {
+        std::vector<int> branches;
+        branches.push_back(parse_concat());
+        while (error_.empty() && !at_end() && peek() == '|') {
+            pos_++;
+            branches.push_back(parse_concat());
+        }
+        if (branches.size() == 1) return branches[0];
+        RegexNode node;
+        node.type = RegexNode::Alt;
+        node.children = std::move(branches);
+        return add(node);
+    }
+
+    int parse_concat() {
+        std::vector<int> items;
+        while (error_.empty() && !at_end() && peek() != '|' && peek() != ')') {
+            int item = parse_repeat();
+            if (item >= 0) items.push_back(item);
+        }
+        if (items.size() == 1) return items[0];
+        RegexNode node;
+        node.type = items.empty() ? RegexNode::Empty : RegexNode::Concat;
+        node.children = std::move(items);
+        return add(node);
+    }
+
+    bool parse_int(int& value) {
+        size_t start = pos_;
+        value = 0;
+        while (!at_end() && peek() >= '0' && peek() <= '9') {
+            value = std::min(value * 10 + (peek() - '0'), MAX_REPEAT + 1);
+            pos_++;
+        }
+        return pos_ > start;
+    }
+
+    bool parse_braces(int& min, int& max) {
+        size_t saved = pos_;
+        pos_++;
+        if (!parse_int(min)) { pos_ = saved; return false; }
+        max = min;
+        if (!at_end() && peek() == ',') {
+            pos_++;
+            if (!parse_int(max)) max = -1;
+        }
+        if (at_end() || peek() != '}') { pos_ = saved; return false; }
+        pos_++;
+        return true;
+    }
+
+    int parse_repeat() {
+        int atom = parse_atom();
+        while (error_.empty() && !at_end()) {
+            int min = 0;
+            int max = 0;
+            char c = peek();
+            if (c == '*') { min = 0; max = -1; pos_++; }
+            else if (c == '+') { min = 1; max = -1; pos_++; }
+            else if (c == '?') { min = 0; max = 1; pos_++; }
+            else if (c == '{' && parse_braces(min, max)) {}
+            else break;
+
+            if (min > MAX_REPEAT || max > MAX_REPEAT || (max >= 0 && max < min)) {
+                error_ = "Invalid repetition count";
+                return -1;
+            }
+            if (!at_end() && peek() == '?') pos_++;
+            if (atom < 0) {
+                error_ = "Nothing to repeat";
+                return -1;
+            }
+            RegexNode node;
+            node.type = RegexNode::Repeat;
+            node.children.push_back(atom);
+            node.min = min;
+            node.max = max;
+            atom = add(node);
+        }
+        return atom;
+    }
+
+    static ByteSet class_set(char c) {
+        ByteSet set;
+        switch (c) {
+        case 'd': case 'D':
+            set.set_range('0', '9');
+            break;
+        case 'w': case 'W':
+            set.set_range('a', 'z');
+            set.set_range('A', 'Z');
+            set.set_range('0', '9');
+            set.set('_');
+            break;
+        case 's': case 'S':
+            set.set(' '); set.set('\t'); set.set('\r'); set.set('\v'); set.set('\f');
+            break;
+        }
+        if (c == 'D' || c == 'W' || c == 'S') set.invert();
+        return set;
+    }
+
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool parse_escape(ByteSet& set_out, bool& is_class_out) {
+        is_class_out = false;
+        if (at_end()) {
+            error_ = "Trailing backslash";
+            return false;
+        }
+        char c = pattern_[pos_++];
+        switch (c) {
+        case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+            set_out = class_set(c);
+            is_class_out = true;
+            return true;
+        case 'n': set_out.set('\n'); return true;
+        case 't': set_out.set('\t'); return true;
+        case 'r': set_out.set('\r'); return true;
+        case 'f': set_out.set('\f'); return true;
+        case 'v': set_out.set('\v'); return true;
+        case '0': set_out.set('\0'); return true;
+        case 'x': {
+            if (pos_ + 2 > pattern_.size() || hex_value(pattern_[pos_]) < 0 || hex_value(pattern_[pos_ + 1]) < 0) {
+                error_ = "Invalid \\x escape";
+                return false;
+            }
+            set_out.set((unsigned char)(hex_value(pattern_[pos_]) * 16 + hex_value(pattern_[pos_ + 1])));
+            pos_ += 2;
+            return true;
+        }
+        default:
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+                error_ = std::string("Unsupported escape \\") + c;
+                return false;
+            }
+            set_out.set((unsigned char)c);
+            return true;
+        }
+    }
+
+    int parse_bracket() {
+        ByteSet set;
+        bool negate = false;
+        if (!at_end() && peek() == '^') { negate = true; pos_++; }
+        bool first = true;
+        while (true) {
+            if (at_end()) {
+                error_ = "Unterminated character class";
+                return -1;
+            }
+            char c = peek();
+            if (c == ']' && !first) { pos_++; break; }
+            first = false;
+
+            ByteSet item;
+            bool is_class = false;
+            unsigned char lo = 0;
+            if (c == '\\') {
+                pos_++;
+                if (!parse_escape(item, is_class)) return -1;
+                if (is_class) { set.merge(item); continue; }
+                for (unsigned b = 0; b < 256; ++b) if (item.test((unsigned char)b)) { lo = (unsigned char)b; break; }
+            }
+            else {
+                lo = (unsigned char)c;
+                pos_++;
+            }
+
+            if (pos_ + 1 < pattern_.size() && peek() == '-' && pattern_[pos_ + 1] != ']') {
+                pos_++;
+                unsigned char hi = (unsigned char)pattern_[pos_];
+                if (hi == '\\') {
+                    pos_++;
+                    ByteSet hi_set;
+                    if (!parse_escape(hi_set, is_class)) return -1;
+                    if (is_class) { error_ = "Invalid class range"; return -1; }
+                    for (unsigned b = 0; b < 256; ++b) if (hi_set.test((unsigned char)b)) { hi = (unsigned char)b; break; }
+                }
+                else {
+                    pos_++;
+                }
+                if (hi < lo) { error_ = "Invalid class range"; return -1; }
+                set.set_range(lo, hi);
+            }
+            else {
+                set.set(lo);
+            }
+        }
+        if (negate) set.invert();
+        return add_set(set);
+    }
+
+    int parse_atom() {
+        char c = pattern_[pos_++];
+        switch (c) {
+        case '(': {
+            if (pos_ + 1 < pattern_.size() && peek() == '?' && pattern_[pos_ + 1] == ':') pos_ += 2;
+            int inner = parse_alt();
+            if (!error_.empty()) return -1;
+            if (at_end() || peek() != ')') {
+                error_ = "Missing ')'";
+                return -1;
+            }
+            pos_++;
+            return inner;
+        }
+        case '[':
+            return parse_bracket();
+        case '.': {
+            ByteSet set;
+            set.invert();
+            return add_set(set);
+        }
+        case '^': {
+            RegexNode node;
+            node.type = RegexNode::LineStart;
+            return add(node);
+        }
+        case '$': {
+            RegexNode node;
+            node.type = RegexNode::LineEnd;
+            return add(node);
+        }
+        case '*': case '+': case '?':
+            error_ = "Nothing to repeat";
+            return -1;
+        case '\\': {
+            ByteSet set;
+            bool is_class = false;
+            if (!parse_escape(set, is_class)) return -1;
+            return add_set(set);
+        }
+        default: {
+            ByteSet set;
+            set.set((unsigned char)c);
+            return add_set(set);
+        }
+        }
+    }
+
+    const std::string& pattern_;
+    bool case_sensitive_;
+    size_t pos_ = 0;
+    std::vector<RegexNode> nodes_;
+    std::string error_;
+};
+
+class NfaBuilder {
+public:
+    NfaBuilder(const std::vector<RegexNode>& nodes, RegexNfa& nfa, bool reverse)
+        : nodes_(nodes), nfa_(nfa), reverse_(reverse) {}
+
+    bool build(int root) {
+        nfa_.states.clear();
+        RegexNfaState match;
+        match.kind = RegexNfaState::Match;
+        int match_id = add(match);
+        nfa_.start = build_node(root, match_id);
+        return !overflow_;
+    }
+
+private:
+    int add(const RegexNfaState& state) {
+        if ((int)nfa_.states.size() >= MAX_NFA_STATES) {
+            overflow_ = true;
+            return 0;
+        }
+        nfa_.states.push_back(state);
+        return (int)nfa_.states.size() - 1;
+    }
+
+    int add_split(int out, int out1) {
+        RegexNfaState split;
+        split.kind = RegexNfaState::Split;
+        split.out = out;
+        split.out1 = out1;
+        return add(split);
+    }
+
+    int build_node(int index, int next) {
+        if (overflow_) return 0;
+        const RegexNode& node = nodes_[index];
+        switch (node.type) {
+        case RegexNode::Empty:
+            return next;
+        case RegexNode::Set: {
+            RegexNfaState state;
+            state.kind = RegexNfaState::Bytes;
+            state.bytes = node.set;
+            state.out = next;
+            return add(state);
+        }
+        case RegexNode::LineStart:
+        case RegexNode::LineEnd: {
+            RegexNfaState state;
+            state.kind = RegexNfaState::Assert;
+            state.symbol = node.type == RegexNode::LineStart ? RegexSymbol_LineStart : RegexSymbol_LineEnd;
+            state.out = next;
+            return add(state);
+        }
+        case RegexNode::Concat:
+            if (reverse_) {
+                for (size_t i = 0; i < node.children.size(); ++i) next = build_node(node.children[i], next);
+            }
+            else {
+                for (size_t i = node.children.size(); i-- > 0;) next = build_node(node.children[i], next);
+            }
+            return next;
+        case RegexNode::Alt: {
+            int entry = build_node(node.children.back(), next);
+            for (size_t i = node.children.size() - 1; i-- > 0;) {
+                entry = add_split(build_node(node.children[i], next), entry);
+            }
+            return entry;
+        }
+        case RegexNode::Repeat: {
+            int child = node.children[0];
+            int tail = next;
+            if (node.max < 0) {
+                int loop = add_split(-1, next);
+                if (overflow_) return 0;
+                int body = build_node(child, loop);
+                nfa_.states[loop].out = body;
+                tail = loop;
+            }
+            else {
+                for (int i = node.min; i < node.max; ++i) {
+                    tail = add_split(build_node(child, tail), next);
+                }
+            }
+            for (int i = 0; i < node.min; ++i) {
+                tail = build_node(child, tail);
+            }
+            return tail;
+        }
+        }
+        return next;
+    }
+
+    const std::vector<RegexNode>& nodes_;
+    RegexNfa& nfa_;
+    bool reverse_;
+    bool overflow_ = false;
+};
+
+void LazyDfa::init(const RegexNfa* nfa, bool unanchored) {
+    nfa_ = nfa;
+    unanchored_ = unanchored;
+    reset_cache();
+}
+
+void LazyDfa::reset_cache() {
+    sets_.clear();
+    match_.clear();
+    transitions_.clear();
+    index_.clear();
+    visit_mark_.assign(nfa_ ? nfa_->states.size() : 0, 0);
+    visit_generation_ = 0;
+
+    std::vector<int> dead;
+    intern(dead);
+    start_ = -1;
+}
+
+void LazyDfa::add_closure(int nfa_state, std::vector<int>& out) {
+    std::vector<int> stack(1, nfa_state);
+    while (!stack.empty()) {
+        int s = stack.back();
+        stack.pop_back();
+        if (s < 0 || visit_mark_[s] == visit_generation_) continue;
+        visit_mark_[s] = visit_generation_;
+        const RegexNfaState& state = nfa_->states[s];
+        if (state.kind == RegexNfaState::Split) {
+            stack.push_back(state.out1);
+            stack.push_back(state.out);
+        }
+        else {
+            out.push_back(s);
+        }
+    }
+}
+
+int LazyDfa::intern(std::vector<int>& nfa_set) {
+    std::sort(nfa_set.begin(), nfa_set.end());
+    std::string key(reinterpret_cast<const char*>(nfa_set.data()), nfa_set.size() * sizeof(int));
+    auto it = index_.find(key);
+    if (it != index_.end()) return it->second;
+
+    int id = (int)sets_.size();
+    bool match = false;
+    for (int s : nfa_set) {
+        if (nfa_->states[s].kind == RegexNfaState::Match) { match = true; break; }
+    }
+    sets_.push_back(nfa_set);
+    match_.push_back(match ? 1 : 0);
+    transitions_.resize(sets_.size() * RegexSymbol_Count, -1);
+    if (id == 0) {
+        std::fill(transitions_.begin(), transitions_.end(), 0);
+    }
+    index_.emplace(std::move(key), id);
+    return id;
+}
+
+int LazyDfa::start_state() {
+    if (start_ < 0) {
+        std::vector<int> set;
+        visit_generation_++;
+        add_closure(nfa_->start, set);
+        start_ = intern(set);
+    }
+    return start_;
+}
+
+int LazyDfa::compute_step(int state, int symbol) {
+    if (sets_.size() >= MAX_DFA_STATES) {
+        std::vector<int> current = sets_[state];
+        reset_cache();
+        state = intern(current);
+    }
+
+    std::vector<int> next;
+    visit_generation_++;
+    const std::vector<int>& current = sets_[state];
+    if (symbol >= 256) {
+        for (int s : current) {
+            visit_mark_[s] = visit_generation_;
+            next.push_back(s);
+        }
+        for (size_t i = 0; i < next.size(); ++i) {
+            const RegexNfaState& nfa_state = nfa_->states[next[i]];
+            if (nfa_state.kind == RegexNfaState::Assert && nfa_state.symbol == symbol) {
+                add_closure(nfa_state.out, next);
+            }
+        }
+    }
+    else {
+        for (int s : current) {
+            const RegexNfaState& nfa_state = nfa_->states[s];
+            if (nfa_state.kind == RegexNfaState::Bytes && nfa_state.bytes.test((unsigned char)symbol)) {
+                add_closure(nfa_state.out, next);
+            }
+        }
+        if (unanchored_ && symbol != '\n') {
+            add_closure(nfa_->start, next);
+        }
+    }
+
+    int target = intern(next);
+    transitions_[(size_t)state * RegexSymbol_Count + symbol] = target;
+    return target;
+}
+
+bool RegexMatcher::compile(const std::string& pattern, bool case_sensitive, std::string& error_out) {
+    forward_ = RegexNfa();
+    reverse_ = RegexNfa();
+
+    std::vector<RegexNode> nodes;
+    int root = -1;
+    RegexParser parser(pattern, case_sensitive);
+    if (!parser.parse(nodes, root, error_out)) {
+        return false;
+    }
+
+    NfaBuilder forward_builder(nodes, forward_, false);
+    NfaBuilder reverse_builder(nodes, reverse_, true);
+    if (!forward_builder.build(root) || !reverse_builder.build(root)) {
+        forward_ = RegexNfa();
+        reverse_ = RegexNfa();
+        error_out = "Pattern is too large";
+        return false;
+    }
+
+    scan_.init(&forward_, true);
+    starts_.init(&reverse_, true);
+    longest_.init(&forward_, false);
+    return true;
+}
+
+void RegexMatcher::match_line(const char* text, size_t line_begin, size_t line_end,
+    std::vector<size_t>& positions_out, std::vector<uint32_t>& lengths_out)
+{
+    size_t len = line_end - line_begin;
+    start_marks_.assign(len + 1, 0);
+
+    int state = starts_.step(starts_.start_state(), RegexSymbol_LineEnd);
+    if (starts_.is_match(state)) start_marks_[len] = 1;
+    for (size_t i = len; i-- > 0;) {
+        state = starts_.step(state, (unsigned char)text[line_begin + i]);
+        int check = (i == 0) ? starts_.step(state, RegexSymbol_LineStart) : state;
+        if (starts_.is_match(check)) start_marks_[i] = 1;
+    }
+
+    size_t resume = 0;
+    for (size_t s = 0; s < len; ++s) {
+        if (!start_marks_[s] || s < resume) continue;
+
+        int st = longest_.start_state();
+        if (s == 0) st = longest_.step(st, RegexSymbol_LineStart);
+        size_t best = longest_.is_match(st) ? s : SIZE_MAX;
+        size_t j = s;
+        for (; j < len; ++j) {
+            st = longest_.step(st, (unsigned char)text[line_begin + j]);
+            if (longest_.is_dead(st)) break;
+            if (longest_.is_match(st)) best = j + 1;
+        }
+        if (j == len && !longest_.is_dead(st)) {
+            st = longest_.step(st, RegexSymbol_LineEnd);
+            if (longest_.is_match(st)) best = len;
+        }
+
+        if (best != SIZE_MAX && best > s) {
+            positions_out.push_back(line_begin + s);
+            lengths_out.push_back((uint32_t)(best - s));
+            resume = best;
+        }
+    }
+}
+
+size_t RegexMatcher::find_all(const char* text, size_t text_len, size_t begin, size_t end,
+    std::vector<size_t>& positions_out, std::vector<uint32_t>& lengths_out)
+{
+    if (!valid()) return end;
+    if (end > text_len) end = text_len;
+
+    size_t pos = begin;
+    while (pos < end) {
+        const char* nl = static_cast<const char*>(memchr(text + pos, '\n', text_len - pos));
+        size_t next_line = nl ? (size_t)(nl - text) + 1 : text_len;
+        size_t line_end = nl ? (size_t)(nl - text) : text_len;
+        if (line_end > pos && text[line_end - 1] == '\r') line_end--;
+
+        int state = scan_.step(scan_.start_state(), RegexSymbol_LineStart);
+        bool found = scan_.is_match(state);
+        for (size_t i = pos; i < line_end && !found; ++i) {
+            state = scan_.step(state, (unsigned char)text[i]);
+            found = scan_.is_match(state);
+        }
+        if (!found) {
+            found = scan_.is_match(scan_.step(state, RegexSymbol_LineEnd));
+        }
+        if (found) {
+            match_line(text, pos, line_end, positions_out, lengths_out);
+        }
+        pos = next_line;
+    }
+    return pos;
+}
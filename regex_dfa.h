@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ByteSet {
+    uint64_t bits[4] = { 0, 0, 0, 0 };
+
+    void set(unsigned char c) { bits[c >> 6] |= (uint64_t)1 << (c & 63); }
+    bool test(unsigned char c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+    void set_range(unsigned char lo, unsigned char hi) { for (unsigned c = lo; c <= hi; ++c) set((unsigned char)c); }
+    void merge(const ByteSet& other) { for (int i = 0; i < 4; ++i) bits[i] |= other.bits[i]; }
+    void invert() { for (int i = 0; i < 4; ++i) bits[i] = ~bits[i]; }
+};
+
+enum RegexSymbol {
+    RegexSymbol_LineStart = 256,
+    RegexSymbol_LineEnd = 257,
+    RegexSymbol_Count = 258
+};
+
+struct RegexNfaState {
+    enum Kind : unsigned char { Bytes, Split, Assert, Match };
+    Kind kind = Match;
+    int symbol = 0;
+    int out = -1;
+    int out1 = -1;
+    ByteSet bytes;
+};
+
+struct RegexNfa {
+    std::vector<RegexNfaState> states;
+    int start = -1;
+};
+
+class LazyDfa {
+public:
+    void init(const RegexNfa* nfa, bool unanchored);
+    void reset_cache();
+
+    int start_state();
+    bool is_match(int state) const { return match_[state] != 0; }
+    bool is_dead(int state) const { return state == 0; }
+
+    int step(int state, int symbol) {
+        int next = transitions_[(size_t)state * RegexSymbol_Count + symbol];
+        return next >= 0 ? next : compute_step(state, symbol);
+    }
+
+private:
+    int compute_step(int state, int symbol);
+    int intern(std::vector<int>& nfa_set);
+    void add_closure(int nfa_state, std::vector<int>& out);
+
+    const RegexNfa* nfa_ = nullptr;
+    bool unanchored_ = false;
+    int start_ = -1;
+    std::vector<std::vector<int>> sets_;
+    std::vector<unsigned char> match_;
+    std::vector<int> transitions_;
+    std::unordered_map<std::string, int> index_;
+    std::vector<unsigned> visit_mark_;
+    unsigned visit_generation_ = 0;
+};
+
+class RegexMatcher {
+public:
+    RegexMatcher() = default;
+    RegexMatcher(const RegexMatcher&) = delete;
+    RegexMatcher& operator=(const RegexMatcher&) = delete;
+
+    bool compile(const std::string& pattern, bool case_sensitive, std::string& error_out);
+    bool valid() const { return forward_.start >= 0; }
+
+    size_t find_all(const char* text, size_t text_len, size_t begin, size_t end,
+        std::vector<size_t>& positions_out, std::vector<uint32_t>& lengths_out);
+
+private:
+    void match_line(const char* text, size_t line_begin, size_t line_end,
+        std::vector<size_t>& positions_out, std::vector<uint32_t>& lengths_out);
+
+    RegexNfa forward_;
+    RegexNfa reverse_;
+    LazyDfa scan_;
+    LazyDfa starts_;
+    LazyDfa longest_;
+    std::vector<unsigned char> start_marks_;
+};
@@ -0,0 +1,224 @@
+#include "search_kernel.h"
+#include <cstring>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CV_SEARCH_SSE2 1
+#include <emmintrin.h>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CV_SEARCH_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CV_TARGET_AVX2
+#else
+#define CV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+struct LiteralPattern {
+    const char* needle;
+    size_t len;
+    bool caseSensitive;
+    unsigned char firstLo, firstUp;
+    unsigned char lastLo, lastUp;
+};
+
+static unsigned char ascii_lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+static unsigned char ascii_upper(unsigned char c) {
+    return (c >= 'a' && c <= 'z') ? (unsigned char)(c - ('a' - 'A')) : c;
+}
+
+static LiteralPattern make_pattern(const char* needle, size_t len, bool case_sensitive) {
+    LiteralPattern p;
+    p.needle = needle;
+    p.len = len;
+    p.caseSensitive = case_sensitive;
+    unsigned char first = (unsigned char)needle[0];
+    unsigned char last = (unsigned char)needle[len - 1];
+    p.firstLo = case_sensitive ? first : ascii_lower(first);
+    p.firstUp = case_sensitive ? first : ascii_upper(first);
+    p.lastLo = case_sensitive ? last : ascii_lower(last);
+    p.lastUp = case_sensitive ? last : ascii_upper(last);
+    return p;
+}
+
+static bool verify_at(const char* text, const LiteralPattern& p) {
+    if (p.caseSensitive) {
+        return memcmp(text, p.needle, p.len) == 0;
+    }
+    for (size_t i = 0; i < p.len; ++i) {
+        if (ascii_lower((unsigned char)text[i]) != ascii_lower((unsigned char)p.needle[i])) return false;
+    }
+    return true;
+}
+
+static inline unsigned count_trailing_zeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+static size_t scan_scalar(const char* text, size_t text_len, size_t pos, size_t end, const LiteralPattern& p, std::vector<size_t>& out) {
+    size_t last_start = text_len - p.len;
+    if (end > last_start + 1) end = last_start + 1;
+    while (pos < end) {
+        unsigned char f = (unsigned char)text[pos];
+        if ((f == p.firstLo || f == p.firstUp) && verify_at(text + pos, p)) {
+            out.push_back(pos);
+            pos += p.len;
+        }
+        else {
+            pos++;
+        }
+    }
+    return pos;
+}
+
+#ifdef CV_SEARCH_SSE2
+static size_t scan_sse2(const char* text, size_t text_len, size_t pos, size_t end, const LiteralPattern& p, std::vector<size_t>& out) {
+    const __m128i first_lo = _mm_set1_epi8((char)p.firstLo);
+    const __m128i first_up = _mm_set1_epi8((char)p.firstUp);
+    const __m128i last_lo = _mm_set1_epi8((char)p.lastLo);
+    const __m128i last_up = _mm_set1_epi8((char)p.lastUp);
+    const size_t last_off = p.len - 1;
+
+    while (pos < end && pos + last_off + 16 <= text_len) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos + last_off));
+        __m128i eq_first = _mm_or_si128(_mm_cmpeq_epi8(block_first, first_lo), _mm_cmpeq_epi8(block_first, first_up));
+        __m128i eq_last = _mm_or_si128(_mm_cmpeq_epi8(block_last, last_lo), _mm_cmpeq_epi8(block_last, last_up));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last));
+
+        size_t next = pos + 16;
+        while (mask) {
+            size_t cand = pos + count_trailing_zeros(mask);
+            mask &= mask - 1;
+            if (cand >= end) break;
+            if (verify_at(text + cand, p)) {
+                out.push_back(cand);
+                size_t skip_to = cand + p.len;
+                if (skip_to >= pos + 16) {
+                    next = skip_to;
+                    break;
+                }
+                mask &= ~0u << (skip_to - pos);
+            }
+        }
+        pos = next;
+    }
+    return scan_scalar(text, text_len, pos, end, p, out);
+}
+
+#ifdef CV_SEARCH_AVX2
+CV_TARGET_AVX2
+static size_t scan_avx2(const char* text, size_t text_len, size_t pos, size_t end, const LiteralPattern& p, std::vector<size_t>& out) {
+    const __m256i first_lo = _mm256_set1_epi8((char)p.firstLo);
+    const __m256i first_up = _mm256_set1_epi8((char)p.firstUp);
+    const __m256i last_lo = _mm256_set1_epi8((char)p.lastLo);
+    const __m256i last_up = _mm256_set1_epi8((char)p.lastUp);
+    const size_t last_off = p.len - 1;
+
+    while (pos < end && pos + last_off + 32 <= text_len) {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos + last_off));
+        __m256i eq_first = _mm256_or_si256(_mm256_cmpeq_epi8(block_first, first_lo), _mm256_cmpeq_epi8(block_first, first_up));
+        __m256i eq_last = _mm256_or_si256(_mm256_cmpeq_epi8(block_last, last_lo), _mm256_cmpeq_epi8(block_last, last_up));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(eq_first, eq_last));
+
+        size_t next = pos + 32;
+        while (mask) {
+            size_t cand = pos + count_trailing_zeros(mask);
+            mask &= mask - 1;
+            if (cand >= end) break;
+            if (verify_at(text + cand, p)) {
+                out.push_back(cand);
+                size_t skip_to = cand + p.len;
+                if (skip_to >= pos + 32) {
+                    next = skip_to;
+                    break;
+                }
+                mask &= ~0u << (skip_to - pos);
+            }
+        }
+        pos = next;
+    }
+    return scan_sse2(text, text_len, pos, end, p, out);
+}
+#endif
+#endif
+
+static bool cpu_has_avx2() {
+#if defined(CV_SEARCH_AVX2)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+#else
+    return false;
+#endif
+}
+
+typedef size_t (*ScanFn)(const char*, size_t, size_t, size_t, const LiteralPattern&, std::vector<size_t>&);
+
+static ScanFn select_scan(const char** name_out) {
+#ifdef CV_SEARCH_SSE2
+#ifdef CV_SEARCH_AVX2
+    if (cpu_has_avx2()) {
+        *name_out = "avx2";
+        return scan_avx2;
+    }
+#endif
+    *name_out = "sse2";
+    return scan_sse2;
+#else
+    *name_out = "scalar";
+    return scan_scalar;
+#endif
+}
+
+static const char* s_kernel_name = "";
+
+static ScanFn get_scan() {
+    static const ScanFn scan = select_scan(&s_kernel_name);
+    return scan;
+}
+
+size_t search_literal(const char* text, size_t text_len, size_t begin, size_t end,
+    const char* needle, size_t needle_len, bool case_sensitive, std::vector<size_t>& matches_out)
+{
+    if (end > text_len) end = text_len;
+    if (needle_len == 0 || begin >= end || needle_len > text_len - begin) return end;
+
+    LiteralPattern pattern = make_pattern(needle, needle_len, case_sensitive);
+    size_t found_before = matches_out.size();
+    get_scan()(text, text_len, begin, end, pattern, matches_out);
+    if (matches_out.size() == found_before) return end;
+    size_t last_end = matches_out.back() + needle_len;
+    return last_end > end ? last_end : end;
+}
+
+const char* search_kernel_name() {
+    get_scan();
+    return s_kernel_name;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+size_t search_literal(const char* text, size_t text_len, size_t begin, size_t end,
+    const char* needle, size_t needle_len, bool case_sensitive, std::vector<size_t>& matches_out);
+
+const char* search_kernel_name();
@@ -0,0 +1,290 @@
+#include "soft_raster.h"
+#include "work_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CV_RASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+const int SUBPIXEL_BITS = 8;
+const int SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;
+const int FILTER_WEIGHT_STEPS = 256;
+const int MIN_BAND_ROWS = 16;
+
+struct RasterVertex {
+    int64_t x, y;
+    float u, v;
+    float col[4];
+};
+
+struct RasterTriangle {
+    RasterVertex v[3];
+    int64_t area;
+    bool flatColor;
+};
+
+static void unpack_color(uint32_t col, float out[4]) {
+    for (int c = 0; c < 4; ++c) {
+        out[c] = (float)((col >> (c * 8)) & 0xFF) * (1.0f / 255.0f);
+    }
+}
+
+static inline int wrap_coord(int i, int size) {
+    i %= size;
+    return i < 0 ? i + size : i;
+}
+
+static inline float quantize_weight(float f) {
+    return std::floor(f * FILTER_WEIGHT_STEPS + 0.5f) * (1.0f / FILTER_WEIGHT_STEPS);
+}
+
+#if CV_RASTER_SSE2
+
+static inline __m128 load_texel(const unsigned char* texels, int width, int x, int y) {
+    uint32_t packed;
+    memcpy(&packed, texels + ((size_t)y * width + x) * 4, 4);
+    __m128i zero = _mm_setzero_si128();
+    __m128i bytes = _mm_cvtsi32_si128((int)packed);
+    __m128i words = _mm_unpacklo_epi8(bytes, zero);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+}
+
+static inline void shade_pixel(unsigned char* dst, const SoftTexture& tex, float u, float v, const float col[4]) {
+    float tx = u * tex.width - 0.5f;
+    float ty = v * tex.height - 0.5f;
+    float fx0 = std::floor(tx);
+    float fy0 = std::floor(ty);
+    float fx = quantize_weight(tx - fx0);
+    float fy = quantize_weight(ty - fy0);
+    int x0 = wrap_coord((int)fx0, tex.width);
+    int y0 = wrap_coord((int)fy0, tex.height);
+    int x1 = x0 + 1 == tex.width ? 0 : x0 + 1;
+    int y1 = y0 + 1 == tex.height ? 0 : y0 + 1;
+
+    __m128 t00 = load_texel(tex.rgba, tex.width, x0, y0);
+    __m128 t10 = load_texel(tex.rgba, tex.width, x1, y0);
+    __m128 t01 = load_texel(tex.rgba, tex.width, x0, y1);
+    __m128 t11 = load_texel(tex.rgba, tex.width, x1, y1);
+    __m128 wx = _mm_set1_ps(fx);
+    __m128 wy = _mm_set1_ps(fy);
+    __m128 top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), wx));
+    __m128 bottom = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), wx));
+    __m128 texel = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy));
+
+    __m128 src = _mm_mul_ps(_mm_mul_ps(texel, _mm_loadu_ps(col)), _mm_set1_ps(1.0f / 255.0f));
+    __m128 src_alpha = _mm_shuffle_ps(src, src, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 src_factor = _mm_shuffle_ps(src_alpha, _mm_unpacklo_ps(src_alpha, one), _MM_SHUFFLE(1, 0, 1, 0));
+    __m128 inv_alpha = _mm_sub_ps(one, src_alpha);
+
+    __m128 dst_px = load_texel(dst, 1, 0, 0);
+    __m128 out = _mm_add_ps(_mm_mul_ps(src, src_factor), _mm_mul_ps(_mm_mul_ps(dst_px, _mm_set1_ps(1.0f / 255.0f)), inv_alpha));
+    __m128i ints = _mm_cvtps_epi32(_mm_mul_ps(out, _mm_set1_ps(255.0f)));
+    __m128i words = _mm_packs_epi32(ints, ints);
+    __m128i bytes = _mm_packus_epi16(words, words);
+    uint32_t packed = (uint32_t)_mm_cvtsi128_si32(bytes);
+    memcpy(dst, &packed, 4);
+}
+
+#else
+
+static inline void fetch_texel(const SoftTexture& tex, int x, int y, float out[4]) {
+    const unsigned char* p = tex.rgba + ((size_t)y * tex.width + x) * 4;
+    for (int c = 0; c < 4; ++c) out[c] = (float)p[c];
+}
+
+static inline void shade_pixel(unsigned char* dst, const SoftTexture& tex, float u, float v, const float col[4]) {
+    float tx = u * tex.width - 0.5f;
+    float ty = v * tex.height - 0.5f;
+    float fx0 = std::floor(tx);
+    float fy0 = std::floor(ty);
+    float fx = quantize_weight(tx - fx0);
+    float fy = quantize_weight(ty - fy0);
+    int x0 = wrap_coord((int)fx0, tex.width);
+    int y0 = wrap_coord((int)fy0, tex.height);
+    int x1 = x0 + 1 == tex.width ? 0 : x0 + 1;
+    int y1 = y0 + 1 == tex.height ? 0 : y0 + 1;
+
+    float t00[4], t10[4], t01[4], t11[4];
+    fetch_texel(tex, x0, y0, t00);
+    fetch_texel(tex, x1, y0, t10);
+    fetch_texel(tex, x0, y1, t01);
+    fetch_texel(tex, x1, y1, t11);
+
+    float src[4];
+    for (int c = 0; c < 4; ++c) {
+        float top = t00[c] + (t10[c] - t00[c]) * fx;
+        float bottom = t01[c] + (t11[c] - t01[c]) * fx;
+        src[c] = (top + (bottom - top) * fy) * col[c] * (1.0f / 255.0f);
+    }
+    float inv_alpha = 1.0f - src[3];
+    for (int c = 0; c < 4; ++c) {
+        float s = c < 3 ? src[c] * src[3] : src[3];
+        float out = s + (float)dst[c] * (1.0f / 255.0f) * inv_alpha;
+        dst[c] = (unsigned char)std::min(255.0f, std::max(0.0f, std::nearbyint(out * 255.0f)));
+    }
+}
+
+#endif
+
+const char* soft_raster_kernel_name() {
+#if CV_RASTER_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void soft_clear(SoftTarget& target, const float color[4]) {
+    unsigned char px[4];
+    for (int c = 0; c < 4; ++c) {
+        px[c] = (unsigned char)std::min(255.0f, std::max(0.0f, std::floor(color[c] * 255.0f + 0.5f)));
+    }
+    for (int y = 0; y < target.height; ++y) {
+        unsigned char* row = target.rgba + (size_t)y * target.stride;
+        for (int x = 0; x < target.width; ++x) {
+            memcpy(row + (size_t)x * 4, px, 4);
+        }
+    }
+}
+
+static inline int64_t edge_function(const RasterVertex& a, const RasterVertex& b, int64_t px, int64_t py) {
+    return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+}
+
+static inline bool is_top_left(const RasterVertex& a, const RasterVertex& b) {
+    int64_t dy = b.y - a.y;
+    int64_t dx = b.x - a.x;
+    return dy < 0 || (dy == 0 && dx > 0);
+}
+
+static bool setup_triangle(const SoftVertex& a, const SoftVertex& b, const SoftVertex& c, float origin_x, float origin_y, RasterTriangle& tri) {
+    const SoftVertex* src[3] = { &a, &b, &c };
+    for (int i = 0; i < 3; ++i) {
+        RasterVertex& v = tri.v[i];
+        v.x = (int64_t)std::llround((src[i]->x - origin_x) * SUBPIXEL_ONE);
+        v.y = (int64_t)std::llround((src[i]->y - origin_y) * SUBPIXEL_ONE);
+        v.u = src[i]->u;
+        v.v = src[i]->v;
+        unpack_color(src[i]->col, v.col);
+    }
+    tri.area = edge_function(tri.v[0], tri.v[1], tri.v[2].x, tri.v[2].y);
+    if (tri.area == 0) return false;
+    if (tri.area < 0) {
+        std::swap(tri.v[1], tri.v[2]);
+        tri.area = -tri.area;
+    }
+    tri.flatColor = a.col == b.col && b.col == c.col;
+    return true;
+}
+
+static void raster_triangle(const RasterTriangle& tri, const SoftTexture& tex, SoftTarget& target, int clip_x0, int clip_y0, int clip_x1, int clip_y1) {
+    const RasterVertex& v0 = tri.v[0];
+    const RasterVertex& v1 = tri.v[1];
+    const RasterVertex& v2 = tri.v[2];
+
+    int64_t min_x = std::min(v0.x, std::min(v1.x, v2.x));
+    int64_t max_x = std::max(v0.x, std::max(v1.x, v2.x));
+    int64_t min_y = std::min(v0.y, std::min(v1.y, v2.y));
+    int64_t max_y = std::max(v0.y, std::max(v1.y, v2.y));
+
+    int x0 = (int)std::max<int64_t>(clip_x0, (min_x - SUBPIXEL_ONE / 2) >> SUBPIXEL_BITS);
+    int x1 = (int)std::min<int64_t>(clip_x1, ((max_x - SUBPIXEL_ONE / 2) >> SUBPIXEL_BITS) + 1);
+    int y0 = (int)std::max<int64_t>(clip_y0, (min_y - SUBPIXEL_ONE / 2) >> SUBPIXEL_BITS);
+    int y1 = (int)std::min<int64_t>(clip_y1, ((max_y - SUBPIXEL_ONE / 2) >> SUBPIXEL_BITS) + 1);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    int64_t bias0 = is_top_left(v1, v2) ? 0 : -1;
+    int64_t bias1 = is_top_left(v2, v0) ? 0 : -1;
+    int64_t bias2 = is_top_left(v0, v1) ? 0 : -1;
+
+    int64_t step_x0 = -(v2.y - v1.y) * SUBPIXEL_ONE;
+    int64_t step_x1 = -(v0.y - v2.y) * SUBPIXEL_ONE;
+    int64_t step_x2 = -(v1.y - v0.y) * SUBPIXEL_ONE;
+
+    float inv_area = 1.0f / (float)tri.area;
+    float col[4];
+    memcpy(col, v0.col, sizeof(col));
+
+    for (int py = y0; py < y1; ++py) {
+        int64_t cy = (int64_t)py * SUBPIXEL_ONE + SUBPIXEL_ONE / 2;
+        int64_t cx = (int64_t)x0 * SUBPIXEL_ONE + SUBPIXEL_ONE / 2;
+        int64_t w0 = edge_function(v1, v2, cx, cy);
+        int64_t w1 = edge_function(v2, v0, cx, cy);
+        int64_t w2 = edge_function(v0, v1, cx, cy);
+        unsigned char* row = target.rgba + (size_t)py * target.stride;
+
+        for (int px = x0; px < x1; ++px, w0 += step_x0, w1 += step_x1, w2 += step_x2) {
+            if (w0 + bias0 < 0 || w1 + bias1 < 0 || w2 + bias2 < 0) continue;
+
+            float b0 = (float)w0 * inv_area;
+            float b1 = (float)w1 * inv_area;
+            float b2 = 1.0f - b0 - b1;
+            float u = v0.u * b0 + v1.u * b1 + v2.u * b2;
+            float v = v0.v * b0 + v1.v * b1 + v2.v * b2;
+            if (!tri.flatColor) {
+                for (int c = 0; c < 4; ++c) {
+                    col[c] = v0.col[c] * b0 + v1.col[c] * b1 + v2.col[c] * b2;
+                }
+            }
+            shade_pixel(row + (size_t)px * 4, tex, u, v, col);
+        }
+    }
+}
+
+static uint32_t read_index(const SoftDrawList& list, size_t i) {
+    if (list.indexSize == 4) return static_cast<const uint32_t*>(list.indices)[i];
+    return static_cast<const uint16_t*>(list.indices)[i];
+}
+
+static void raster_band(const SoftDrawList& list, SoftTarget& target, float origin_x, float origin_y, int band_y0, int band_y1) {
+    RasterTriangle tri;
+    for (const SoftDrawCmd& cmd : list.commands) {
+        if (!cmd.texture || !cmd.texture->rgba) continue;
+
+        int clip_x0 = std::max(0, (int)(cmd.clipMinX - origin_x));
+        int clip_y0 = std::max(band_y0, (int)(cmd.clipMinY - origin_y));
+        int clip_x1 = std::min(target.width, (int)(cmd.clipMaxX - origin_x));
+        int clip_y1 = std::min(band_y1, (int)(cmd.clipMaxY - origin_y));
+        if (clip_x0 >= clip_x1 || clip_y0 >= clip_y1) continue;
+
+        float band_top = (float)clip_y0 + origin_y;
+        float band_bottom = (float)clip_y1 + origin_y;
+        for (uint32_t e = 0; e + 2 < cmd.elemCount; e += 3) {
+            size_t base = (size_t)cmd.idxOffset + e;
+            const SoftVertex& a = list.vertices[cmd.vtxOffset + read_index(list, base)];
+            const SoftVertex& b = list.vertices[cmd.vtxOffset + read_index(list, base + 1)];
+            const SoftVertex& c = list.vertices[cmd.vtxOffset + read_index(list, base + 2)];
+            if (std::max(a.y, std::max(b.y, c.y)) < band_top || std::min(a.y, std::min(b.y, c.y)) > band_bottom) continue;
+
+            if (setup_triangle(a, b, c, origin_x, origin_y, tri)) {
+                raster_triangle(tri, *cmd.texture, target, clip_x0, clip_y0, clip_x1, clip_y1);
+            }
+        }
+    }
+}
+
+void soft_rasterize(const SoftDrawList& list, SoftTarget& target, float origin_x, float origin_y, int thread_count) {
+    if (!target.rgba || target.width <= 0 || target.height <= 0) return;
+
+    if (thread_count <= 0) {
+        thread_count = (int)std::thread::hardware_concurrency();
+    }
+    int band_rows = std::max(MIN_BAND_ROWS, (target.height + thread_count * 4 - 1) / (thread_count * 4));
+    if (thread_count <= 1 || band_rows >= target.height) {
+        raster_band(list, target, origin_x, origin_y, 0, target.height);
+        return;
+    }
+
+    WorkStealingPool pool(thread_count);
+    for (int y = 0; y < target.height; y += band_rows) {
+        int band_end = std::min(target.height, y + band_rows);
+        pool.submit([&list, &target, origin_x, origin_y, y, band_end](int) {
+            raster_band(list, target, origin_x, origin_y, y, band_end);
+        });
+    }
+    pool.wait_idle();
+}
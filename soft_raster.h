@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SoftVertex {
+    float x, y;
+    float u, v;
+    uint32_t col;
+};
+
+struct SoftTexture {
+    const unsigned char* rgba = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+struct SoftDrawCmd {
+    float clipMinX = 0.0f, clipMinY = 0.0f, clipMaxX = 0.0f, clipMaxY = 0.0f;
+    const SoftTexture* texture = nullptr;
+    uint32_t vtxOffset = 0;
+    uint32_t idxOffset = 0;
+    uint32_t elemCount = 0;
+};
+
+struct SoftDrawList {
+    const SoftVertex* vertices = nullptr;
+    size_t vertexCount = 0;
+    const void* indices = nullptr;
+    size_t indexCount = 0;
+    int indexSize = 2;
+    std::vector<SoftDrawCmd> commands;
+};
+
+struct SoftTarget {
+    unsigned char* rgba = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t stride = 0;
+};
+
+void soft_clear(SoftTarget& target, const float color[4]);
+void soft_rasterize(const SoftDrawList& list, SoftTarget& target, float origin_x, float origin_y, int thread_count = 0);
+
+const char* soft_raster_kernel_name();
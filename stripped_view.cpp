@@ -0,0 +1,226 @@
+#include "stripped_view.h"
+#include "language_registry.h"
+#include <algorithm>
+#include <cstring>
+
+static bool is_trailing_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+struct CommentOpener {
+    std::string_view text;
+    int block;
+};
+
+// Comment openers of one language, longest first, with the set of bytes
+// they can start with. Most languages have a single such byte ('/', '#',
+// '<'), which is searched with memchr.
+struct CommentOpeners {
+    std::vector<CommentOpener> openers;
+    bool starts[256] = {};
+    int single = -1;
+
+    explicit CommentOpeners(const CommentSyntax& syntax) {
+        for (const std::string& open : syntax.lineComments) openers.push_back({ open, -1 });
+        for (size_t i = 0; i < syntax.blockComments.size(); ++i) openers.push_back({ syntax.blockComments[i].first, (int)i });
+        std::stable_sort(openers.begin(), openers.end(), [](const CommentOpener& a, const CommentOpener& b) {
+            return a.text.size() > b.text.size();
+        });
+        int distinct = 0;
+        for (const CommentOpener& opener : openers) {
+            unsigned char first = (unsigned char)opener.text[0];
+            if (!starts[first]) distinct++;
+            starts[first] = true;
+            single = first;
+        }
+        if (distinct != 1) single = -1;
+    }
+};
+
+static const char* find_delimiter(const char* p, const char* end, std::string_view delimiter) {
+    while (p + delimiter.size() <= end) {
+        const char* hit = static_cast<const char*>(memchr(p, delimiter[0], end - p - delimiter.size() + 1));
+        if (!hit) return nullptr;
+        if (delimiter.size() == 1 || (hit[1] == delimiter[1] && memcmp(hit + 2, delimiter.data() + 2, delimiter.size() - 2) == 0)) return hit;
+        p = hit + 1;
+    }
+    return nullptr;
+}
+
+static const char* find_comment_start(const char* p, const char* end, const CommentOpeners& openers, int& which_out) {
+    while (p < end) {
+        const char* hit = nullptr;
+        if (openers.single >= 0) {
+            hit = static_cast<const char*>(memchr(p, openers.single, end - p));
+        }
+        else {
+            while (p < end && !openers.starts[(unsigned char)*p]) p++;
+            if (p < end) hit = p;
+        }
+        if (!hit) return nullptr;
+        for (size_t i = 0; i < openers.openers.size(); ++i) {
+            std::string_view open = openers.openers[i].text;
+            if (open.size() <= (size_t)(end - hit) && memcmp(hit, open.data(), open.size()) == 0) {
+                which_out = (int)i;
+                return hit;
+            }
+        }
+        p = hit + 1;
+    }
+    return nullptr;
+}
+
+void OffsetArray::push_back(size_t value) {
+    if (wide_) wideValues_.push_back(value);
+    else narrowValues_.push_back((uint32_t)value);
+}
+
+void OffsetArray::shrink_to_fit() {
+    narrowValues_.shrink_to_fit();
+    wideValues_.shrink_to_fit();
+}
+
+size_t OffsetArray::lower_bound(size_t value, size_t count) const {
+    if (wide_) return (size_t)(std::lower_bound(wideValues_.begin(), wideValues_.begin() + count, (uint64_t)value) - wideValues_.begin());
+    if (value > UINT32_MAX) return count;
+    return (size_t)(std::lower_bound(narrowValues_.begin(), narrowValues_.begin() + count, (uint32_t)value) - narrowValues_.begin());
+}
+
+size_t OffsetArray::upper_bound(size_t value, size_t count) const {
+    if (wide_) return (size_t)(std::upper_bound(wideValues_.begin(), wideValues_.begin() + count, (uint64_t)value) - wideValues_.begin());
+    if (value >= UINT32_MAX) return count;
+    return (size_t)(std::upper_bound(narrowValues_.begin(), narrowValues_.begin() + count, (uint32_t)value) - narrowValues_.begin());
+}
+
+size_t OffsetArray::memory_bytes() const {
+    return narrowValues_.capacity() * sizeof(uint32_t) + wideValues_.capacity() * sizeof(uint64_t);
+}
+
+// The stripped text is never longer than the source plus one newline, so
+// 32-bit offsets cover both whenever the source is below 4 GB.
+StrippedView::StrippedView(std::string_view text, int lang, TextBufferPtr keep_alive)
+    : text_(text),
+    keepAlive_(std::move(keep_alive))
+{
+    bool wide = text.size() >= UINT32_MAX;
+    lineOffsets_.set_wide(wide);
+    lineSource_.set_wide(wide);
+    lineOffsets_.push_back(0);
+    splitFirstSpan_.push_back(0);
+    scan(lang);
+    lineOffsets_.shrink_to_fit();
+    lineSource_.shrink_to_fit();
+}
+
+// Single pass over the source with memchr-driven comment searches, using
+// the comment delimiters of the language's definition. Like the old
+// copying stripper it does not look inside strings. Kept segments of a line
+// are trimmed of trailing whitespace as a whole and blank lines are dropped,
+// matching that stripper byte for byte.
+void StrippedView::scan(int lang) {
+    const CommentSyntax& syntax = languages().tables(lang).comments();
+    CommentOpeners openers(syntax);
+    int open_block = -1;
+
+    const char* base = text_.data();
+    const char* p = base;
+    const char* end = p + text_.size();
+    std::vector<TextSpan> segments;
+    auto keep = [&](const char* from, const char* to) {
+        if (to > from) segments.push_back({ (size_t)(from - base), (size_t)(to - from) });
+    };
+
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* line_end = nl ? nl : end;
+        segments.clear();
+
+        const char* q = p;
+        while (q < line_end) {
+            if (open_block >= 0) {
+                std::string_view close = syntax.blockComments[open_block].second;
+                const char* found = find_delimiter(q, line_end, close);
+                if (!found) break;
+                q = found + close.size();
+                open_block = -1;
+                continue;
+            }
+            int which = -1;
+            const char* open = openers.openers.empty() ? nullptr : find_comment_start(q, line_end, openers, which);
+            if (!open) {
+                keep(q, line_end);
+                break;
+            }
+            keep(q, open);
+            const CommentOpener& opener = openers.openers[which];
+            if (opener.block < 0) break;
+            std::string_view close = syntax.blockComments[opener.block].second;
+            const char* found = find_delimiter(open + opener.text.size(), line_end, close);
+            if (!found) {
+                open_block = opener.block;
+                break;
+            }
+            q = found + close.size();
+        }
+
+        while (!segments.empty()) {
+            TextSpan& last = segments.back();
+            while (last.length > 0 && is_trailing_space(base[last.offset + last.length - 1])) last.length--;
+            if (last.length > 0) break;
+            segments.pop_back();
+        }
+        if (!segments.empty()) emit_line(segments);
+
+        p = nl ? nl + 1 : end;
+    }
+}
+
+void StrippedView::emit_line(const std::vector<TextSpan>& segments) {
+    size_t length = 0;
+    for (const TextSpan& segment : segments) length += segment.length;
+    if (segments.size() > 1) {
+        splitLines_.push_back((uint32_t)lineSource_.size());
+        spans_.insert(spans_.end(), segments.begin(), segments.end());
+        splitFirstSpan_.push_back((uint32_t)spans_.size());
+    }
+    lineSource_.push_back(segments[0].offset);
+    lineOffsets_.push_back(lineOffsets_.back() + length + 1);
+}
+
+size_t StrippedView::line_from_offset(size_t offset) const {
+    size_t next = lineOffsets_.upper_bound(offset, lineOffsets_.size() - 1);
+    return next == 0 ? 0 : next - 1;
+}
+
+size_t StrippedView::line_from_source(size_t source_offset) const {
+    return lineSource_.lower_bound(source_offset, lineSource_.size());
+}
+
+std::string_view StrippedView::line(size_t line, std::string& scratch) const {
+    if (line >= line_count()) return std::string_view();
+    auto split = std::lower_bound(splitLines_.begin(), splitLines_.end(), (uint32_t)line);
+    if (split == splitLines_.end() || *split != line) {
+        return text_.substr(lineSource_[line], line_length(line));
+    }
+    size_t k = (size_t)(split - splitLines_.begin());
+    scratch.clear();
+    for (uint32_t s = splitFirstSpan_[k]; s < splitFirstSpan_[k + 1]; ++s) {
+        scratch.append(text_.data() + spans_[s].offset, spans_[s].length);
+    }
+    return scratch;
+}
+
+void StrippedView::copy(std::string& out) const {
+    out.clear();
+    out.reserve(size());
+    std::string scratch;
+    for (size_t i = 0; i < line_count(); ++i) {
+        out.append(line(i, scratch));
+        out += '\n';
+    }
+}
+
+size_t StrippedView::memory_bytes() const {
+    return lineOffsets_.memory_bytes() + lineSource_.memory_bytes() +
+        (splitLines_.capacity() + splitFirstSpan_.capacity()) * sizeof(uint32_t) + spans_.capacity() * sizeof(TextSpan);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "text_buffer.h"
+
+struct TextSpan {
+    size_t offset;
+    size_t length;
+};
+
+// Ascending offsets stored as 32-bit values, switching to 64-bit only for
+// texts of 4 GB or more.
+class OffsetArray {
+public:
+    void set_wide(bool wide) { wide_ = wide; }
+    size_t size() const { return wide_ ? wideValues_.size() : narrowValues_.size(); }
+    size_t operator[](size_t i) const { return wide_ ? (size_t)wideValues_[i] : narrowValues_[i]; }
+    size_t back() const { return (*this)[size() - 1]; }
+    void push_back(size_t value);
+    void shrink_to_fit();
+    size_t lower_bound(size_t value, size_t count) const;
+    size_t upper_bound(size_t value, size_t count) const;
+    size_t memory_bytes() const;
+
+private:
+    bool wide_ = false;
+    std::vector<uint32_t> narrowValues_;
+    std::vector<uint64_t> wideValues_;
+};
+
+// Comment-stripped text kept as byte ranges over the original text instead
+// of a copy. A kept line is normally one range starting at lineSource; only
+// lines with a comment cut out of their middle list their ranges in spans_.
+// Newlines are implied: the virtual text is every kept line plus '\n'.
+class StrippedView {
+public:
+    StrippedView(std::string_view text, int lang, TextBufferPtr keep_alive = nullptr);
+
+    size_t line_count() const { return lineSource_.size(); }
+    size_t size() const { return lineOffsets_.back(); }
+    size_t line_offset(size_t line) const { return lineOffsets_[line]; }
+    size_t line_length(size_t line) const { return lineOffsets_[line + 1] - lineOffsets_[line] - 1; }
+    size_t source_offset(size_t line) const { return lineSource_[line]; }
+
+    size_t line_from_offset(size_t offset) const;
+    size_t line_from_source(size_t source_offset) const;
+    std::string_view line(size_t line, std::string& scratch) const;
+    void copy(std::string& out) const;
+    size_t memory_bytes() const;
+
+private:
+    void scan(int lang);
+    void emit_line(const std::vector<TextSpan>& segments);
+
+    std::string_view text_;
+    TextBufferPtr keepAlive_;
+    OffsetArray lineOffsets_;
+    OffsetArray lineSource_;
+    std::vector<uint32_t> splitLines_;
+    std::vector<uint32_t> splitFirstSpan_;
+    std::vector<TextSpan> spans_;
+};
+
+typedef std::shared_ptr<const StrippedView> StrippedViewPtr;
@@ -0,0 +1,216 @@
+#include "svg_export.h"
+#include "code_document.h"
+#include "code_layout.h"
+#include "file_utils.h"
+#include "glyph_advance.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+const size_t SVG_FLUSH_BYTES = 1 << 16;
+
+static const char* const s_class_names[Token_Count] = { nullptr, "k", "c", "s", "n", "p", "t", "a", "e", "r" };
+
+struct SvgWriter {
+    FILE* file = nullptr;
+    std::string buffer;
+    bool failed = false;
+
+    void flush() {
+        if (!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            failed = true;
+        }
+        buffer.clear();
+    }
+    void maybe_flush() {
+        if (buffer.size() >= SVG_FLUSH_BYTES) flush();
+    }
+    void append(const char* text) { buffer += text; }
+    void append(const char* text, size_t len) { buffer.append(text, len); }
+
+    // Coordinates are written with one decimal, dropping a trailing ".0".
+    void append_number(float value) {
+        char tmp[32];
+        int len = snprintf(tmp, sizeof(tmp), "%.1f", value);
+        if (len >= 2 && tmp[len - 2] == '.' && tmp[len - 1] == '0') len -= 2;
+        buffer.append(tmp, (size_t)std::max(0, len));
+    }
+
+    void append_color(uint32_t col) {
+        char tmp[16];
+        snprintf(tmp, sizeof(tmp), "#%02x%02x%02x", col & 0xFF, (col >> 8) & 0xFF, (col >> 16) & 0xFF);
+        buffer += tmp;
+    }
+
+    // Escapes XML metacharacters, expands tabs to the font's tab width, drops
+    // carriage returns and control characters XML 1.0 cannot carry, and
+    // replaces malformed UTF-8 with U+FFFD so the document always parses.
+    void append_text(const char* begin, const char* end, int tab_spaces) {
+        const char* p = begin;
+        while (p < end) {
+            unsigned char c = (unsigned char)*p;
+            if (c >= 0x80) {
+                unsigned int codepoint;
+                const char* next = utf8_decode(p, end, codepoint);
+                char utf8[4];
+                buffer.append(utf8, (size_t)utf8_encode(codepoint, utf8));
+                p = next;
+                continue;
+            }
+            switch (c) {
+            case '&': buffer += "&amp;"; break;
+            case '<': buffer += "&lt;"; break;
+            case '>': buffer += "&gt;"; break;
+            case '\t': buffer.append((size_t)tab_spaces, ' '); break;
+            default:
+                if (c >= 0x20) buffer += (char)c;
+                break;
+            }
+            ++p;
+        }
+    }
+};
+
+static bool is_blank(const char* begin, const char* end) {
+    for (const char* p = begin; p < end; ++p) {
+        if (*p != ' ' && *p != '\t' && *p != '\r') return false;
+    }
+    return true;
+}
+
+bool write_code_svg(const char* path, const CodeDocument& doc, const SvgExportStyle& style,
+    const GlyphAdvanceTable& advances, std::string& error_out)
+{
+    if (!advances.valid()) {
+        error_out = "Glyph advances are not available.";
+        return false;
+    }
+    int line_count = document_line_count(doc);
+    if ((int)doc.lineFirstRun.size() < line_count + 1) {
+        error_out = "Document has not been lexed.";
+        return false;
+    }
+
+    int last_line_number = max_line_number(doc);
+    char line_no_fmt[24];
+    int max_digits = (int)log10(last_line_number) + 1;
+    snprintf(line_no_fmt, sizeof(line_no_fmt), "%%-%dd | ", max_digits);
+    char max_line_no_str[16];
+    snprintf(max_line_no_str, sizeof(max_line_no_str), "%d | ", last_line_number);
+    float line_num_width = advances.measure(max_line_no_str, max_line_no_str + strlen(max_line_no_str));
+
+    int width = 0;
+    int height = 0;
+    calculate_image_size(doc, advances, style.lineHeight, width, height, (int)line_num_width);
+    width += (int)(style.padding * 2.0f);
+    height += (int)(style.padding * 2.0f);
+
+    float space_advance = advances.measure(" ", " " + 1);
+    int tab_spaces = space_advance > 0.0f ? std::max(1, (int)std::lround(advances.tab_advance() / space_advance)) : 4;
+
+    SvgWriter out;
+    out.file = fopen(path, "wb");
+    if (!out.file) {
+        error_out = std::string("Cannot open ") + path + " for writing.";
+        return false;
+    }
+    out.buffer.reserve(SVG_FLUSH_BYTES + 4096);
+
+    out.append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" xml:space=\"preserve\" width=\"");
+    out.append_number((float)width);
+    out.append("\" height=\"");
+    out.append_number((float)height);
+    out.append("\" viewBox=\"0 0 ");
+    out.append_number((float)width);
+    out.append(" ");
+    out.append_number((float)height);
+    out.append("\">\n<style>text{font-family:");
+    out.append(style.fontFamily.c_str());
+    out.append(";font-size:");
+    out.append_number(style.fontSize);
+    out.append("px;white-space:pre;fill:");
+    out.append_color(style.classColors[Token_Default]);
+    out.append("}.l{fill:");
+    out.append_color(style.lineNumberColor);
+    out.append("}");
+    for (int c = 0; c < Token_Count; ++c) {
+        if (!s_class_names[c]) continue;
+        out.append(".");
+        out.append(s_class_names[c]);
+        out.append("{fill:");
+        out.append_color(style.classColors[c]);
+        out.append("}");
+    }
+    out.append("</style>\n<rect width=\"100%\" height=\"100%\" fill=\"");
+    out.append_color(style.background);
+    out.append("\"/>\n");
+
+    float code_x = style.padding + line_num_width;
+    std::string line_scratch;
+    for (int line_idx = 0; line_idx < line_count; ++line_idx) {
+        std::string_view line = line_text(doc, line_idx, line_scratch);
+        const char* line_begin = line.data();
+        const char* line_end = line_begin + line.size();
+
+        out.append("<text x=\"");
+        out.append_number(style.padding);
+        out.append("\" y=\"");
+        out.append_number(style.padding + line_idx * style.lineHeight + style.ascent);
+        out.append("\"><tspan class=\"l\">");
+        char line_num_str[16];
+        snprintf(line_num_str, sizeof(line_num_str), line_no_fmt, original_line(doc, line_idx) + 1);
+        out.append(line_num_str);
+        out.append("</tspan>");
+
+        // Adjacent runs of one class share a span, and whitespace takes the
+        // class of the token that follows it since its color never shows.
+        int open_class = -1;
+        const char* pending_blank = nullptr;
+        for (uint32_t r = doc.lineFirstRun[line_idx]; r < doc.lineFirstRun[line_idx + 1]; ++r) {
+            const TokenRun& run = doc.tokenRuns[r];
+            const char* run_begin = line_begin + run.offset;
+            const char* run_end = std::min(run_begin + run.length, line_end);
+            if (run_begin >= run_end) continue;
+            if (is_blank(run_begin, run_end)) {
+                if (!pending_blank) pending_blank = run_begin;
+                continue;
+            }
+
+            int cls = run.cls < Token_Count ? (int)run.cls : (int)Token_Default;
+            if (cls != open_class) {
+                if (open_class >= 0) out.append("</tspan>");
+                out.append("<tspan");
+                if (open_class < 0) {
+                    out.append(" x=\"");
+                    out.append_number(code_x);
+                    out.append("\"");
+                }
+                if (s_class_names[cls]) {
+                    out.append(" class=\"");
+                    out.append(s_class_names[cls]);
+                    out.append("\"");
+                }
+                out.append(">");
+                open_class = cls;
+            }
+            if (pending_blank) {
+                out.append_text(pending_blank, run_begin, tab_spaces);
+                pending_blank = nullptr;
+            }
+            out.append_text(run_begin, run_end, tab_spaces);
+        }
+        if (open_class >= 0) out.append("</tspan>");
+        out.append("</text>\n");
+        out.maybe_flush();
+    }
+
+    out.append("</svg>\n");
+    out.flush();
+    bool closed = fclose(out.file) == 0;
+    if (out.failed || !closed) {
+        error_out = std::string("Failed to write ") + path + ".";
+        return false;
+    }
+    return true;
+}
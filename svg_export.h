@@ -0,0 +1,23 @@
+#pragma once
+
+#include "code_lexer.h"
+#include <cstdint>
+#include <string>
+
+struct CodeDocument;
+class GlyphAdvanceTable;
+
+// Colors are packed like ImU32: red in the low byte, alpha in the high byte.
+struct SvgExportStyle {
+    std::string fontFamily = "'Fira Code', Consolas, monospace";
+    float fontSize = 14.0f;
+    float ascent = 11.0f;
+    float lineHeight = 18.0f;
+    float padding = 10.0f;
+    uint32_t background = 0xFF211F1C;
+    uint32_t lineNumberColor = 0xFF808080;
+    uint32_t classColors[Token_Count] = {};
+};
+
+bool write_code_svg(const char* path, const CodeDocument& doc, const SvgExportStyle& style,
+    const GlyphAdvanceTable& advances, std::string& error_out);
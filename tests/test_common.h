@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdio>
+
+// Each suite runs its checks and returns; a failed CHECK prints where it was
+// and marks the run failed, so one ctest case reports every broken check.
+extern int g_test_failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_test_failures++; \
+        } \
+    } while (0)
+
+void test_text_buffer();
+void test_line_index();
+void test_edit();
+void test_reload();
+void test_lexer();
+void test_strip();
+void test_search();
+void test_scheduler();
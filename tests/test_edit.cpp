@@ -0,0 +1,64 @@
+#include "test_common.h"
+#include "code_document.h"
+#include "document_edit.h"
+#include "file_utils.h"
+#include "piece_table.h"
+#include <algorithm>
+#include <random>
+#include <string>
+
+static size_t reference_line_count(const std::string& text) {
+    size_t newlines = (size_t)std::count(text.begin(), text.end(), '\n');
+    if (!text.empty() && text.back() == '\n') newlines--;
+    return newlines + 1;
+}
+
+static std::string_view reference_line(const std::string& text, size_t line) {
+    size_t start = 0;
+    for (size_t i = 0; i < line; ++i) start = text.find('\n', start) + 1;
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos) end = text.size();
+    return std::string_view(text).substr(start, end - start);
+}
+
+// Applies the same random edits to a document and a flat string and checks
+// text, line count and line contents after every batch.
+void test_edit() {
+    std::string reference;
+    for (int i = 0; i < 2000; ++i) {
+        reference += "int value" + std::to_string(i) + " = compute(" + std::to_string(i * 7) + "); // line\n";
+        if (i % 50 == 0) reference += "/* block\n   comment */\n\n";
+    }
+    CodeDocument doc("parity.cpp", "parity.cpp", make_text_buffer(reference));
+    doc.language = detect_lang(doc.fileName);
+    process_code(doc);
+
+    std::mt19937 rng(5);
+    const char* snippets[] = { "x", "\n", "int y = 0;\n", "/* a\nb */", "\n\n", "tail" };
+    std::string scratch;
+    for (int batch = 0; batch < 20; ++batch) {
+        for (int op = 0; op < 100; ++op) {
+            size_t offset = reference.empty() ? 0 : rng() % (reference.size() + 1);
+            if (rng() % 3 == 0) {
+                size_t length = rng() % 64;
+                erase_text(doc, offset, length);
+                if (offset < reference.size()) reference.erase(offset, length);
+            }
+            else {
+                const char* snippet = snippets[rng() % 6];
+                insert_text(doc, offset, snippet);
+                reference.insert(offset, snippet);
+            }
+        }
+        CHECK(document_text(doc)->view() == reference);
+        CHECK((size_t)document_line_count(doc) == reference_line_count(reference));
+        for (int probe = 0; probe < 20; ++probe) {
+            int line = (int)(rng() % reference_line_count(reference));
+            CHECK(line_text(doc, line, scratch) == reference_line(reference, line));
+        }
+    }
+
+    process_code(doc);
+    CHECK(!doc.pieces);
+    CHECK(doc.content == reference);
+}
@@ -0,0 +1,102 @@
+#include "test_common.h"
+#include "code_document.h"
+#include "code_lexer.h"
+#include "file_utils.h"
+#include "language_definition.h"
+#include "language_registry.h"
+#include "lexer_tables.h"
+#include <cstring>
+#include <vector>
+
+static unsigned char class_at(const std::vector<TokenRun>& runs, size_t offset) {
+    for (const TokenRun& run : runs) {
+        if (offset >= run.offset && offset < (size_t)run.offset + run.length) return run.cls;
+    }
+    return Token_Default;
+}
+
+static unsigned char lex(const char* line, int lang, unsigned char state, std::vector<TokenRun>& runs) {
+    runs.clear();
+    return lex_line(line, strlen(line), lang, state, runs);
+}
+
+void test_lexer() {
+    CHECK(languages().errors().empty());
+    int cpp = languages().find_by_id("cpp");
+    int python = languages().find_by_id("python");
+    int html = languages().find_by_id("html");
+    CHECK(cpp >= 0 && python >= 0 && html >= 0);
+    CHECK(languages().find_by_file_name("main.CPP") == cpp);
+    CHECK(languages().find_by_file_name("README") == -1);
+
+    std::vector<TokenRun> runs;
+    CHECK(lex("int x = 42; // \"not a string\"", cpp, LexState_Normal, runs) == LexState_Normal);
+    CHECK(class_at(runs, 0) == Token_Keyword);
+    CHECK(class_at(runs, 4) == Token_Default);
+    CHECK(class_at(runs, 8) == Token_Number);
+    CHECK(class_at(runs, 12) == Token_Comment);
+    CHECK(class_at(runs, 16) == Token_Comment);
+
+    CHECK(lex("const char* s = \"a // b\\\" c\";", cpp, LexState_Normal, runs) == LexState_Normal);
+    CHECK(class_at(runs, 16) == Token_String);
+    CHECK(class_at(runs, 19) == Token_String);
+    CHECK(class_at(runs, 25) == Token_String);
+    CHECK(class_at(runs, 28) == Token_Default);
+
+    CHECK(lex("#include <vector>", cpp, LexState_Normal, runs) == LexState_Normal);
+    CHECK(class_at(runs, 0) == Token_Preprocessor);
+
+    // A block comment carries its state across lines and ends mid-line.
+    unsigned char state = lex("x = 1; /* open", cpp, LexState_Normal, runs);
+    CHECK(state != LexState_Normal);
+    CHECK(class_at(runs, 7) == Token_Comment);
+    CHECK(lex("still comment", cpp, state, runs) == state);
+    CHECK(class_at(runs, 0) == Token_Comment);
+    CHECK(lex("end */ return 0;", cpp, state, runs) == LexState_Normal);
+    CHECK(class_at(runs, 4) == Token_Comment);
+    CHECK(class_at(runs, 7) == Token_Keyword);
+
+    CHECK(lex("def f(): # note", python, LexState_Normal, runs) == LexState_Normal);
+    CHECK(class_at(runs, 0) == Token_Keyword);
+    CHECK(class_at(runs, 9) == Token_Comment);
+
+    // Embedded script switches to the JavaScript states until </script>.
+    state = lex("<script>var a = 1;", html, LexState_Normal, runs);
+    CHECK(state != LexState_Normal);
+    CHECK(class_at(runs, 1) == Token_Tag);
+    CHECK(class_at(runs, 8) == Token_Keyword);
+    CHECK(lex("</script><p class=\"x\">", html, state, runs) == LexState_Normal);
+    CHECK(class_at(runs, 2) == Token_Tag);
+    CHECK(class_at(runs, 12) == Token_Attribute);
+
+    // Unknown languages lex as plain text.
+    CHECK(lex("int x; // y", -1, LexState_Normal, runs) == LexState_Normal);
+    CHECK(class_at(runs, 0) == Token_Default);
+    CHECK(class_at(runs, 8) == Token_Default);
+
+    // lex_document fills per-line runs that match lexing line by line.
+    CodeDocument doc("t.cpp", "t.cpp", make_text_buffer("/* a\nb */ int c;\n"));
+    doc.language = cpp;
+    process_code(doc);
+    lex_document(doc);
+    CHECK(doc.lineFirstRun.size() == 3);
+    bool found_keyword = false;
+    for (uint32_t r = doc.lineFirstRun[1]; r < doc.lineFirstRun[2]; ++r) {
+        if (doc.tokenRuns[r].cls == Token_Keyword) found_keyword = doc.tokenRuns[r].offset == 5;
+    }
+    CHECK(found_keyword);
+
+    // A cache file is untrusted input: one whose comment delimiters are
+    // empty must be rejected rather than handed to the comment stripper.
+    LexerTables tables;
+    std::string error;
+    CHECK(LexerTables::compile(LanguageDefinition(), nullptr, tables, error));
+    std::string cache;
+    tables.serialize(42, cache);
+    LexerTables reloaded;
+    CHECK(reloaded.deserialize(cache, 42));
+    CHECK(!reloaded.deserialize(cache, 43));
+    const char empty_opener[] = { 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    std::string corrupt = cache.substr(0, cache.size() - 8) + std::string(empty_opener, sizeof(empty_opener));
+    CHECK(!reloaded.deserialize(corrupt, 42));
+}
@@ -0,0 +1,58 @@
+#include "test_common.h"
+#include "code_document.h"
+#include "document_edit.h"
+#include "file_utils.h"
+#include <string>
+
+static std::string line_at(const CodeDocument& doc, int line) {
+    std::string scratch;
+    return std::string(line_text(doc, line, scratch));
+}
+
+void test_line_index() {
+    {
+        CodeDocument doc("t.txt", "t.txt", make_text_buffer("first\nsecond\r\n\nlast"));
+        process_code(doc);
+        CHECK(document_line_count(doc) == 4);
+        CHECK(line_start_offset(doc, 1) == 6);
+        CHECK(line_at(doc, 0) == "first");
+        CHECK(line_at(doc, 1) == "second\r");
+        CHECK(line_at(doc, 2) == "");
+        CHECK(line_at(doc, 3) == "last");
+        CHECK(line_from_offset(doc, 0) == 0);
+        CHECK(line_from_offset(doc, 5) == 0);
+        CHECK(line_from_offset(doc, 6) == 1);
+        CHECK(line_from_offset(doc, doc.content.size() - 1) == 3);
+    }
+    {
+        // A trailing newline ends the last line instead of starting another.
+        CodeDocument doc("t.txt", "t.txt", make_text_buffer("a\nb\n"));
+        process_code(doc);
+        CHECK(document_line_count(doc) == 2);
+        CHECK(line_at(doc, 1) == "b");
+    }
+    {
+        CodeDocument doc;
+        process_code(doc);
+        CHECK(document_line_count(doc) == 1);
+        CHECK(line_at(doc, 0) == "");
+    }
+    {
+        // Edits move the document onto a piece table, which must answer line
+        // queries the same way as an index rebuilt from the flattened text.
+        CodeDocument doc("t.txt", "t.txt", make_text_buffer("one\ntwo\nthree\n"));
+        process_code(doc);
+        CHECK(insert_text(doc, 4, "inserted\n"));
+        CHECK(erase_text(doc, 0, 4));
+        CHECK(document_line_count(doc) == 3);
+        CHECK(line_at(doc, 0) == "inserted");
+        CHECK(line_at(doc, 2) == "three");
+        CHECK(line_from_offset(doc, 9) == 1);
+
+        CodeDocument fresh("t.txt", "t.txt", document_text(doc));
+        process_code(fresh);
+        process_code(doc);
+        CHECK(doc.lineOffsets == fresh.lineOffsets);
+        CHECK(doc.content == "inserted\ntwo\nthree\n");
+    }
+}
@@ -0,0 +1,37 @@
+#include "test_common.h"
+#include <cstring>
+
+int g_test_failures = 0;
+
+struct TestSuite {
+    const char* name;
+    void (*run)();
+};
+
+static const TestSuite s_suites[] = {
+    { "text_buffer", test_text_buffer },
+    { "line_index", test_line_index },
+    { "edit", test_edit },
+    { "reload", test_reload },
+    { "lexer", test_lexer },
+    { "strip", test_strip },
+    { "search", test_search },
+    { "scheduler", test_scheduler },
+};
+
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    bool found = false;
+    for (const TestSuite& suite : s_suites) {
+        if (only && strcmp(only, suite.name) != 0) continue;
+        found = true;
+        int before = g_test_failures;
+        suite.run();
+        printf("%-12s %s\n", suite.name, g_test_failures == before ? "ok" : "FAILED");
+    }
+    if (!found) {
+        fprintf(stderr, "unknown suite '%s'\n", only);
+        return 2;
+    }
+    return g_test_failures == 0 ? 0 : 1;
+}
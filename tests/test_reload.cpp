@@ -0,0 +1,82 @@
+#include "test_common.h"
+#include "code_document.h"
+#include "code_lexer.h"
+#include "document_loader.h"
+#include "file_utils.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+static void write_file(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(text.data(), (std::streamsize)text.size());
+}
+
+// The size and mtime shortcut is dropped first so a same-size rewrite within
+// the filesystem's timestamp granularity still goes through the splice.
+static bool reload_and_wait(CodeDocument& doc, std::string& error) {
+    doc.diskSnapshot.reset();
+    BeginReloadDocument(doc);
+    bool applied = false;
+    while (doc.reloadJob) {
+        applied = UpdateReload(doc, error);
+        if (doc.reloadJob) std::this_thread::yield();
+    }
+    return applied;
+}
+
+// Compares the incrementally spliced line index against a full rebuild.
+static bool index_matches_rebuild(const CodeDocument& doc) {
+    CodeDocument fresh(doc.filePath, doc.fileName, doc.source);
+    process_code(fresh);
+    return fresh.lineOffsets == doc.lineOffsets;
+}
+
+void test_reload() {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "codeviewer_test_reload.cpp";
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        text += "int value" + std::to_string(i) + " = compute(" + std::to_string(i * 3) + ");\n";
+    }
+    write_file(path, text);
+
+    CodeDocument doc(path.string(), "codeviewer_test_reload.cpp");
+    doc.language = detect_lang(doc.fileName);
+    std::string error;
+    CHECK(load_file_buffer(path.string().c_str(), doc.source, error));
+    doc.content = doc.source->view();
+    process_code(doc);
+    lex_document(doc);
+
+    struct Change {
+        size_t offset;
+        size_t erase;
+        const char* insert;
+    };
+    const Change changes[] = {
+        { text.size(), 0, "int appended = 1;\n" },
+        { text.size() / 2, 4, "/* regenerated */" },
+        { text.size() / 3, 5, "12345" },
+        { 10, 0, "#define GENERATED 1\n" },
+        { 0, 0, "\n\n" },
+        { text.size() / 4, 0, "/* opened\n" },
+        { 0, text.size() / 2, "" },
+    };
+    for (const Change& change : changes) {
+        text.replace(std::min(change.offset, text.size()), change.erase, change.insert);
+        write_file(path, text);
+        CHECK(reload_and_wait(doc, error));
+        CHECK(error.empty());
+        CHECK(doc.content == text);
+        CHECK(index_matches_rebuild(doc));
+    }
+
+    // Rewriting identical bytes reads the file but leaves the document alone.
+    write_file(path, text);
+    CHECK(!reload_and_wait(doc, error));
+    CHECK(doc.content == text);
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
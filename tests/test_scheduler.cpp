@@ -0,0 +1,140 @@
+#include "test_common.h"
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+struct ScriptedRequest {
+    double time;
+    unsigned reasons;
+    double delay;
+};
+
+// Drives the policy with a simulated 60 Hz clock: waits jump straight to the
+// next due frame or scripted event, so a minute of idle time costs nothing
+// and frame counts are exact.
+static int simulate_frames(FramePolicy& policy, const std::vector<ScriptedRequest>& script, double duration,
+    double animation_until = 0.0, double animation_interval = 0.0)
+{
+    const double vsync = 1.0 / 60.0;
+    size_t next = 0;
+    int frames = 0;
+    double now = 0.0;
+    while (now < duration) {
+        double delay = policy.next_frame_delay(now);
+        double event_time = next < script.size() ? script[next].time : duration;
+        if (delay < 0.0 || now + delay > event_time) {
+            now = std::max(now, event_time);
+            if (next < script.size()) {
+                policy.on_request(script[next].reasons, now, script[next].delay);
+                next++;
+            }
+            continue;
+        }
+        now += delay;
+        // Building the frame; animated widgets ask for their next tick.
+        frames++;
+        policy.on_frame_started(now);
+        if (now < animation_until) policy.on_request(FrameReason_Animation, now, animation_interval);
+        now += vsync;
+    }
+    return frames;
+}
+
+void test_scheduler() {
+    {
+        EventFramePolicy policy;
+        CHECK(policy.next_frame_delay(0.0) < 0.0);
+        CHECK(policy.next_frame_delay(1000.0) < 0.0);
+    }
+    {
+        // Input keeps frames due for the whole active window, then goes idle.
+        EventFramePolicy policy(0.5, 2);
+        policy.on_request(FrameReason_Input, 1.0, 0.0);
+        policy.on_frame_started(1.0);
+        policy.on_frame_started(1.1);
+        policy.on_frame_started(1.2);
+        CHECK(policy.next_frame_delay(1.2) == 0.0);
+        CHECK(policy.next_frame_delay(1.49) == 0.0);
+        CHECK(policy.next_frame_delay(1.5) < 0.0);
+    }
+    {
+        // An immediate request without input gets exactly the settle frames.
+        EventFramePolicy policy(0.5, 2);
+        policy.on_request(FrameReason_Job, 1.0, 0.0);
+        CHECK(policy.next_frame_delay(1.0) == 0.0);
+        policy.on_frame_started(1.0);
+        CHECK(policy.next_frame_delay(1.02) == 0.0);
+        policy.on_frame_started(1.02);
+        CHECK(policy.next_frame_delay(1.04) < 0.0);
+    }
+    {
+        // A delayed tick is due once, at its time, and is not repeated.
+        EventFramePolicy policy(0.5, 2);
+        policy.on_request(FrameReason_Animation, 1.0, 0.25);
+        CHECK(policy.next_frame_delay(1.0) == 0.25);
+        CHECK(policy.next_frame_delay(1.2) > 0.0);
+        CHECK(policy.next_frame_delay(1.3) == 0.0);
+        policy.on_frame_started(1.3);
+        CHECK(policy.next_frame_delay(1.3) < 0.0);
+        CHECK(policy.next_frame_delay(5.0) < 0.0);
+    }
+    {
+        // A frame started before the tick is due leaves the tick pending.
+        EventFramePolicy policy(0.5, 2);
+        policy.on_request(FrameReason_Animation, 1.0, 0.25);
+        policy.on_frame_started(1.1);
+        CHECK(policy.next_frame_delay(1.1) > 0.0);
+    }
+
+    EventFramePolicy idle;
+    CHECK(simulate_frames(idle, {}, 60.0) == 0);
+
+    // The active window is 0.5 s of vsync frames, plus the settle frames.
+    EventFramePolicy one_input;
+    int frames = simulate_frames(one_input, { { 1.0, FrameReason_Input, 0.0 } }, 60.0);
+    CHECK(frames >= 30 && frames <= 33);
+
+    EventFramePolicy events;
+    CHECK(simulate_frames(events, { { 5.0, FrameReason_Job, 0.0 }, { 20.0, FrameReason_FileChange, 0.0 } }, 60.0) == 4);
+
+    // A progress bar for 2 s asks for a frame every 100 ms.
+    EventFramePolicy progress;
+    frames = simulate_frames(progress, { { 1.0, FrameReason_Job, 0.0 } }, 60.0, 3.0, PROGRESS_FRAME_INTERVAL);
+    CHECK(frames >= 18 && frames <= 24);
+
+    // Typing: one key every 200 ms for 10 s keeps the loop active throughout.
+    EventFramePolicy typing;
+    std::vector<ScriptedRequest> script;
+    for (int i = 0; i < 50; ++i) script.push_back({ 1.0 + i * 0.2, FrameReason_Input, 0.0 });
+    frames = simulate_frames(typing, script, 60.0);
+    CHECK(frames >= 590 && frames <= 640);
+
+    // Clearing the global scheduler waits for requests already inside it, so
+    // no worker calls the wake function once the scheduler is gone.
+    std::atomic<bool> alive{ true };
+    std::atomic<bool> late_wake{ false };
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> workers;
+    {
+        FrameScheduler scheduler(std::unique_ptr<FramePolicy>(new EventFramePolicy()), [&]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            if (!alive) late_wake = true;
+        });
+        set_frame_scheduler(&scheduler);
+        for (int i = 0; i < 4; ++i) {
+            workers.emplace_back([&]() {
+                while (!stop) request_frame(FrameReason_Job);
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        set_frame_scheduler(nullptr);
+        alive = false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    stop = true;
+    for (std::thread& worker : workers) worker.join();
+    CHECK(!late_wake);
+}
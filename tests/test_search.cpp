@@ -0,0 +1,104 @@
+#include "test_common.h"
+#include "code_document.h"
+#include "code_search.h"
+#include "file_utils.h"
+#include "find_in_files.h"
+#include "regex_dfa.h"
+#include "search_kernel.h"
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::vector<size_t> find_literal(const std::string& text, const char* needle, bool case_sensitive) {
+    std::vector<size_t> matches;
+    search_literal(text.data(), text.size(), 0, text.size(), needle, strlen(needle), case_sensitive, matches);
+    return matches;
+}
+
+static void wait_for_search(CodeDocument& doc) {
+    while (UpdateSearch(doc)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void test_search() {
+    std::string text = "Foo foo FOO fo foofoo";
+    CHECK(find_literal(text, "foo", true) == std::vector<size_t>({ 4, 15, 18 }));
+    CHECK(find_literal(text, "foo", false) == std::vector<size_t>({ 0, 4, 8, 15, 18 }));
+    CHECK(find_literal(text, "bar", false).empty());
+    CHECK(find_literal("aaaa", "aa", true) == std::vector<size_t>({ 0, 2 }));
+
+    // Chunked scans resume where the previous chunk stopped and still find
+    // matches that straddle the chunk boundary.
+    std::string long_text(100000, 'x');
+    long_text.replace(49998, 6, "needle");
+    long_text.replace(99994, 6, "needle");
+    std::vector<size_t> chunked;
+    size_t pos = 0;
+    while (pos < long_text.size()) {
+        pos = search_literal(long_text.data(), long_text.size(), pos, std::min(long_text.size(), pos + 50000),
+            "needle", 6, true, chunked);
+    }
+    CHECK(chunked == std::vector<size_t>({ 49998, 99994 }));
+
+    RegexMatcher regex;
+    std::string error;
+    CHECK(regex.compile("TODO\\(\\w+\\)", true, error));
+    std::string code = "// TODO(ann) one\nint x; // TODO() no\n// TODO(bob)\n";
+    std::vector<size_t> positions;
+    std::vector<uint32_t> lengths;
+    regex.find_all(code.data(), code.size(), 0, code.size(), positions, lengths);
+    CHECK(positions == std::vector<size_t>({ 3, 40 }));
+    CHECK(lengths == std::vector<uint32_t>({ 9, 9 }));
+
+    RegexMatcher anchored;
+    CHECK(anchored.compile("^int", false, error));
+    positions.clear();
+    lengths.clear();
+    anchored.find_all(code.data(), code.size(), 0, code.size(), positions, lengths);
+    CHECK(positions == std::vector<size_t>({ 17 }));
+
+    RegexMatcher broken;
+    CHECK(!broken.compile("(unclosed", true, error));
+    CHECK(!error.empty());
+
+    // Document search runs on a worker and reports match lines.
+    CodeDocument doc("t.cpp", "t.cpp", make_text_buffer(code));
+    process_code(doc);
+    strcpy(doc.searchState.query, "todo");
+    PerformSearch(doc);
+    wait_for_search(doc);
+    CHECK(doc.searchState.matchPositions == std::vector<size_t>({ 3, 27, 40 }));
+    CHECK(doc.searchState.matchLines == std::vector<int>({ 0, 1, 2 }));
+
+    doc.searchState.caseSensitive = true;
+    doc.searchState.useRegex = true;
+    strcpy(doc.searchState.query, "TODO\\(\\w+\\)");
+    PerformSearch(doc);
+    wait_for_search(doc);
+    CHECK(doc.searchState.matchLines == std::vector<int>({ 0, 2 }));
+
+    // Find in files reports line, column and a preview that contains the
+    // match even far into a long minified line.
+    FindInFilesSource source;
+    source.path = "min.js";
+    source.buffer = make_text_buffer("a\n" + std::string(5000, 'x') + "hit" + std::string(5000, 'y') + "hit\n");
+    source.text = source.buffer->view();
+    FindInFilesOptions options;
+    options.query = "hit";
+    options.openDocuments.push_back(source);
+    std::shared_ptr<FindInFilesJob> job = start_find_in_files(options, error);
+    CHECK(job != nullptr);
+    while (job && !job->finished) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(job && job->pendingResults.size() == 1);
+    if (job && job->pendingResults.size() == 1) {
+        const std::vector<FindInFilesMatch>& matches = job->pendingResults[0].matches;
+        CHECK(matches.size() == 2);
+        CHECK(matches[0].line == 2 && matches[0].column == 5001);
+        CHECK(matches[1].line == 2 && matches[1].column == 10004);
+        for (const FindInFilesMatch& match : matches) {
+            CHECK(match.preview.size() <= 200);
+            CHECK(match.preview.find("hit") != std::string::npos);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#include "test_common.h"
+#include "code_document.h"
+#include "file_utils.h"
+#include "language_registry.h"
+#include <string>
+
+static std::string strip(const char* code, const char* language) {
+    std::string out;
+    strip_comments(code, languages().find_by_id(language), out);
+    return out;
+}
+
+void test_strip() {
+    // Removed comments take the whitespace before them; lines left empty go.
+    CHECK(strip("int a; // tail\n// whole line\nint b;\n", "cpp") == "int a;\nint b;\n");
+    CHECK(strip("a /* x */ b\nc /* open\nstill\nclose */ d\n", "cpp") == "a  b\nc\n d\n");
+    CHECK(strip("x = 1  # note\n# only\ny = 2\n", "python") == "x = 1\ny = 2\n");
+    CHECK(strip("p { color: red; } /* c */\n", "css") == "p { color: red; }\n");
+    CHECK(strip("no comments here", "cpp") == "no comments here\n");
+
+    // The comment-stripped view maps its lines back to the original ones and
+    // searches only what is shown.
+    CodeDocument doc("t.cpp", "t.cpp", make_text_buffer("// header\nint a;\n/* b\n c */\nint d; // e\n"));
+    doc.language = languages().find_by_id("cpp");
+    process_code(doc);
+    doc.showComments = false;
+    process_code(doc);
+    CHECK(doc.strippedView);
+    CHECK(document_line_count(doc) == 2);
+    std::string scratch;
+    CHECK(line_text(doc, 0, scratch) == "int a;");
+    CHECK(line_text(doc, 1, scratch) == "int d;");
+    CHECK(original_line(doc, 0) == 1);
+    CHECK(original_line(doc, 1) == 4);
+    CHECK(line_from_original(doc, 4) == 1);
+    CHECK(max_line_number(doc) == 5);
+
+    doc.showComments = true;
+    process_code(doc);
+    CHECK(!doc.strippedView);
+    CHECK(document_line_count(doc) == 5);
+}
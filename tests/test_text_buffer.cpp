@@ -0,0 +1,44 @@
+#include "test_common.h"
+#include "file_utils.h"
+#include "text_buffer.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+static void write_file(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(text.data(), (std::streamsize)text.size());
+}
+
+void test_text_buffer() {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "codeviewer_test_text_buffer.txt";
+    std::string text(5 * 1024 * 1024, 'x');
+    for (size_t i = 0; i < text.size(); i += 80) text[i] = '\n';
+
+    write_file(path, "small\n");
+    TextBufferPtr small;
+    std::string error;
+    CHECK(load_file_buffer(path.string().c_str(), small, error));
+    CHECK(!small->is_mapped());
+    CHECK(small->view() == "small\n");
+
+    write_file(path, text);
+    TextBufferPtr buffer;
+    CHECK(load_file_buffer(path.string().c_str(), buffer, error));
+    CHECK(buffer->view() == text);
+#ifndef _WIN32
+    CHECK(buffer->is_mapped());
+
+    // Truncating the mapped file must not fault readers: the pages past the
+    // new end read as zeros until a reload replaces the buffer.
+    std::filesystem::resize_file(path, 1000);
+    CHECK(buffer->size() == text.size());
+    CHECK(buffer->data()[10] == text[10]);
+    CHECK(buffer->data()[4 * 1024 * 1024] == '\0');
+    CHECK(buffer->data()[text.size() - 1] == '\0');
+#endif
+    buffer.reset();
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
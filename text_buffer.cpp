@@ -0,0 +1,165 @@
+#include "text_buffer.h"
+
+#ifndef _WIN32
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+TextBuffer::TextBuffer(std::string owned)
+    : owned_(std::move(owned))
+{
+    data_ = owned_.data();
+    size_ = owned_.size();
+}
+
+TextBuffer::~TextBuffer() {
+    unmap();
+}
+
+#ifdef _WIN32
+
+void TextBuffer::unmap() {
+}
+
+bool TextBuffer::maps_file(const char*) const {
+    return false;
+}
+
+#else
+
+// Live mappings are kept in a fixed table the SIGBUS handler can scan without
+// locking. A slot is claimed by moving its begin from 0 to 1, which no fault
+// address can match, and published once its end is stored.
+const int MAX_GUARDED_MAPPINGS = 256;
+
+static std::atomic<uintptr_t> s_guard_begin[MAX_GUARDED_MAPPINGS];
+static std::atomic<uintptr_t> s_guard_end[MAX_GUARDED_MAPPINGS];
+static struct sigaction s_previous_sigbus;
+static uintptr_t s_page_size = 4096;
+
+// A read past the end of a truncated mapping: map a zero page over the
+// faulting page and retry the read. Other faults go to whoever handled SIGBUS
+// before, or kill the process as they would have without us.
+static void guard_sigbus(int sig, siginfo_t* info, void* context) {
+    uintptr_t address = (uintptr_t)info->si_addr;
+    for (int i = 0; i < MAX_GUARDED_MAPPINGS; ++i) {
+        uintptr_t begin = s_guard_begin[i].load(std::memory_order_acquire);
+        if (begin <= 1 || address < begin || address >= s_guard_end[i].load(std::memory_order_relaxed)) continue;
+        void* page = (void*)(address & ~(s_page_size - 1));
+        if (mmap(page, s_page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED) return;
+        break;
+    }
+    if (s_previous_sigbus.sa_flags & SA_SIGINFO) {
+        if (s_previous_sigbus.sa_sigaction) {
+            s_previous_sigbus.sa_sigaction(sig, info, context);
+            return;
+        }
+    }
+    else if (s_previous_sigbus.sa_handler != SIG_DFL && s_previous_sigbus.sa_handler != SIG_IGN) {
+        s_previous_sigbus.sa_handler(sig);
+        return;
+    }
+    signal(SIGBUS, SIG_DFL);
+}
+
+static void install_sigbus_guard() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        long page_size = sysconf(_SC_PAGESIZE);
+        if (page_size > 0) s_page_size = (uintptr_t)page_size;
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = guard_sigbus;
+        action.sa_flags = SA_SIGINFO | SA_NODEFER;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGBUS, &action, &s_previous_sigbus);
+    });
+}
+
+static int register_guard(const void* base, size_t length) {
+    install_sigbus_guard();
+    for (int i = 0; i < MAX_GUARDED_MAPPINGS; ++i) {
+        uintptr_t expected = 0;
+        if (!s_guard_begin[i].compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) continue;
+        s_guard_end[i].store((uintptr_t)base + length, std::memory_order_relaxed);
+        s_guard_begin[i].store((uintptr_t)base, std::memory_order_release);
+        return i;
+    }
+    return -1;
+}
+
+void TextBuffer::unmap() {
+    if (!mapBase_) return;
+    s_guard_begin[guardSlot_].store(0, std::memory_order_release);
+    munmap(mapBase_, size_);
+    mapBase_ = nullptr;
+    guardSlot_ = -1;
+    data_ = "";
+    size_ = 0;
+}
+
+bool TextBuffer::map_file(const char* path, std::string& error_out) {
+    unmap();
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_out = std::string("Cannot open file: ") + strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0 || (unsigned long long)st.st_size > SIZE_MAX) {
+        ::close(fd);
+        error_out = "File size is invalid.";
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    size_t len = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        error_out = std::string("Cannot map file into memory: ") + strerror(errno);
+        return false;
+    }
+    int slot = register_guard(base, len);
+    if (slot < 0) {
+        munmap(base, len);
+        error_out = "Too many mapped files.";
+        return false;
+    }
+
+    mapBase_ = base;
+    guardSlot_ = slot;
+    fileDevice_ = (unsigned long long)st.st_dev;
+    fileInode_ = (unsigned long long)st.st_ino;
+    data_ = static_cast<const char*>(base);
+    size_ = len;
+    return true;
+}
+
+bool TextBuffer::maps_file(const char* path) const {
+    struct stat st;
+    if (!mapBase_ || stat(path, &st) != 0) return false;
+    return (unsigned long long)st.st_dev == fileDevice_ && (unsigned long long)st.st_ino == fileInode_;
+}
+
+#endif
+
+TextBufferPtr make_text_buffer(std::string owned) {
+    return std::make_shared<const TextBuffer>(std::move(owned));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Immutable document bytes shared between the document, its search jobs and
+// exports: either an owned copy or, for large files on POSIX, a read-only
+// mapping. Mapped ranges are guarded so that a generator truncating the file
+// while it is open makes readers see NULs past the new end instead of
+// raising SIGBUS; the file watcher's reload then replaces the buffer.
+// Windows always reads an owned copy, since an open section would make the
+// writer's truncate fail.
+class TextBuffer {
+public:
+    TextBuffer() = default;
+    explicit TextBuffer(std::string owned);
+    ~TextBuffer();
+
+    TextBuffer(const TextBuffer&) = delete;
+    TextBuffer& operator=(const TextBuffer&) = delete;
+
+#ifndef _WIN32
+    bool map_file(const char* path, std::string& error_out);
+#endif
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+    bool is_mapped() const { return mapBase_ != nullptr; }
+    // True when this buffer maps the file now at `path`, so the bytes change
+    // if the file is rewritten in place.
+    bool maps_file(const char* path) const;
+
+private:
+    void unmap();
+
+    std::string owned_;
+    const char* data_ = "";
+    size_t size_ = 0;
+    void* mapBase_ = nullptr;
+    int guardSlot_ = -1;
+    unsigned long long fileDevice_ = 0;
+    unsigned long long fileInode_ = 0;
+};
+
+typedef std::shared_ptr<const TextBuffer> TextBufferPtr;
+
+TextBufferPtr make_text_buffer(std::string owned);
@@ -1,42 +1,31 @@
 #include "ui_addons.h"
 #include "code_editor.h"
 #include "file_utils.h"
+#include "code_search.h"
+#include "find_in_files.h"
+#include "document_loader.h"
+#include "document_edit.h"
+#include "language_registry.h"
+#include "profiler.h"
+#include "frame_scheduler.h"
+#include "tinyfiledialogs.h"
 #include "imgui.h"
 #include <algorithm>
 #include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <unordered_map>
 
 std::vector<std::string> g_dropped_files_queue;
 
-void PerformSearch(CodeDocument& doc) {
-    doc.searchState.matchPositions.clear();
-    doc.searchState.currentMatch = -1;
-    if (strlen(doc.searchState.query) == 0) {
-        return;
-    }
-
-    const std::string& content = doc.processedContent;
-    std::string query = doc.searchState.query;
-
-    std::string content_to_search = content;
-    if (!doc.searchState.caseSensitive) {
-        std::transform(content_to_search.begin(), content_to_search.end(), content_to_search.begin(),
-            [](unsigned char c) { return std::tolower(c); });
-        std::transform(query.begin(), query.end(), query.begin(),
-            [](unsigned char c) { return std::tolower(c); });
-    }
-
-    size_t start_pos = 0;
-    while ((start_pos = content_to_search.find(query, start_pos)) != std::string::npos) {
-        doc.searchState.matchPositions.push_back(start_pos);
-        start_pos += query.length();
-    }
-}
-
 void ShowCodeEditorAddons(CodeDocument& doc, int line_count) {
     ImGuiIO& io = ImGui::GetIO();
     float line_height = ImGui::GetTextLineHeightWithSpacing();
 
-    if (io.KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_F, false)) {
+    if (io.KeyCtrl && !io.KeyShift && ImGui::IsKeyPressed(ImGuiKey_F, false)) {
         doc.searchState.active = !doc.searchState.active;
         if (doc.searchState.active) {
             ImGui::SetKeyboardFocusHere();
@@ -54,10 +43,25 @@ void ShowCodeEditorAddons(CodeDocument& doc, int line_count) {
         if (ImGui::Checkbox("Case Sensitive", &doc.searchState.caseSensitive)) {
             PerformSearch(doc);
         }
+        ImGui::SameLine();
+        if (ImGui::Checkbox("Regex", &doc.searchState.useRegex)) {
+            PerformSearch(doc);
+        }
+        if (!doc.searchState.regexError.empty()) {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(0.90f, 0.35f, 0.35f, 1.0f), "%s", doc.searchState.regexError.c_str());
+        }
 
-        if (!doc.searchState.matchPositions.empty()) {
+        if (SearchJob* job = doc.searchState.job.get()) {
+            int percent = job->bytesTotal ? (int)(100.0 * (double)job->bytesScanned.load() / (double)job->bytesTotal) : 100;
             ImGui::SameLine();
-            ImGui::Text("%d / %d", doc.searchState.currentMatch + 1, (int)doc.searchState.matchPositions.size());
+            ImGui::Text("Searching... %d matches so far (%d%%)", (int)doc.searchState.matchPositions.size(), percent);
+        }
+        if (!doc.searchState.matchPositions.empty()) {
+            if (!doc.searchState.job) {
+                ImGui::SameLine();
+                ImGui::Text("%d / %d", doc.searchState.currentMatch + 1, (int)doc.searchState.matchPositions.size());
+            }
             ImGui::SameLine();
             if (ImGui::ArrowButton("##PrevMatch", ImGuiDir_Up)) {
                 doc.searchState.currentMatch = (doc.searchState.currentMatch - 1 + doc.searchState.matchPositions.size()) % doc.searchState.matchPositions.size();
@@ -77,10 +81,11 @@ void ShowCodeEditorAddons(CodeDocument& doc, int line_count) {
     }
     if (ImGui::BeginPopupModal("Go to Line", NULL, ImGuiWindowFlags_AlwaysAutoResize)) {
         static int line_to_go = 1;
-        ImGui::Text("Enter line number (1-%d):", line_count);
+        int last_line = max_line_number(doc);
+        ImGui::Text("Enter line number (1-%d):", last_line);
         ImGui::PushItemWidth(150);
         if (ImGui::InputInt("##linenum", &line_to_go, 1, 10, ImGuiInputTextFlags_EnterReturnsTrue) || ImGui::Button("Go", ImVec2(120, 0))) {
-            doc.searchState.lineToScrollTo = std::max(1, std::min(line_to_go, line_count));
+            doc.searchState.lineToScrollTo = std::max(1, std::min(line_to_go, last_line));
             doc.searchState.scrollToMatch = true; 
             ImGui::CloseCurrentPopup();
         }
@@ -95,46 +100,275 @@ void ShowCodeEditorAddons(CodeDocument& doc, int line_count) {
     ImGui::Separator();
     float scroll_y = ImGui::GetScrollY();
     int current_line = static_cast<int>(scroll_y / line_height) + 1;
-    const char* lang_str = "Plain Text";
-    switch (doc.language) {
-    case 0: lang_str = "C++"; break;
-    case 1: lang_str = "Python"; break;
-    case 2: lang_str = "HTML"; break;
-    case 3: lang_str = "CSS"; break;
-    case 4: lang_str = "JavaScript"; break;
-    }
-    ImGui::Text("Line %d / %d", current_line, line_count);
+    current_line = original_line(doc, std::min(current_line, line_count) - 1) + 1;
+    ImGui::Text("Line %d / %d", current_line, max_line_number(doc));
     ImGui::SameLine(ImGui::GetContentRegionAvail().x - 150);
-    ImGui::Text("Language: %s", lang_str);
+    ImGui::Text("Language: %s", language_name(doc.language));
+}
+
+static std::string document_key(const std::string& path) {
+    return std::filesystem::path(path).lexically_normal().string();
+}
+
+int OpenDocuments(std::vector<CodeDocument>& docs, const std::vector<std::string>& paths, int& active_doc_idx) {
+    std::unordered_map<std::string, int> open_paths;
+    open_paths.reserve(docs.size() + paths.size());
+    for (int i = 0; i < (int)docs.size(); ++i) {
+        if (docs[i].open) open_paths.emplace(document_key(docs[i].filePath), i);
+    }
+
+    int doc_idx = -1;
+    for (const std::string& path : paths) {
+        auto inserted = open_paths.emplace(document_key(path), (int)docs.size());
+        doc_idx = inserted.first->second;
+        if (inserted.second) {
+            std::string name_str = path.substr(path.find_last_of("/\\") + 1);
+            docs.emplace_back(path, name_str);
+            docs.back().language = detect_lang(name_str);
+            BeginLoadDocument(docs.back());
+        }
+    }
+    if (doc_idx >= 0) {
+        docs[doc_idx].selectTab = true;
+        active_doc_idx = doc_idx;
+    }
+    return doc_idx;
 }
 
 void HandleDroppedFiles(std::vector<CodeDocument>& docs, int& active_doc_idx) {
     if (g_dropped_files_queue.empty()) {
         return;
     }
+    OpenDocuments(docs, g_dropped_files_queue, active_doc_idx);
+    g_dropped_files_queue.clear();
+}
 
-    for (const auto& path : g_dropped_files_queue) {
-        std::string content_str;
-        if (load_file_str(path.c_str(), content_str)) {
-            std::string name_str = path.substr(path.find_last_of("/\\") + 1);
+struct FindInFilesPanelState {
+    char query[256] = "";
+    char directory[1024] = "";
+    bool caseSensitive = false;
+    bool useRegex = false;
+    bool includeDirectory = false;
+    std::shared_ptr<FindInFilesJob> job;
+    std::vector<FindInFilesResult> results;
+    size_t matchCount = 0;
+    std::string error;
+};
+
+static void open_document_at_line(std::vector<CodeDocument>& docs, int& active_doc_idx, const std::string& path, int line) {
+    int doc_idx = OpenDocuments(docs, std::vector<std::string>{ path }, active_doc_idx);
+    CodeDocument& doc = docs[doc_idx];
+    doc.searchState.lineToScrollTo = line;
+    doc.searchState.scrollToMatch = true;
+}
+
+static void start_panel_search(FindInFilesPanelState& state, std::vector<CodeDocument>& docs) {
+    state.job.reset();
+    state.results.clear();
+    state.matchCount = 0;
+    state.error.clear();
 
-            bool already_open = false;
-            for (int i = 0; i < docs.size(); ++i) {
-                if (docs[i].filePath == path) {
-                    active_doc_idx = i;
-                    already_open = true;
-                    break;
+    FindInFilesOptions options;
+    options.query = state.query;
+    options.caseSensitive = state.caseSensitive;
+    options.useRegex = state.useRegex;
+    if (state.includeDirectory) {
+        options.directory = state.directory;
+    }
+    for (const CodeDocument& doc : docs) {
+        if (!doc.open || doc.loadJob) continue;
+        FindInFilesSource source;
+        source.path = doc.filePath;
+        source.buffer = document_text(doc);
+        source.text = source.buffer->view();
+        options.openDocuments.push_back(std::move(source));
+    }
+
+    state.job = start_find_in_files(std::move(options), state.error);
+}
+
+void ShowFindInFilesPanel(bool* p_open, std::vector<CodeDocument>& docs, int& active_doc_idx) {
+    if (p_open && !*p_open) {
+        return;
+    }
+
+    static FindInFilesPanelState state;
+
+    if (FindInFilesJob* job = state.job.get()) {
+        bool finished = job->finished.load();
+        std::lock_guard<std::mutex> lock(job->resultsMutex);
+        for (FindInFilesResult& result : job->pendingResults) {
+            state.matchCount += result.matches.size();
+            state.results.push_back(std::move(result));
+        }
+        job->pendingResults.clear();
+        if (finished) {
+            std::sort(state.results.begin(), state.results.end(),
+                [](const FindInFilesResult& a, const FindInFilesResult& b) { return a.path < b.path; });
+        }
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(700, 450), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Find in Files", p_open)) {
+        ImGui::End();
+        return;
+    }
+
+    bool submit = false;
+    ImGui::PushItemWidth(300.0f);
+    submit |= ImGui::InputTextWithHint("##FindInFilesQuery", "Find in files", state.query, sizeof(state.query), ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::PopItemWidth();
+    ImGui::SameLine();
+    ImGui::Checkbox("Case Sensitive", &state.caseSensitive);
+    ImGui::SameLine();
+    ImGui::Checkbox("Regex", &state.useRegex);
+
+    ImGui::Checkbox("Include folder", &state.includeDirectory);
+    ImGui::SameLine();
+    ImGui::PushItemWidth(300.0f);
+    ImGui::InputText("##FindInFilesDirectory", state.directory, sizeof(state.directory));
+    ImGui::PopItemWidth();
+    ImGui::SameLine();
+    if (ImGui::Button("Browse...")) {
+        const char* folder = tinyfd_selectFolderDialog("Search Folder", state.directory);
+        if (folder != NULL) {
+            snprintf(state.directory, sizeof(state.directory), "%s", folder);
+            state.includeDirectory = true;
+        }
+    }
+
+    submit |= ImGui::Button("Search");
+    if (submit && state.query[0] != '\0') {
+        start_panel_search(state, docs);
+    }
+    ImGui::SameLine();
+    if (state.job && !state.job->finished) {
+        request_frame(FrameReason_Animation, PROGRESS_FRAME_INTERVAL);
+        ImGui::Text("Searching... %d files, %d matches", (int)state.job->filesSearched.load(), (int)state.matchCount);
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            state.job.reset();
+        }
+    }
+    else if (state.job) {
+        ImGui::Text("%d matches in %d files (%d files searched, %d skipped)", (int)state.matchCount, (int)state.results.size(),
+            (int)state.job->filesSearched.load(), (int)state.job->filesSkipped.load());
+    }
+    if (!state.error.empty()) {
+        ImGui::TextColored(ImVec4(0.90f, 0.35f, 0.35f, 1.0f), "%s", state.error.c_str());
+    }
+
+    ImGui::Separator();
+    ImGui::BeginChild("FindInFilesResults", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+    for (size_t r = 0; r < state.results.size(); ++r) {
+        const FindInFilesResult& result = state.results[r];
+        ImGui::PushID((int)r);
+        if (ImGui::TreeNodeEx(result.path.c_str(), ImGuiTreeNodeFlags_DefaultOpen, "%s (%d)", result.path.c_str(), (int)result.matches.size())) {
+            ImGuiListClipper clipper;
+            clipper.Begin((int)result.matches.size());
+            while (clipper.Step()) {
+                for (int m = clipper.DisplayStart; m < clipper.DisplayEnd; ++m) {
+                    const FindInFilesMatch& match = result.matches[m];
+                    char label[64];
+                    snprintf(label, sizeof(label), "%d:%d##%d", match.line, match.column, m);
+                    if (ImGui::Selectable(label, false, ImGuiSelectableFlags_SpanAllColumns)) {
+                        open_document_at_line(docs, active_doc_idx, result.path, match.line);
+                    }
+                    ImGui::SameLine(90.0f);
+                    ImGui::TextUnformatted(match.preview.c_str(), match.preview.c_str() + match.preview.size());
                 }
             }
+            clipper.End();
+            ImGui::TreePop();
+        }
+        ImGui::PopID();
+    }
+    ImGui::EndChild();
 
-            if (!already_open) {
-                docs.emplace_back(path, name_str, content_str);
-                CodeDocument& new_doc = docs.back();
-                new_doc.language = detect_lang(name_str);
-                process_code(new_doc);
-                active_doc_idx = docs.size() - 1;
-            }
+    ImGui::End();
+}
+
+const int PROFILER_HISTORY_FRAMES = 120;
+
+struct ProfilerStageHistory {
+    float frameMs[PROFILER_HISTORY_FRAMES] = {};
+    double pendingMs = 0.0;
+};
+
+struct ProfilerOverlayState {
+    uint64_t cursor = 0;
+    int frame = 0;
+    std::vector<ProfileEvent> events;
+    std::map<std::string, ProfilerStageHistory> stages;
+    std::string error;
+};
+
+// Events are summed per stage until the next frame mark closes the frame, so
+// each histogram bar is the total time a stage took within one frame,
+// including work finished on background threads during it.
+static void collect_profile_events(ProfilerOverlayState& state) {
+    state.events.clear();
+    profiler_read(state.events, state.cursor);
+    for (const ProfileEvent& event : state.events) {
+        if (strcmp(event.name, "frame") != 0) {
+            state.stages[event.name].pendingMs += event.durationNs / 1e6;
+            continue;
+        }
+        int slot = state.frame++ % PROFILER_HISTORY_FRAMES;
+        state.stages["frame"].frameMs[slot] = (float)(event.durationNs / 1e6);
+        for (auto& entry : state.stages) {
+            if (entry.first == "frame") continue;
+            entry.second.frameMs[slot] = (float)entry.second.pendingMs;
+            entry.second.pendingMs = 0.0;
         }
     }
-    g_dropped_files_queue.clear();
+}
+
+void ShowProfilerOverlay(bool* p_open) {
+    static ProfilerOverlayState state;
+    // Draining every frame keeps the cursor close to the writers even while
+    // the overlay is hidden, so reopening it does not show a burst of stale data.
+    collect_profile_events(state);
+    if (p_open && !*p_open) {
+        return;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(420, 520), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", p_open)) {
+        ImGui::End();
+        return;
+    }
+
+    if (!profiler_enabled()) {
+        ImGui::TextDisabled("Profiler not compiled in (CODEVIEWER_ENABLE_PROFILER is OFF).");
+        ImGui::End();
+        return;
+    }
+
+    if (ImGui::Button("Save Chrome Trace...")) {
+        const char* filters[] = { "*.json" };
+        const char* save_path = tinyfd_saveFileDialog("Save Chrome Trace As...", "codeviewer_trace.json", 1, filters, "Trace JSON");
+        state.error.clear();
+        if (save_path && !profiler_write_chrome_trace(save_path, state.error)) {
+            tinyfd_messageBox("Save Error", ("Failed to write trace: " + state.error).c_str(), "ok", "error", 1);
+        }
+    }
+
+    int frames = std::min(state.frame, PROFILER_HISTORY_FRAMES);
+    int offset = state.frame > PROFILER_HISTORY_FRAMES ? state.frame % PROFILER_HISTORY_FRAMES : 0;
+    for (const auto& entry : state.stages) {
+        const ProfilerStageHistory& history = entry.second;
+        float total = 0.0f;
+        float peak = 0.0f;
+        for (int i = 0; i < frames; ++i) {
+            total += history.frameMs[i];
+            peak = std::max(peak, history.frameMs[i]);
+        }
+        float average = frames > 0 ? total / frames : 0.0f;
+        ImGui::Text("%-14s avg %7.3f ms  max %7.3f ms", entry.first.c_str(), average, peak);
+        ImGui::PlotHistogram(("##" + entry.first).c_str(), history.frameMs, frames, offset, NULL, 0.0f,
+            std::max(peak, 1.0f), ImVec2(-1.0f, 40.0f));
+    }
+
+    ImGui::End();
 }
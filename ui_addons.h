@@ -8,6 +8,11 @@ struct CodeDocument;
 
 extern std::vector<std::string> g_dropped_files_queue;
 
+int OpenDocuments(std::vector<CodeDocument>& docs, const std::vector<std::string>& paths, int& active_doc_idx);
 void HandleDroppedFiles(std::vector<CodeDocument>& docs, int& active_doc_idx);
 
 void ShowCodeEditorAddons(CodeDocument& doc, int line_count);
+
+void ShowFindInFilesPanel(bool* p_open, std::vector<CodeDocument>& docs, int& active_doc_idx);
+
+void ShowProfilerOverlay(bool* p_open);
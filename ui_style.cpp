@@ -97,3 +97,15 @@ void ApplyCodeViewerStyle()
     style.WindowMenuButtonPosition = ImGuiDir_Left;
     style.ButtonTextAlign   = ImVec2(0.5f, 0.5f); 
 }
+
+ImFont* LoadCodeViewerFonts()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    io.Fonts->AddFontDefault();
+    const char* firaCodePath = "C:/libs/fonts/Fira_Code_v6.2/ttf/FiraCode-Bold.ttf";
+    float fontSize = 14.0f;
+    ImFontConfig fontConfig;
+    fontConfig.OversampleH = 2;
+    fontConfig.OversampleV = 1;
+    return io.Fonts->AddFontFromFileTTF(firaCodePath, fontSize, &fontConfig, io.Fonts->GetGlyphRangesDefault());
+}
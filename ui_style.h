@@ -1,3 +1,6 @@
 #pragma once
 
+struct ImFont;
+
 void ApplyCodeViewerStyle();
+ImFont* LoadCodeViewerFonts();
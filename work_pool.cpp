@@ -0,0 +1,102 @@
+#include "work_pool.h"
+
+static thread_local const WorkStealingPool* t_current_pool = nullptr;
+static thread_local int t_current_worker = -1;
+
+WorkStealingPool::WorkStealingPool(int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = (int)std::thread::hardware_concurrency();
+    }
+    if (thread_count <= 0) {
+        thread_count = 1;
+    }
+
+    for (int i = 0; i < thread_count; ++i) {
+        queues_.emplace_back(new WorkerQueue());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        threads_.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : threads_) {
+        t.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    int target = t_current_pool == this ? t_current_worker : (int)(next_queue_++ % queues_.size());
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        outstanding_++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        queued_++;
+    }
+    wake_.notify_one();
+}
+
+void WorkStealingPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    idle_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+bool WorkStealingPool::try_pop(int worker, Task& task_out) {
+    {
+        WorkerQueue& own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task_out = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        WorkerQueue& victim = *queues_[(worker + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task_out = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::worker_loop(int worker) {
+    t_current_pool = this;
+    t_current_worker = worker;
+
+    // Pops happen under wake_mutex_, and submit counts a task only after it
+    // is queued, so a positive count always has a task behind it and a woken
+    // worker never comes back empty-handed to spin on the wait.
+    Task task;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (stopping_) return;
+            try_pop(worker, task);
+            queued_--;
+        }
+
+        task(worker);
+        task = nullptr;
+
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        if (--outstanding_ == 0) {
+            idle_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+    typedef std::function<void(int worker)> Task;
+
+    explicit WorkStealingPool(int thread_count = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int thread_count() const { return (int)threads_.size(); }
+
+    void submit(Task task);
+    void wait_idle();
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool try_pop(int worker, Task& task_out);
+    void worker_loop(int worker);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    size_t queued_ = 0;
+    size_t outstanding_ = 0;
+    std::atomic<unsigned> next_queue_{ 0 };
+    bool stopping_ = false;
+};